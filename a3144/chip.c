@@ -13,84 +13,886 @@
  * - Supply voltage: 4.5V to 24V
  * - Output type: Open-drain NPN (requires pull-up)
  * - Operating temperature: -40°C to +85°C
- * - Response time: Typically 3μs
+ * - Response time: Typically 3μs (modeled when responseNanos is set)
  */
 
-#include <stdio.h>
-#include <stdlib.h>
 #include "wokwi-api.h"
+#include "../common/chip-probe.h"
+#include "../common/chip-rt.h"
+#include "../common/chip-log.h"
+#include "../common/chip-thread.h"
 
-// Attribute handles
-static uint32_t magnetic_field_attr;
-static uint32_t output_inverted_attr;
+// Adaptive polling: Wokwi has no attribute change callbacks, so the chip
+// polls. Right after a change it polls every POLL_MIN_US, then doubles the
+// interval on every idle poll up to the ceiling (pollMaxMicros attribute).
+#define POLL_MIN_US 250
+#define POLL_MAX_US_DEFAULT 100000
 
-// Pin handles
-static pin_t out_pin;
+// Default operate/release points at 25°C in mT (operatePoint/releasePoint
+// attributes). Like the real part, the output switches when the field rises
+// to B_OP and only releases once it falls back to B_RP, so a field hovering
+// around the threshold does not make OUT chatter. South pole fields are
+// positive.
+#define OPERATE_POINT_MT 25.0f
+#define RELEASE_POINT_MT 20.0f
 
-// Timer handle
-static timer_t poll_timer;
+// Both switch points drift with temperature by this much per degree from 25°C
+#define TEMPCO_PPM_PER_C (-1000)
+#define TEMPERATURE_MIN_C (-40.0f)
+#define TEMPERATURE_MAX_C 150.0f
 
-// Previous values for change detection
-static uint32_t prev_magnetic_field = 0;
-static uint32_t prev_inverted = 1;
+// Fields are clamped to +/-1 T before conversion to integer microtesla
+#define FIELD_LIMIT_MT 1000.0f
 
-// Update output pin based on attributes
-static void update_output(void) {
-  uint32_t magnetic_field = attr_read(magnetic_field_attr);
-  uint32_t inverted = attr_read(output_inverted_attr);
+// outputInverted and temperature are configuration rather than signals, so
+// they are read together by the poll that crosses the next CONFIG_PERIOD_US
+// boundary of simulated time instead of on every poll. The boundaries are
+// fixed in time rather than counted from the last read, so an idle poll
+// keeps no state that skipped callbacks (host fast-forward) would leave
+// behind. A configuration change reaches OUT within one period plus one
+// poll; polls at least a period apart read it every time.
+#define CONFIG_PERIOD_US 100000
 
-  // A3144 is active LOW: output goes LOW when magnetic field is detected
-  bool field_detected = (magnetic_field > 50); // Threshold for "detected"
+// Propagation delay from a detected field change to OUT, 0 for none. The
+// real part responds in about 3 us (responseNanos attribute).
+#define RESPONSE_NS_DEFAULT 0
 
-  bool output_state;
-  if (inverted) {
-    // Active LOW mode (default A3144 behavior)
-    output_state = !field_detected;
+// Longest "trajectory" attribute accepted
+#define TRAJECTORY_MAX_LENGTH 128
+
+// Tachometer mode works in edges per minute, so one minute is the numerator
+// of every edge interval
+#define TACH_NS_PER_MIN 60000000000ull
+
+// Instances come from a fixed pool, so the per-sensor footprint is just
+// sizeof(chip_state_t). The simulator loads one module per chip, so a
+// single slot is enough there; the native host builds raise it to run many
+// sensors side by side.
+#ifndef A3144_MAX_INSTANCES
+#define A3144_MAX_INSTANCES 1
+#endif
+
+// How OUT is driven: from the polled magneticField, from a solved magnet
+// trajectory, or as a tachometer pulse train
+typedef enum {
+  MODE_FIELD,
+  MODE_TRAJECTORY,
+  MODE_TACH,
+} chip_mode_t;
+
+// Per-instance state, passed to the timers through user_data
+typedef struct {
+  // Attribute, pin and timer handles. poll_timer exists in field and
+  // tachometer mode, edge_timer in trajectory and tachometer mode,
+  // delay_timer when a response time is set.
+  uint32_t magnetic_field_attr;
+  uint32_t output_inverted_attr;
+  uint32_t temperature_attr;
+  pin_t out_pin;
+  pin_t vcc_pin;
+  pin_t gnd_pin;
+  timer_t poll_timer;
+  timer_t edge_timer;
+  timer_t delay_timer;
+  uint8_t mode;
+
+  // Current polling interval and its ceiling
+  uint32_t poll_interval_us;
+  uint32_t poll_max_us;
+
+  // Last attribute values read from the host. Float attributes are compared
+  // by bit pattern and converted to fixed point only when they change.
+  uint32_t field_bits;
+  uint32_t temperature_bits;
+  bool inverted;
+
+  // Field and switch points in integer microtesla. The switch points are
+  // kept at 25°C and compensated for the current temperature.
+  int32_t field_ut;
+  int32_t operate_25_ut;
+  int32_t release_25_ut;
+  int32_t operate_ut;
+  int32_t release_ut;
+
+  // Output state machine: operated is the hysteresis state (field
+  // detected), out_level is the level currently driven on OUT. With a
+  // response time, edge_pending is set while the opposite level is on its
+  // way to OUT.
+  bool operated;
+  uint8_t out_level;
+  bool edge_pending;
+  uint32_t response_ns;
+
+  // Supply: last levels seen on VCC and GND. While unpowered no timer runs
+  // and OUT is tri-stated (out_floating).
+  bool vcc_high;
+  bool gnd_high;
+  bool powered;
+  bool out_floating;
+
+  union {
+    // Trajectory mode: operate/release edges at fixed offsets into every
+    // period of the magnet motion, scheduled one timer per edge. period_ns
+    // is 0 when the output never switches.
+    struct {
+      bool has_release;
+      uint64_t period_ns;
+      uint64_t operate_ns;
+      uint64_t release_ns;
+      uint64_t period_start_ns;
+      uint64_t edge_ns;       // absolute time of the next scheduled edge
+    } trajectory;
+
+    // Tachometer mode: edge k after a speed change lands exactly at
+    // k * TACH_NS_PER_MIN / edges_per_min. The interval is kept as a whole
+    // part plus a remainder accumulated in integers, Bresenham style.
+    struct {
+      uint32_t rpm_attr;
+      uint32_t rpm;
+      uint32_t poles;         // south poles passing per revolution
+      uint32_t edges_per_min;
+      uint64_t interval_ns;
+      uint32_t remainder;     // in 1/edges_per_min ns
+      uint32_t accumulator;
+    } tach;
+  };
+} chip_state_t;
+
+static CHIP_THREAD_LOCAL chip_state_t chip_pool[A3144_MAX_INSTANCES];
+static CHIP_THREAD_LOCAL uint32_t chip_pool_used;
+
+// Log events, formatted only when the log ring is flushed
+enum {
+  LOG_INITIALIZED,
+  LOG_POOL_EXHAUSTED,
+  LOG_OUTPUT,
+  LOG_TRAJECTORY,
+  LOG_TRAJECTORY_INVALID,
+  LOG_EDGE,
+  LOG_TACH,
+  LOG_TACH_SPEED,
+  LOG_SWITCH_POINTS,
+  LOG_POWER,
+};
+
+static const chip_log_event_t log_events[] = {
+  [LOG_INITIALIZED] = {"Hall Effect Sensor initialized", {0}},
+  [LOG_POOL_EXHAUSTED] = {"instance pool exhausted", {"max"}},
+  [LOG_OUTPUT] = {"output", {"field_ut", "inverted", "level"}, 0x1},
+  [LOG_TRAJECTORY] = {"trajectory mode", {"period_us", "operate_us", "release_us"}},
+  [LOG_TRAJECTORY_INVALID] = {"invalid trajectory, falling back to polling", {0}},
+  [LOG_EDGE] = {"edge", {"level"}},
+  [LOG_TACH] = {"tachometer mode", {"poles"}},
+  [LOG_TACH_SPEED] = {"tachometer speed", {"rpm", "interval_ns"}},
+  [LOG_SWITCH_POINTS] = {"switch points", {"temperature_mc", "operate_ut", "release_ut"}, 0x7},
+  [LOG_POWER] = {"power", {"on"}},
+};
+
+static uint32_t float_bits(float value) {
+  union {
+    float f;
+    uint32_t u;
+  } bits = {value};
+  return bits.u;
+}
+
+static float bits_float(uint32_t value) {
+  union {
+    uint32_t u;
+    float f;
+  } bits = {value};
+  return bits.f;
+}
+
+// Scale by 1000 and round half away from zero. An inline conversion rather
+// than lrintf(), which is a libm call; callers keep the value in range.
+static int32_t to_milli(float value) {
+  value *= 1000.0f;
+  return (int32_t)(value < 0 ? value - 0.5f : value + 0.5f);
+}
+
+// mT to integer microtesla, NaN and out-of-range fields clamped
+static int32_t field_to_ut(float mt) {
+  return to_milli(chip_rt_clampf(mt, -FIELD_LIMIT_MT, FIELD_LIMIT_MT));
+}
+
+// Compensate the switch points for a new temperature reading. Runs once per
+// temperature change; the field path then only compares integers.
+static void update_switch_points(chip_state_t *chip, float celsius) {
+  celsius = chip_rt_clampf(celsius, TEMPERATURE_MIN_C, TEMPERATURE_MAX_C);
+  int32_t temperature_mc = to_milli(celsius);
+  int64_t scale_ppm = 1000000 + (int64_t)TEMPCO_PPM_PER_C * (temperature_mc - 25000) / 1000;
+  chip->operate_ut = (int32_t)(chip->operate_25_ut * scale_ppm / 1000000);
+  chip->release_ut = (int32_t)(chip->release_25_ut * scale_ppm / 1000000);
+  chip_log_info(LOG_SWITCH_POINTS, (uint32_t)temperature_mc, (uint32_t)chip->operate_ut,
+                (uint32_t)chip->release_ut);
+}
+
+// Advance the operate/release state machine for a new field reading
+static void update_field(chip_state_t *chip) {
+  if (!chip->operated && chip->field_ut >= chip->operate_ut) {
+    chip->operated = true;
+  } else if (chip->operated && chip->field_ut <= chip->release_ut) {
+    chip->operated = false;
+  }
+}
+
+// Level OUT settles to for the current state
+static uint8_t target_level(const chip_state_t *chip) {
+  // A3144 is active LOW: output goes LOW when magnetic field is detected.
+  // With outputInverted=0 the output is active HIGH instead.
+  return (chip->operated != chip->inverted) ? HIGH : LOW;
+}
+
+// Drive OUT from the cached state, only calling into the host on a transition
+static void drive_output(chip_state_t *chip) {
+  uint8_t level = target_level(chip);
+  if (!chip->response_ns) {
+    if (level != chip->out_level) {
+      chip->out_level = level;
+      pin_write(chip->out_pin, level);
+    }
+    return;
+  }
+
+  // Delayed output: at most one edge is in flight, on the one-shot delay
+  // timer. Going back to the driven level before it lands cancels it, the
+  // way the real part never shows a glitch shorter than its response time.
+  bool pending = level != chip->out_level;
+  if (pending != chip->edge_pending) {
+    chip->edge_pending = pending;
+    if (pending) {
+      timer_start_ns(chip->delay_timer, chip->response_ns, false);
+    } else {
+      timer_stop(chip->delay_timer);
+    }
+  }
+}
+
+// Timer callback for a deferred edge reaching OUT
+static void delay_callback(void *user_data) {
+  chip_state_t *chip = user_data;
+  chip->edge_pending = false;
+  chip->out_level = chip->out_level == HIGH ? LOW : HIGH;
+  pin_write(chip->out_pin, chip->out_level);
+}
+
+// Next tachometer edge interval: the whole part, plus one nanosecond whenever
+// the accumulated remainder wraps. Integer math only.
+static uint64_t tach_next_interval(chip_state_t *chip) {
+  uint64_t interval = chip->tach.interval_ns;
+  uint32_t headroom = chip->tach.edges_per_min - chip->tach.remainder;
+  if (chip->tach.accumulator >= headroom) {
+    chip->tach.accumulator -= headroom;
+    interval++;
+  } else {
+    chip->tach.accumulator += chip->tach.remainder;
+  }
+  return interval;
+}
+
+// Timer callback for tachometer mode - one call per OUT edge
+static void tach_callback(void *user_data) {
+  chip_state_t *chip = user_data;
+  chip->operated = !chip->operated;
+  drive_output(chip);
+  if (chip->tach.remainder) {
+    timer_start_ns(chip->edge_timer, tach_next_interval(chip), false);
+  }
+}
+
+// Restart the pulse train at a new speed, the first edge one interval from now
+static void tach_set_rpm(chip_state_t *chip, uint32_t rpm) {
+  uint64_t edges_per_min = 2ull * chip->tach.poles * rpm;
+  chip->tach.rpm = rpm;
+  if (edges_per_min == 0 || edges_per_min > UINT32_MAX) {
+    timer_stop(chip->edge_timer);
+    chip_log_info(LOG_TACH_SPEED, rpm, 0, 0);
+    return;
+  }
+
+  chip->tach.edges_per_min = (uint32_t)edges_per_min;
+  chip->tach.interval_ns = TACH_NS_PER_MIN / edges_per_min;
+  chip->tach.remainder = (uint32_t)(TACH_NS_PER_MIN % edges_per_min);
+  chip->tach.accumulator = 0;
+
+  // Whole-nanosecond intervals run on a repeating timer and never re-arm
+  timer_start_ns(chip->edge_timer, tach_next_interval(chip), chip->tach.remainder == 0);
+  chip_log_info(LOG_TACH_SPEED, rpm, (uint32_t)chip->tach.interval_ns, 0);
+}
+
+// Take a temperature reading as float bits, recompensating the switch
+// points only when it changed. Returns true if it did.
+static bool set_temperature_bits(chip_state_t *chip, uint32_t bits) {
+  if (bits == chip->temperature_bits) {
+    return false;
+  }
+  chip->temperature_bits = bits;
+  update_switch_points(chip, bits_float(bits));
+  return true;
+}
+
+// Take a field reading as float bits, converting it to microtesla only when
+// it changed. Returns true if it did.
+static bool set_field_bits(chip_state_t *chip, uint32_t bits) {
+  if (bits == chip->field_bits) {
+    return false;
+  }
+  chip->field_bits = bits;
+  chip->field_ut = field_to_ut(bits_float(bits));
+  return true;
+}
+
+// Read outputInverted and, in field mode where the switch points are in
+// use, temperature. Returns true if either changed.
+static bool read_config(chip_state_t *chip) {
+  bool changed = false;
+  bool inverted = attr_read(chip->output_inverted_attr) != 0;
+  if (inverted != chip->inverted) {
+    chip->inverted = inverted;
+    changed = true;
+  }
+  if (chip->mode == MODE_FIELD &&
+      set_temperature_bits(chip, float_bits(attr_read_float(chip->temperature_attr)))) {
+    changed = true;
+  }
+  return changed;
+}
+
+// Poll the field (or speed) and, when due, the configuration, then update
+// OUT. Returns true if anything changed.
+static bool update_output(chip_state_t *chip) {
+  bool changed = false;
+  if (chip->poll_interval_us >= CONFIG_PERIOD_US) {
+    changed = read_config(chip);
+  } else {
+    // A boundary in (previous poll, this poll]; the timer fired one interval
+    // after the previous poll or after it was armed
+    uint64_t now_us = get_sim_nanos() / 1000;
+    if (now_us / CONFIG_PERIOD_US != (now_us - chip->poll_interval_us) / CONFIG_PERIOD_US) {
+      changed = read_config(chip);
+    }
+  }
+
+  if (chip->mode == MODE_TACH) {
+    uint32_t value = attr_read(chip->tach.rpm_attr);
+    if (value != chip->tach.rpm) {
+      tach_set_rpm(chip, value);
+      changed = true;
+    }
+  } else {
+    if (set_field_bits(chip, float_bits(attr_read_float(chip->magnetic_field_attr)))) {
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return false;
+  }
+
+  if (chip->mode == MODE_FIELD) {
+    update_field(chip);
+  }
+  drive_output(chip);
+  chip_log_info(LOG_OUTPUT, (uint32_t)chip->field_ut, chip->inverted, target_level(chip));
+  return true;
+}
+
+// Magnet trajectory, from the "trajectory" string attribute:
+//   rotate rpm=<n> peak=<field>                   diametric magnet spinning in front of the sensor
+//   oscillate hz=<n> offset=<field> amplitude=<field>
+//   pass period_us=<n> width_us=<n> peak=<field>  magnet passing by once per period
+// hz/rpm may be replaced by period_us. Fields are in mT.
+// Every waveform starts at its minimum and is symmetric around mid-period.
+typedef enum {
+  TRAJECTORY_NONE,
+  TRAJECTORY_ROTATE,
+  TRAJECTORY_OSCILLATE,
+  TRAJECTORY_PASS,
+} trajectory_kind_t;
+
+typedef struct {
+  trajectory_kind_t kind;
+  uint32_t period_us;
+  uint32_t peak;
+  uint32_t offset;
+  uint32_t amplitude;
+  uint32_t width_us;
+} trajectory_t;
+
+static bool parse_word(const char **text, const char *word) {
+  const char *p = *text;
+  while (*word && *p == *word) {
+    p++;
+    word++;
+  }
+  if (*word) {
+    return false;
+  }
+  *text = p;
+  return true;
+}
+
+// Decimal digits, false if there are none or the value does not fit uint32_t
+static bool parse_uint(const char **text, uint32_t *value) {
+  const char *p = *text;
+  uint32_t result = 0;
+  if (*p < '0' || *p > '9') {
+    return false;
+  }
+  while (*p >= '0' && *p <= '9') {
+    uint32_t digit = (uint32_t)(*p++ - '0');
+    if (result > (UINT32_MAX - digit) / 10) {
+      return false;
+    }
+    result = result * 10 + digit;
+  }
+  *text = p;
+  *value = result;
+  return true;
+}
+
+static bool parse_trajectory(const char *text, trajectory_t *trajectory) {
+  *trajectory = (trajectory_t){TRAJECTORY_NONE, 0, 0, 0, 0, 0};
+  if (parse_word(&text, "rotate")) {
+    trajectory->kind = TRAJECTORY_ROTATE;
+  } else if (parse_word(&text, "oscillate")) {
+    trajectory->kind = TRAJECTORY_OSCILLATE;
+  } else if (parse_word(&text, "pass")) {
+    trajectory->kind = TRAJECTORY_PASS;
+  } else {
+    return false;
+  }
+
+  while (*text == ' ') {
+    while (*text == ' ') {
+      text++;
+    }
+    if (!*text) {
+      break;
+    }
+
+    uint32_t value;
+    if (parse_word(&text, "rpm=") && parse_uint(&text, &value) && value) {
+      trajectory->period_us = 60000000u / value;
+    } else if (parse_word(&text, "hz=") && parse_uint(&text, &value) && value) {
+      trajectory->period_us = 1000000u / value;
+    } else if (parse_word(&text, "period_us=") && parse_uint(&text, &value)) {
+      trajectory->period_us = value;
+    } else if (parse_word(&text, "peak=") && parse_uint(&text, &value)) {
+      trajectory->peak = value;
+    } else if (parse_word(&text, "offset=") && parse_uint(&text, &value)) {
+      trajectory->offset = value;
+    } else if (parse_word(&text, "amplitude=") && parse_uint(&text, &value)) {
+      trajectory->amplitude = value;
+    } else if (parse_word(&text, "width_us=") && parse_uint(&text, &value)) {
+      trajectory->width_us = value;
+    } else {
+      return false;
+    }
+  }
+  if (trajectory->kind == TRAJECTORY_PASS && trajectory->width_us == 0) {
+    return false;
+  }
+  return *text == '\0' && trajectory->period_us > 0;
+}
+
+// Field at phase 0 (the minimum) and mid-period (the maximum)
+static void trajectory_range(const trajectory_t *t, double *min, double *max) {
+  switch (t->kind) {
+  case TRAJECTORY_ROTATE:
+    *min = -(double)t->peak;
+    *max = t->peak;
+    break;
+  case TRAJECTORY_OSCILLATE:
+    *min = (double)t->offset - t->amplitude;
+    *max = (double)t->offset + t->amplitude;
+    break;
+  default: {
+    double u = 0.5 * t->period_us / (t->width_us ? t->width_us : 1);
+    double v = 1.0 + u * u;
+    *min = t->peak / (v * chip_rt_sqrt(v));
+    *max = t->peak;
+    break;
+  }
+  }
+}
+
+// Phase in [0, 0.5] at which the rising field crosses level (min < level <= max)
+static double trajectory_rising_phase(const trajectory_t *t, double level) {
+  const double two_pi = 6.283185307179586;
+  switch (t->kind) {
+  case TRAJECTORY_ROTATE:
+    // field = -peak * cos(2*pi*phase)
+    return chip_rt_acos(-level / t->peak) / two_pi;
+  case TRAJECTORY_OSCILLATE:
+    // field = offset - amplitude * cos(2*pi*phase)
+    return chip_rt_acos(((double)t->offset - level) / t->amplitude) / two_pi;
+  default: {
+    // On-axis dipole: field = peak / (1 + u^2)^1.5, u = (phase - 0.5) * period / width
+    double r = chip_rt_cbrt(t->peak / level);
+    double u = chip_rt_sqrt(r * r - 1.0);
+    return 0.5 - u * t->width_us / t->period_us;
+  }
+  }
+}
+
+// Solve the operate/release crossings once; afterwards every edge is an
+// integer offset into its period, so edge times never drift
+static void trajectory_solve(chip_state_t *chip, const trajectory_t *t) {
+  double min, max;
+  double operate = chip->operate_ut / 1000.0;
+  double release = chip->release_ut / 1000.0;
+  trajectory_range(t, &min, &max);
+
+  chip->trajectory.period_ns = (uint64_t)t->period_us * 1000u;
+  chip->operated = min >= operate;
+  chip->trajectory.operate_ns = 0;
+  chip->trajectory.release_ns = 0;
+  chip->trajectory.has_release = false;
+  if (chip->operated || max < operate) {
+    // The output never switches
+    chip->trajectory.period_ns = 0;
+    return;
+  }
+
+  double period = (double)chip->trajectory.period_ns;
+  chip->trajectory.operate_ns = (uint64_t)chip_rt_llround(trajectory_rising_phase(t, operate) * period);
+  if (min <= release) {
+    chip->trajectory.has_release = true;
+    chip->trajectory.release_ns = (uint64_t)chip_rt_llround((1.0 - trajectory_rising_phase(t, release)) * period);
+  }
+}
+
+// Arm the edge timer for the crossing that follows the current state, counted
+// from now_ns (the previous edge, or the start of the trajectory)
+static void trajectory_schedule(chip_state_t *chip, uint64_t now_ns) {
+  uint64_t offset_ns;
+  if (!chip->trajectory.period_ns) {
+    return;
+  } else if (!chip->operated) {
+    offset_ns = chip->trajectory.operate_ns;
+  } else if (chip->trajectory.has_release) {
+    offset_ns = chip->trajectory.release_ns;
   } else {
-    // Active HIGH mode
-    output_state = field_detected;
+    return;
   }
+  chip->trajectory.edge_ns = chip->trajectory.period_start_ns + offset_ns;
+  timer_start_ns(chip->edge_timer, chip->trajectory.edge_ns - now_ns, false);
+}
 
-  // Write to output pin
-  pin_write(out_pin, output_state ? HIGH : LOW);
+// Timer callback for trajectory mode - one call per OUT edge
+static void edge_callback(void *user_data) {
+  chip_state_t *chip = user_data;
+  uint64_t now_ns = chip->trajectory.edge_ns;
 
-  // Log only when values change
-  if (magnetic_field != prev_magnetic_field || inverted != prev_inverted) {
-    printf("A3144: Magnetic field=%lu, Inverted=%lu, Output=%s\n",
-           magnetic_field, inverted,
-           output_state ? "HIGH" : "LOW");
-    prev_magnetic_field = magnetic_field;
-    prev_inverted = inverted;
+  chip->operated = !chip->operated;
+  if (!chip->operated) {
+    // Released: the next operate point is in the following period
+    chip->trajectory.period_start_ns += chip->trajectory.period_ns;
   }
+  // Nothing polls in this mode, so outputInverted is picked up per edge
+  read_config(chip);
+  drive_output(chip);
+  chip_log_debug(LOG_EDGE, target_level(chip), 0, 0);
+  trajectory_schedule(chip, now_ns);
+}
+
+// Read the "trajectory" attribute, returns false when it is unset or invalid
+static bool read_trajectory(trajectory_t *trajectory) {
+  string_t text_attr = attr_string_init("trajectory");
+  uint32_t length = string_get_length(text_attr);
+  if (length == 0) {
+    return false;
+  }
+
+  char text[TRAJECTORY_MAX_LENGTH];
+  if (length >= sizeof(text)) {
+    chip_log_warn(LOG_TRAJECTORY_INVALID, 0, 0, 0);
+    return false;
+  }
+  string_read(text_attr, text, sizeof(text));
+  text[length] = '\0';
+  if (!parse_trajectory(text, trajectory)) {
+    chip_log_warn(LOG_TRAJECTORY_INVALID, 0, 0, 0);
+    return false;
+  }
+  return true;
 }
 
 // Timer callback - called periodically to check attribute changes
 static void poll_callback(void *user_data) {
-  (void)user_data; // Unused
-  update_output();
+  chip_state_t *chip = user_data;
+
+  uint32_t next_us;
+  if (update_output(chip)) {
+    next_us = POLL_MIN_US;
+  } else {
+    // Doubling a ceiling near UINT32_MAX would wrap, so clamp first
+    uint32_t max_us = chip->poll_max_us;
+    next_us = chip->poll_interval_us > max_us / 2 ? max_us : chip->poll_interval_us * 2;
+  }
+
+  // The timer is repeating, so it only needs re-arming when the interval moves
+  if (next_us != chip->poll_interval_us) {
+    chip->poll_interval_us = next_us;
+    timer_start(chip->poll_timer, chip->poll_interval_us, true);
+  }
+}
+
+// Resume a trajectory after a power cycle as if power had never been lost:
+// the magnet kept moving, so the state follows from the phase at now_ns
+static void trajectory_resume(chip_state_t *chip, uint64_t now_ns) {
+  uint64_t period_ns = chip->trajectory.period_ns;
+  if (!period_ns) {
+    // The output never switches, operated stays as solved
+    return;
+  }
+  uint64_t offset_ns = (now_ns - chip->trajectory.period_start_ns) % period_ns;
+  chip->trajectory.period_start_ns = now_ns - offset_ns;
+  if (offset_ns < chip->trajectory.operate_ns) {
+    chip->operated = false;
+  } else if (!chip->trajectory.has_release || offset_ns < chip->trajectory.release_ns) {
+    chip->operated = true;
+  } else {
+    chip->operated = false;
+    chip->trajectory.period_start_ns += period_ns;
+  }
+  trajectory_schedule(chip, now_ns);
+}
+
+// Power-on: inputs and configuration are picked up afresh, the timers
+// restart and OUT is driven again. Runs from chip_init() and on every return
+// of the supply.
+static void power_on(chip_state_t *chip) {
+  chip->edge_pending = false;
+  read_config(chip);
+  if (chip->mode == MODE_TRAJECTORY) {
+    trajectory_resume(chip, get_sim_nanos());
+  } else {
+    // Like the real part, OUT comes up released
+    chip->operated = false;
+    if (chip->mode == MODE_FIELD) {
+      chip->field_bits = float_bits(attr_read_float(chip->magnetic_field_attr));
+      chip->field_ut = field_to_ut(bits_float(chip->field_bits));
+      update_field(chip);
+    } else {
+      tach_set_rpm(chip, attr_read(chip->tach.rpm_attr));
+    }
+    chip->poll_interval_us = POLL_MIN_US;
+    timer_start(chip->poll_timer, chip->poll_interval_us, true);
+  }
+
+  // The power-on level is immediate, later edges take the response time. A
+  // floating OUT leaves tri-state already at that level, in one call.
+  uint8_t level = target_level(chip);
+  if (chip->out_floating) {
+    chip->out_floating = false;
+    chip->out_level = level;
+    pin_mode(chip->out_pin, level ? OUTPUT_HIGH : OUTPUT_LOW);
+  } else if (level != chip->out_level) {
+    chip->out_level = level;
+    pin_write(chip->out_pin, level);
+  }
+  chip_log_info(LOG_POWER, 1, 0, 0);
+}
+
+// Power-off: every timer stops, OUT floats and the log is flushed, so an
+// unpowered sensor costs no callbacks at all until the supply returns
+static void power_off(chip_state_t *chip) {
+  if (chip->mode != MODE_TRAJECTORY) {
+    timer_stop(chip->poll_timer);
+  }
+  if (chip->mode != MODE_FIELD) {
+    timer_stop(chip->edge_timer);
+  }
+  if (chip->edge_pending) {
+    chip->edge_pending = false;
+    timer_stop(chip->delay_timer);
+  }
+  chip->out_floating = true;
+  pin_mode(chip->out_pin, INPUT);
+  chip_log_info(LOG_POWER, 0, 0, 0);
+  chip_log_flush();
+}
+
+// Pin watch callback for VCC and GND
+static void power_callback(void *user_data, pin_t pin, uint32_t value) {
+  chip_state_t *chip = user_data;
+  if (pin == chip->vcc_pin) {
+    chip->vcc_high = value == HIGH;
+  } else {
+    chip->gnd_high = value == HIGH;
+  }
+
+  bool powered = chip->vcc_high && !chip->gnd_high;
+  if (powered == chip->powered) {
+    return;
+  }
+  chip->powered = powered;
+  if (powered) {
+    power_on(chip);
+  } else {
+    power_off(chip);
+  }
 }
 
 // Initialize the chip
 void chip_init(void) {
-  // Initialize attributes (magnetic field strength: 0-100, default 0)
-  magnetic_field_attr = attr_init("magneticField", 0);
+  chip_log_init("A3144", log_events);
+  if (chip_pool_used == A3144_MAX_INSTANCES) {
+    chip_log_error(LOG_POOL_EXHAUSTED, A3144_MAX_INSTANCES, 0, 0);
+    return;
+  }
+  chip_state_t *chip = &chip_pool[chip_pool_used++];
+
+  // Magnetic field at the sensor in mT, default 0
+  chip->magnetic_field_attr = attr_init_float("magneticField", 0.0f);
 
   // Initialize output inverted attribute (0=normal, 1=inverted), default 1 (inverted/active LOW)
-  output_inverted_attr = attr_init("outputInverted", 1);
+  chip->output_inverted_attr = attr_init("outputInverted", 1);
+
+  // Die temperature in °C, shifts the switch points
+  chip->temperature_attr = attr_init_float("temperature", 25.0f);
+
+  // Switch points at 25°C in mT, only settable from diagram.json. A release
+  // point above the operate point would leave no hysteresis band, so it is
+  // capped at the operate point.
+  chip->operate_25_ut = field_to_ut(attr_read_float(attr_init_float("operatePoint", OPERATE_POINT_MT)));
+  chip->release_25_ut = field_to_ut(attr_read_float(attr_init_float("releasePoint", RELEASE_POINT_MT)));
+  if (chip->release_25_ut > chip->operate_25_ut) {
+    chip->release_25_ut = chip->operate_25_ut;
+  }
+  chip->temperature_bits = float_bits(attr_read_float(chip->temperature_attr));
+  update_switch_points(chip, bits_float(chip->temperature_bits));
+
+  // Polling interval ceiling in microseconds, only settable from diagram.json
+  chip->poll_max_us = attr_read(attr_init("pollMaxMicros", POLL_MAX_US_DEFAULT));
+  if (chip->poll_max_us < POLL_MIN_US) {
+    chip->poll_max_us = POLL_MIN_US;
+  }
 
   // Initialize OUT pin as output
-  out_pin = pin_init("OUT", OUTPUT_HIGH);
+  chip->out_pin = pin_init("OUT", OUTPUT_HIGH);
+  chip->out_level = HIGH;
+  chip->edge_pending = false;
+
+  // When the magnet motion is known up front, the field is not polled at
+  // all: the chip solves for the threshold crossings and schedules OUT edges.
+  // With tachPoles set the chip emits a pulse train for the tachRpm speed.
+  trajectory_t trajectory;
+  uint32_t tach_poles = attr_read(attr_init("tachPoles", 0));
+  if (read_trajectory(&trajectory)) {
+    chip->mode = MODE_TRAJECTORY;
+  } else if (tach_poles > 0) {
+    chip->mode = MODE_TACH;
+  } else {
+    chip->mode = MODE_FIELD;
+  }
+
+  chip->inverted = attr_read(chip->output_inverted_attr) != 0;
+  chip->operated = false;
+  if (chip->mode == MODE_TRAJECTORY) {
+    trajectory_solve(chip, &trajectory);
+  }
+
+  // Propagation delay, only settable from diagram.json
+  chip->response_ns = attr_read(attr_init("responseNanos", RESPONSE_NS_DEFAULT));
+  if (chip->response_ns) {
+    const timer_config_t delay_config = {
+      .callback = delay_callback,
+      .user_data = chip,
+    };
+    chip->delay_timer = timer_init(&delay_config);
+  }
 
-  // Set initial output state
-  update_output();
+  // Edge timer, firing on each trajectory crossing or tachometer edge
+  if (chip->mode != MODE_FIELD) {
+    const timer_config_t edge_config = {
+      .callback = chip->mode == MODE_TACH ? tach_callback : edge_callback,
+      .user_data = chip,
+    };
+    chip->edge_timer = timer_init(&edge_config);
+  }
+
+  if (chip->mode == MODE_TRAJECTORY) {
+    chip->trajectory.period_start_ns = get_sim_nanos();
+    chip_log_info(LOG_TRAJECTORY, trajectory.period_us,
+                  (uint32_t)(chip->trajectory.operate_ns / 1000u),
+                  (uint32_t)(chip->trajectory.release_ns / 1000u));
+  } else {
+    if (chip->mode == MODE_TACH) {
+      chip->tach.poles = tach_poles;
+      chip->tach.rpm_attr = attr_init("tachRpm", 0);
+      chip_log_info(LOG_TACH, tach_poles, 0, 0);
+    }
 
-  // Set up a timer to poll attributes every 100ms (100,000 microseconds)
-  const timer_config_t timer_config = {
-    .callback = poll_callback,
-    .user_data = NULL,
+    // Set up a timer to poll attributes, starting fast and backing off while idle
+    const timer_config_t poll_config = {
+      .callback = poll_callback,
+      .user_data = chip,
+    };
+    chip->poll_timer = timer_init(&poll_config);
+  }
+
+  // Supply pins, pulled to their rails so that a sensor with VCC and GND
+  // left unwired counts as powered. Both are watched rather than polled.
+  chip->vcc_pin = pin_init("VCC", INPUT_PULLUP);
+  chip->gnd_pin = pin_init("GND", INPUT_PULLDOWN);
+  chip->vcc_high = pin_read(chip->vcc_pin) == HIGH;
+  chip->gnd_high = pin_read(chip->gnd_pin) == HIGH;
+  const pin_watch_config_t power_config = {
+    .user_data = chip,
+    .edge = BOTH,
+    .pin_change = power_callback,
   };
-  poll_timer = timer_init(&timer_config);
-  timer_start(poll_timer, 100000, true); // 100ms, repeating
+  pin_watch(chip->vcc_pin, &power_config);
+  pin_watch(chip->gnd_pin, &power_config);
+
+  // Logged first, so that a chip initialized unpowered flushes it with the
+  // power-off record
+  chip_log_info(LOG_INITIALIZED, 0, 0, 0);
 
-  printf("A3144 Hall Effect Sensor initialized\n");
+  chip->out_floating = false;
+  chip->powered = chip->vcc_high && !chip->gnd_high;
+  if (chip->powered) {
+    power_on(chip);
+  } else {
+    power_off(chip);
+  }
+}
+
+#ifdef WOKWI_HOST
+// Native host only: hand every pool slot back between simulations
+void chip_host_reset(void) {
+  chip_pool_used = 0;
+  chip_log_reset();
+  chip_probe_reset();
+}
+
+// Native host only: the field-mode path of update_output() on a state of its
+// own, for bench/field.c. Reset starts released at 25 °C with the default
+// switch points; each step takes one field and temperature reading and
+// returns whether the sensor is operated.
+static CHIP_THREAD_LOCAL chip_state_t chip_host_field;
+
+void chip_host_field_reset(void) {
+  chip_host_field = (chip_state_t){
+    .operate_25_ut = field_to_ut(OPERATE_POINT_MT),
+    .release_25_ut = field_to_ut(RELEASE_POINT_MT),
+    .field_bits = ~0u,
+    .temperature_bits = ~0u,
+  };
+}
+
+bool chip_host_field_step(float field_mt, float celsius) {
+  chip_state_t *chip = &chip_host_field;
+  bool changed = set_temperature_bits(chip, float_bits(celsius));
+  if (set_field_bits(chip, float_bits(field_mt))) {
+    changed = true;
+  }
+  if (changed) {
+    update_field(chip);
+  }
+  return chip->operated;
 }
+#endif
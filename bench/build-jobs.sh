@@ -0,0 +1,74 @@
+#!/bin/bash
+# build.sh scaling check: builds of N synthetic chips (copies of a3144 as
+# chip01..chipNN) in build/build-jobs with ./build.sh --no-cache -j1, -j4
+# and -j16, then once more with the cache. Each run must build every chip,
+# replay the logs in chip order and exit 0.
+#
+# Usage: bench/build-jobs.sh [chips]   (default 50)
+#
+# Without wokwi-cli or a clang that links wasm32-unknown-wasi, build.sh
+# gets the host compiler through the Makefile's print-cc, as in
+# bench/chips.sh: native objects instead of modules, same script.
+
+set -euo pipefail
+
+chips=${1:-50}
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$root/build/build-jobs
+
+rm -rf "$work"
+mkdir -p "$work"
+cp "$root/Makefile" "$root/build.sh" "$work/"
+cp -r "$root/common" "$work/"
+for i in $(seq 1 "$chips"); do
+    chip=$(printf 'chip%02d' "$i")
+    mkdir "$work/$chip"
+    cp "$root/a3144/chip.c" "$root/a3144/chip.json" "$root/a3144/wokwi-api.h" "$work/$chip/"
+done
+
+if command -v wokwi-cli > /dev/null 2>&1; then
+    compiler="wokwi-cli"
+elif printf 'void chip_init(void) {}\n' | clang --target=wasm32-unknown-wasi -nostartfiles -Wl,--no-entry \
+        -o /dev/null -x c - > /dev/null 2>&1; then
+    compiler="clang, wasm32"
+else
+    compiler="cc -c, native objects (no wasm toolchain)"
+    export MAKEFLAGS='CC=cc TARGET= CFLAGS=-c\ -O2\ -w'
+fi
+
+failed=0
+expected=$(cd "$work" && printf '%s\n' chip*/ | tr -d /)
+echo "$chips synthetic chips, $(nproc) cpus, $compiler"
+printf '  %-18s %6s %7s %8s %9s %8s\n' run built hits ordered wall_s speedup
+
+# run <name> <expected cache hits, - without the cache> <build.sh args...>:
+# time one build, check what it reports
+run() {
+    local name=$1 want_hits=$2 start end log status=0 built hits order wall
+    shift 2
+    start=$(date +%s.%N)
+    log=$(cd "$work" && ./build.sh "$@" 2>&1) || status=$?
+    end=$(date +%s.%N)
+    built=$(sed -nE 's/^  Successful: ([0-9]+)$/\1/p' <<< "$log")
+    hits=$(sed -nE 's/^  Cache: ([0-9]+) hits.*/\1/p' <<< "$log")
+    order=no
+    if [[ $(sed -nE 's/.*Building (chip[0-9]+)\.\.\.$/\1/p' <<< "$log") == "$expected" ]]; then
+        order=yes
+    fi
+    wall=$(awk "BEGIN { print $end - $start }")
+    baseline=${baseline:-$wall}
+    printf '  %-18s %6s %7s %8s %9.2f %7.2fx\n' "$name" "${built:-?}" "${hits:--}" "$order" "$wall" \
+        "$(awk "BEGIN { print $baseline / $wall }")"
+    if [[ $status -ne 0 || ${built:-0} -ne $chips || $order != yes || ${hits:--} != "$want_hits" ]]; then
+        failed=1
+    fi
+}
+
+baseline=""
+run "-j1" - --no-cache -j 1
+run "-j4" - --no-cache -j 4
+run "-j16" - --no-cache -j 16
+run "-j16, cached" "$chips" -j 16
+
+rm -rf "$work"
+exit $failed
@@ -0,0 +1,64 @@
+#!/bin/bash
+# Makefile scaling check: cold, no-op and incremental builds of N synthetic
+# chips (copies of a3144 as chip01..chipNN) in build/chips, with make -jJOBS.
+# Each step checks that make ran exactly the compiles it should have.
+#
+# Usage: bench/chips.sh [chips]        (default 50, JOBS defaults to nproc)
+#
+# Without a clang that links wasm32-unknown-wasi, the chips are compiled
+# with the host compiler to native objects instead: the same rules and
+# dependency files, a different code generator.
+
+set -euo pipefail
+
+chips=${1:-50}
+jobs=${JOBS:-$(nproc)}
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$root/build/chips
+
+rm -rf "$work"
+mkdir -p "$work"
+cp "$root/Makefile" "$work/"
+cp -r "$root/common" "$work/"
+for i in $(seq 1 "$chips"); do
+    chip=$(printf 'chip%02d' "$i")
+    mkdir "$work/$chip"
+    cp "$root/a3144/chip.c" "$root/a3144/chip.json" "$root/a3144/wokwi-api.h" "$work/$chip/"
+done
+
+if printf 'void chip_init(void) {}\n' | clang --target=wasm32-unknown-wasi -nostartfiles -Wl,--no-entry \
+        -o /dev/null -x c - > /dev/null 2>&1; then
+    compiler="clang, wasm32"
+    make_args=()
+else
+    compiler="cc -c, native objects (no wasm toolchain)"
+    make_args=(CC=cc TARGET= "CFLAGS=-c -O2 -w")
+fi
+
+failed=0
+echo "$chips synthetic chips, make -j$jobs, $compiler"
+printf '  %-22s %9s %9s %9s\n' step compiles expected wall_s
+
+# step <name> <expected compiles>: run make all, count the compiler runs
+step() {
+    local start end log compiles
+    start=$(date +%s.%N)
+    log=$(make -C "$work" -j"$jobs" --no-print-directory "${make_args[@]}" all)
+    end=$(date +%s.%N)
+    compiles=$(grep -c -- '-MMD' <<< "$log" || true)
+    printf '  %-22s %9d %9d %9.2f\n' "$1" "$compiles" "$2" "$(awk "BEGIN { print $end - $start }")"
+    if [[ $compiles -ne $2 ]]; then
+        failed=1
+    fi
+}
+
+step cold "$chips"
+step no-op 0
+touch "$work/chip01/chip.c"
+step "one chip.c touched" 1
+touch "$work/common/chip-log.h"
+step "common header touched" "$chips"
+step no-op 0
+
+rm -rf "$work"
+exit $failed
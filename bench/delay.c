@@ -0,0 +1,144 @@
+/*
+ * A3144 propagation delay benchmark
+ *
+ * Drives magneticField with a 50 Hz square wave whose transitions bounce:
+ * each one is followed by up to three short glitches back across the
+ * switch points. Every scenario runs twice on the same input, once with no
+ * response time to record the edges the chip detects, and once with
+ * responseNanos set. The detected edges are put through the expected filter
+ * (each edge lands one response time later unless the next edge arrives
+ * first and cancels it), and the delayed run must match it edge for edge.
+ * Response times stay off the 250 us poll grid: a change detected in the
+ * same nanosecond as a pending edge lands is ordered by the host's arm
+ * sequence, which the model does not try to reproduce.
+ *
+ * Reports OUT edges, the worst timing error against the model, and the
+ * host calls the delay path costs (timer starts/stops, delay callbacks and
+ * OUT writes) against deferring every detected edge on its own, which takes
+ * a timer start, a callback and a pin write each and lets every glitch
+ * through to OUT.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define SIM_SECONDS 10
+#define HALF_PERIOD_US 10000
+#define MAX_EDGES 16384
+
+typedef struct {
+  uint64_t at[MAX_EDGES];
+  uint32_t level[MAX_EDGES];
+  uint32_t count;
+} edges_t;
+
+static edges_t detected;
+static edges_t delayed;
+static edges_t *recording;
+static FILE *report;
+
+static void record_edge(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  (void)instance;
+  (void)pin;
+  if (recording->count < MAX_EDGES) {
+    recording->at[recording->count] = sim_ns;
+    recording->level[recording->count] = value;
+    recording->count++;
+  }
+}
+
+static uint32_t lcg_next(uint32_t *lcg) {
+  *lcg = *lcg * 1103515245u + 12345u;
+  return *lcg >> 8;
+}
+
+// Returns the timer imports made during the run
+static uint64_t run(edges_t *edges, uint32_t response_ns) {
+  host_reset();
+  host_attr_set("pollMaxMicros", 250);
+  host_attr_set("responseNanos", response_ns);
+  edges->count = 0;
+  recording = edges;
+  chip_init();
+
+  // Glitches last 300-900 us, so the 250 us poll sees most of them
+  uint32_t lcg = 7;
+  bool high = false;
+  for (uint64_t t = HOST_US(HALF_PERIOD_US); t < HOST_SEC(SIM_SECONDS); t += HOST_US(HALF_PERIOD_US)) {
+    high = !high;
+    uint64_t at = t;
+    uint32_t glitches = lcg_next(&lcg) % 4;
+    for (uint32_t i = 0; i <= 2 * glitches; i++) {
+      host_run_until(at);
+      bool level = (i % 2 == 0) == high;
+      host_attr_set_float("magneticField", level ? 40.0 : 5.0);
+      at += HOST_US(300 + lcg_next(&lcg) % 600);
+    }
+  }
+  host_run_until(HOST_SEC(SIM_SECONDS));
+
+  const host_counters_t *c = host_counters();
+  return c->timer_start + c->timer_stop;
+}
+
+// Expected delayed output from the detected edges, compared with the run
+static bool check(uint32_t response_ns, uint64_t *worst_ns) {
+  edges_t expected = {.count = 0};
+  for (uint32_t i = 0; i < detected.count; i++) {
+    if (i + 1 < detected.count && detected.at[i + 1] < detected.at[i] + response_ns) {
+      i++;   // cancelled by the edge back
+      continue;
+    }
+    expected.at[expected.count] = detected.at[i] + response_ns;
+    expected.level[expected.count] = detected.level[i];
+    expected.count++;
+  }
+
+  *worst_ns = 0;
+  if (expected.count != delayed.count) {
+    return false;
+  }
+  for (uint32_t i = 0; i < delayed.count; i++) {
+    if (expected.level[i] != delayed.level[i]) {
+      return false;
+    }
+    uint64_t error = delayed.at[i] > expected.at[i] ? delayed.at[i] - expected.at[i]
+                                                    : expected.at[i] - delayed.at[i];
+    *worst_ns = error > *worst_ns ? error : *worst_ns;
+  }
+  return true;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  host_set_pin_listener(record_edge);
+
+  static const uint32_t responses_ns[] = {3000, 240000, 610000, 1100000, 2600000};
+  bool ok = true;
+
+  fprintf(report, "%11s %9s %8s %9s %6s %11s %15s\n",
+          "response_ns", "detected", "out", "worst_ns", "match", "delay_calls", "per_edge_calls");
+  for (unsigned i = 0; i < sizeof(responses_ns) / sizeof(responses_ns[0]); i++) {
+    uint64_t base_calls = run(&detected, 0);
+    uint64_t calls = run(&delayed, responses_ns[i]) - base_calls + 2ull * delayed.count;
+    uint64_t worst_ns;
+    bool match = check(responses_ns[i], &worst_ns);
+    ok = ok && match;
+
+    fprintf(report, "%11u %9u %8u %9lu %6s %11lu %15u\n",
+            responses_ns[i], detected.count, delayed.count, (unsigned long)worst_ns,
+            match ? "yes" : "NO", (unsigned long)calls, 3 * detected.count);
+  }
+  fclose(report);
+  return ok ? 0 : 1;
+}
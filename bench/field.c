@@ -0,0 +1,122 @@
+/*
+ * A3144 field evaluation micro-benchmark
+ *
+ * Compares two ways of turning (field mT, temperature °C) readings into the
+ * operate/release state:
+ *  - float: temperature-compensate the switch points and compare in float
+ *    on every update
+ *  - fixed: the chip's own path, through chip_host_field_step(). Readings
+ *    are compared by bit pattern, converted to integer microtesla only when
+ *    they change, and the switch points are recompensated only when the
+ *    temperature changes
+ * Both run over the same recorded input streams; the report gives ns per
+ * update and the number of updates where the two disagree, which happens
+ * only for readings within a rounding step of a switch point. The fixed path
+ * wins when readings hold; on noisy input, where every update is a change,
+ * it is the slower of the two.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UPDATES (1u << 22)
+#define OPERATE_MT 25.0f
+#define RELEASE_MT 20.0f
+#define TEMPCO_PPM_PER_C (-1000)
+
+static float fields[UPDATES];
+static float temperatures[UPDATES];
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint32_t lcg_next(uint32_t *lcg) {
+  *lcg = *lcg * 1103515245u + 12345u;
+  return *lcg >> 8;
+}
+
+// Field changes every field_hold updates, temperature every temperature_hold
+static void record(uint32_t field_hold, uint32_t temperature_hold) {
+  uint32_t lcg = 1;
+  float field = 0, temperature = 25;
+  for (uint32_t i = 0; i < UPDATES; i++) {
+    if (i % field_hold == 0) {
+      field = 15.0f + (float)(lcg_next(&lcg) % 1500) / 100.0f;
+    }
+    if (i % temperature_hold == 0) {
+      temperature = -40.0f + (float)(lcg_next(&lcg) % 1250) / 10.0f;
+    }
+    fields[i] = field;
+    temperatures[i] = temperature;
+  }
+}
+
+static bool float_path(uint8_t *out) {
+  bool operated = false;
+  for (uint32_t i = 0; i < UPDATES; i++) {
+    float scale = 1.0f + TEMPCO_PPM_PER_C * 1e-6f * (temperatures[i] - 25.0f);
+    if (!operated && fields[i] >= OPERATE_MT * scale) {
+      operated = true;
+    } else if (operated && fields[i] <= RELEASE_MT * scale) {
+      operated = false;
+    }
+    out[i] = operated;
+  }
+  return operated;
+}
+
+// The chip's path, from a3144/chip.c (native host builds only)
+void chip_host_field_reset(void);
+bool chip_host_field_step(float field_mt, float celsius);
+
+static bool fixed_path(uint8_t *out) {
+  chip_host_field_reset();
+  bool operated = false;
+  for (uint32_t i = 0; i < UPDATES; i++) {
+    operated = chip_host_field_step(fields[i], temperatures[i]);
+    out[i] = operated;
+  }
+  return operated;
+}
+
+static void run(const char *scenario, uint32_t field_hold, uint32_t temperature_hold) {
+  static uint8_t float_out[UPDATES], fixed_out[UPDATES];
+  record(field_hold, temperature_hold);
+
+  // Best of a few rounds, the first one also faults the output pages in
+  double float_ns = INFINITY, fixed_ns = INFINITY;
+  for (int round = 0; round < 5; round++) {
+    double start = wall_seconds();
+    float_path(float_out);
+    float_ns = fmin(float_ns, (wall_seconds() - start) * 1e9 / UPDATES);
+
+    start = wall_seconds();
+    fixed_path(fixed_out);
+    fixed_ns = fmin(fixed_ns, (wall_seconds() - start) * 1e9 / UPDATES);
+  }
+
+  uint32_t mismatches = 0;
+  for (uint32_t i = 0; i < UPDATES; i++) {
+    mismatches += float_out[i] != fixed_out[i];
+  }
+  printf("%-10s %10u %10u %10.2f %10.2f %10u\n",
+         scenario, field_hold, temperature_hold, float_ns, fixed_ns, mismatches);
+}
+
+int main(void) {
+  printf("%-10s %10s %10s %10s %10s %10s\n",
+         "input", "field_hold", "temp_hold", "float_ns", "fixed_ns", "mismatch");
+  run("slider", 4000, 1u << 30);   // one slider move per second at 4 kHz
+  run("sweep", 16, 4000);
+  run("noisy", 1, 64);
+  return 0;
+}
@@ -0,0 +1,386 @@
+/*
+ * A3144 golden-trace regression check
+ *
+ * Runs canned stimulus scenarios and compares the OUT transitions, with
+ * their simulated timestamps, to the traces checked in under bench/golden.
+ * Every golden file also holds the scenario's wall-clock cost when it was
+ * recorded, so one run flags both behavior and performance regressions:
+ *   EDGES    a different number of OUT edges, or a different level
+ *   TIMING   an edge further from its golden time than the tolerance
+ *   SLOWER   the run costs more than the slowdown limit times the golden
+ *
+ * Scenarios:
+ *   sweep        field dragged 0-60-0 mT over 10 s in 10 ms steps, three times
+ *   toggle       field toggling across the switch points every 2 ms
+ *   temperature  field stepping 18/24 mT every 200 ms while the die goes
+ *                -40..85..-40 °C, operating only where the switch point
+ *                has drifted below 24 mT
+ *   power        VCC dropped for 100 ms every second, the magnet arriving
+ *                or leaving while the sensor is off
+ *   noninverted  outputInverted = 0, magnet passes every 250 ms
+ *   invert       outputInverted flipped every 1.37 s with the magnet held
+ *                on an idle sensor; also checks each flip reaches OUT
+ *                within INVERT_LATENCY_NS
+ *   response     responseNanos = 20000, pulses down to 10 us wide
+ *   trajectory   "rotate rpm=600 peak=80" solved by the chip
+ *   tach         2-pole tachometer, speed stepped 0..3000 rpm
+ *
+ * Settings, from the environment:
+ *   GOLDEN_TOLERANCE_NS  allowed |t - golden t| per edge, default 0 (exact)
+ *   GOLDEN_SLOWDOWN      allowed wall-time ratio to the golden, default 3,
+ *                        0 to report costs without judging them
+ *   GOLDEN_UPDATE=1      rewrite the golden files from this run instead
+ *                        (make golden-update)
+ * Wall time is the mean over at least GOLDEN_RUNS runs and GOLDEN_MIN_WALL_NS
+ * in total, as most scenarios take microseconds. The checked-in costs are
+ * only comparable on similar hardware.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define GOLDEN_DIR "bench/golden"
+#define GOLDEN_RUNS 5
+#define GOLDEN_MIN_WALL_NS 50000000ull
+#define MAX_EDGES 4096
+
+// invert: flips, their spacing, and the longest a flip may take to reach
+// OUT at the default poll ceiling: one 100 ms configuration period plus one
+// 100 ms poll
+#define INVERT_FLIPS 8
+#define INVERT_EVERY_NS HOST_MS(1370)
+#define INVERT_LATENCY_NS HOST_MS(200)
+
+// Sanitizer builds are slow by design (see the Makefile)
+#ifndef GOLDEN_SLOWDOWN_DEFAULT
+#define GOLDEN_SLOWDOWN_DEFAULT 3.0
+#endif
+
+typedef struct {
+  uint64_t at[MAX_EDGES];
+  uint32_t level[MAX_EDGES];
+  uint32_t count;
+  uint64_t wall_ns;
+} trace_t;
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+  bool (*check)(void);  // extra check on the recorded trace, NULL for none
+} scenario_t;
+
+static trace_t recorded;
+static trace_t golden;
+static FILE *report;
+static uint64_t invert_flip_ns[INVERT_FLIPS];
+
+static uint64_t wall_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void record_edge(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  (void)instance;
+  if (strcmp(pin, "OUT") == 0 && recorded.count < MAX_EDGES) {
+    recorded.at[recorded.count] = sim_ns;
+    recorded.level[recorded.count] = value;
+    recorded.count++;
+  }
+}
+
+static void sweep(void) {
+  chip_init();
+  uint64_t t = 0;
+  for (int pass = 0; pass < 3; pass++) {
+    for (int step = 0; step < 1000; step++) {
+      t += HOST_MS(10);
+      host_run_until(t);
+      host_attr_set_float("magneticField", 60.0 * (step < 500 ? step : 1000 - step) / 500.0);
+    }
+  }
+  host_run_until(t + HOST_SEC(1));
+}
+
+static void toggle(void) {
+  chip_init();
+  for (uint64_t t = HOST_MS(2); t <= HOST_SEC(1); t += HOST_MS(2)) {
+    host_run_until(t);
+    host_attr_set("magneticField", (t / HOST_MS(2)) % 2 ? 40 : 0);
+  }
+  host_run_until(HOST_MS(1100));
+}
+
+static void temperature(void) {
+  host_attr_set_float("temperature", -40.0);
+  chip_init();
+  for (int step = 1; step <= 250; step++) {
+    host_run_until(HOST_MS(40) * (uint64_t)step);
+    host_attr_set_float("temperature", step <= 125 ? -40.0 + step : 210.0 - step);
+    if (step % 5 == 0) {
+      host_attr_set("magneticField", step % 10 ? 24 : 18);
+    }
+  }
+  host_run_until(HOST_SEC(11));
+}
+
+static void power(void) {
+  host_attr_set("magneticField", 40);
+  chip_init();
+  for (uint64_t t = HOST_SEC(1); t <= HOST_SEC(5); t += HOST_SEC(1)) {
+    host_run_until(t);
+    host_pin_set("VCC", 0);
+    host_run_until(t + HOST_MS(50));
+    host_attr_set("magneticField", (t / HOST_SEC(1)) % 2 ? 0 : 40);
+    host_run_until(t + HOST_MS(100));
+    host_pin_set("VCC", 1);
+  }
+  host_run_until(HOST_SEC(6));
+}
+
+static void noninverted(void) {
+  host_attr_set("outputInverted", 0);
+  chip_init();
+  for (uint64_t t = HOST_MS(250); t <= HOST_SEC(5); t += HOST_MS(250)) {
+    host_run_until(t);
+    host_attr_set("magneticField", (t / HOST_MS(250)) % 2 ? 50 : 0);
+  }
+  host_run_until(HOST_MS(5500));
+}
+
+static void invert(void) {
+  host_attr_set("magneticField", 40);
+  chip_init();
+  for (uint32_t i = 0; i < INVERT_FLIPS; i++) {
+    invert_flip_ns[i] = HOST_SEC(1) + INVERT_EVERY_NS * i;
+    host_run_until(invert_flip_ns[i]);
+    host_attr_set("outputInverted", i % 2 ? 1 : 0);
+  }
+  host_run_until(HOST_SEC(1) + INVERT_EVERY_NS * INVERT_FLIPS);
+}
+
+// Time from each flip to the first OUT edge after it
+static bool invert_check(void) {
+  uint64_t worst = 0;
+  bool ok = true;
+  for (uint32_t i = 0; i < INVERT_FLIPS; i++) {
+    uint32_t e = 0;
+    while (e < recorded.count && recorded.at[e] < invert_flip_ns[i]) {
+      e++;
+    }
+    uint64_t end = i + 1 < INVERT_FLIPS ? invert_flip_ns[i + 1] : UINT64_MAX;
+    if (e == recorded.count || recorded.at[e] >= end) {
+      ok = false;
+      continue;
+    }
+    uint64_t latency = recorded.at[e] - invert_flip_ns[i];
+    worst = latency > worst ? latency : worst;
+  }
+  ok = ok && worst <= INVERT_LATENCY_NS;
+  fprintf(report, "  outputInverted to OUT: worst %.1f ms over %u flips, limit %.0f ms: %s\n", worst / 1e6,
+          INVERT_FLIPS, INVERT_LATENCY_NS / 1e6, ok ? "ok" : "SLOW");
+  return ok;
+}
+
+static void response(void) {
+  host_attr_set("pollMaxMicros", 250);
+  host_attr_set("responseNanos", 20000);
+  chip_init();
+  uint64_t t = HOST_MS(10);
+  for (uint64_t width = HOST_MS(5); width >= HOST_US(10); width /= 2) {
+    host_run_until(t);
+    host_attr_set("magneticField", 40);
+    host_run_until(t + width);
+    host_attr_set("magneticField", 0);
+    t += width + HOST_MS(10);
+  }
+  host_run_until(t);
+}
+
+static void trajectory(void) {
+  host_attr_set_string("trajectory", "rotate rpm=600 peak=80");
+  chip_init();
+  host_run_until(HOST_SEC(2));
+}
+
+static void tach(void) {
+  host_attr_set("tachPoles", 2);
+  chip_init();
+  for (uint32_t rpm = 0; rpm <= 3000; rpm += 500) {
+    host_attr_set("tachRpm", rpm);
+    host_run_for(HOST_MS(300));
+  }
+}
+
+static const scenario_t scenarios[] = {
+  {"sweep", sweep, NULL},
+  {"toggle", toggle, NULL},
+  {"temperature", temperature, NULL},
+  {"power", power, NULL},
+  {"noninverted", noninverted, NULL},
+  {"invert", invert, invert_check},
+  {"response", response, NULL},
+  {"trajectory", trajectory, NULL},
+  {"tach", tach, NULL},
+};
+
+static void run(const scenario_t *scenario) {
+  uint64_t total = 0;
+  uint32_t runs = 0;
+  while (runs < GOLDEN_RUNS || total < GOLDEN_MIN_WALL_NS) {
+    host_reset();
+    recorded.count = 0;
+    uint64_t begin = wall_ns();
+    scenario->run();
+    total += wall_ns() - begin;
+    runs++;
+  }
+  recorded.wall_ns = total / runs;
+}
+
+// Golden file: comment lines, "wall_ns N", "edges N", then "sim_ns level"
+// per edge
+static bool load(const char *path, trace_t *trace) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  char line[128];
+  unsigned long long at, value;
+  uint32_t expected = 0;
+  bool ok = true;
+  trace->count = 0;
+  trace->wall_ns = 0;
+  while (ok && fgets(line, sizeof(line), file)) {
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    } else if (sscanf(line, "wall_ns %llu", &value) == 1) {
+      trace->wall_ns = value;
+    } else if (sscanf(line, "edges %llu", &value) == 1) {
+      expected = (uint32_t)value;
+    } else if (sscanf(line, "%llu %llu", &at, &value) == 2 && trace->count < MAX_EDGES) {
+      trace->at[trace->count] = at;
+      trace->level[trace->count] = (uint32_t)value;
+      trace->count++;
+    } else {
+      ok = false;
+    }
+  }
+  fclose(file);
+  return ok && trace->count == expected;
+}
+
+static bool save(const char *path, const char *name, const trace_t *trace) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+  fprintf(file, "# a3144 golden OUT trace, scenario \"%s\" of bench/golden.c\n", name);
+  fprintf(file, "# regenerate with make golden-update after checking the change is intended\n");
+  fprintf(file, "wall_ns %lu\n", (unsigned long)trace->wall_ns);
+  fprintf(file, "edges %u\n", trace->count);
+  for (uint32_t i = 0; i < trace->count; i++) {
+    fprintf(file, "%lu %u\n", (unsigned long)trace->at[i], trace->level[i]);
+  }
+  return fclose(file) == 0;
+}
+
+static double env_double(const char *name, double fallback) {
+  const char *value = getenv(name);
+  return value && *value ? strtod(value, NULL) : fallback;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  host_set_pin_listener(record_edge);
+
+  uint64_t tolerance_ns = (uint64_t)env_double("GOLDEN_TOLERANCE_NS", 0);
+  double slowdown = env_double("GOLDEN_SLOWDOWN", GOLDEN_SLOWDOWN_DEFAULT);
+  const char *update = getenv("GOLDEN_UPDATE");
+  bool updating = update && strcmp(update, "1") == 0;
+  bool ok = true;
+
+  if (!updating) {
+    fprintf(report, "tolerance %lu ns, ", (unsigned long)tolerance_ns);
+    if (slowdown > 0) {
+      fprintf(report, "slowdown limit %.1fx\n", slowdown);
+    } else {
+      fprintf(report, "costs not judged\n");
+    }
+    fprintf(report, "%-12s %6s %6s %12s %9s %9s %6s  %s\n",
+            "scenario", "edges", "golden", "worst_dt_ns", "wall_us", "golden_us", "ratio", "result");
+  }
+  for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+    const scenario_t *scenario = &scenarios[s];
+    char path[256];
+    snprintf(path, sizeof(path), GOLDEN_DIR "/%s.txt", scenario->name);
+    run(scenario);
+
+    if (updating) {
+      bool saved = recorded.count < MAX_EDGES && save(path, scenario->name, &recorded);
+      fprintf(report, "%s %s: %u edges, %.1f us\n", saved ? "wrote" : "FAILED to write", path,
+              recorded.count, recorded.wall_ns / 1e3);
+      ok = ok && saved;
+      continue;
+    }
+    if (!load(path, &golden)) {
+      fprintf(report, "%-12s no readable golden trace %s (make golden-update)\n", scenario->name, path);
+      ok = false;
+      continue;
+    }
+
+    // Same edges in the same order, each within the tolerance
+    const char *result = "ok";
+    uint64_t worst_dt = 0;
+    uint32_t first_bad = UINT32_MAX;
+    uint32_t common = recorded.count < golden.count ? recorded.count : golden.count;
+    for (uint32_t i = 0; i < common; i++) {
+      uint64_t dt = recorded.at[i] > golden.at[i] ? recorded.at[i] - golden.at[i] : golden.at[i] - recorded.at[i];
+      worst_dt = dt > worst_dt ? dt : worst_dt;
+      if (first_bad == UINT32_MAX && (recorded.level[i] != golden.level[i] || dt > tolerance_ns)) {
+        first_bad = i;
+        result = recorded.level[i] != golden.level[i] ? "EDGES" : "TIMING";
+      }
+    }
+    if (recorded.count != golden.count) {
+      first_bad = first_bad == UINT32_MAX ? common : first_bad;
+      result = "EDGES";
+    }
+    double ratio = golden.wall_ns ? (double)recorded.wall_ns / (double)golden.wall_ns : 0;
+    if (first_bad == UINT32_MAX && slowdown > 0 && ratio > slowdown) {
+      result = "SLOWER";
+    }
+    ok = ok && strcmp(result, "ok") == 0;
+
+    fprintf(report, "%-12s %6u %6u %12lu %9.1f %9.1f %6.2f  %s\n", scenario->name, recorded.count,
+            golden.count, (unsigned long)worst_dt, recorded.wall_ns / 1e3, golden.wall_ns / 1e3, ratio, result);
+    if (first_bad != UINT32_MAX) {
+      fprintf(report, "  first difference at edge %u:", first_bad);
+      if (first_bad < recorded.count) {
+        fprintf(report, " got %lu ns level %u", (unsigned long)recorded.at[first_bad], recorded.level[first_bad]);
+      }
+      if (first_bad < golden.count) {
+        fprintf(report, " golden %lu ns level %u", (unsigned long)golden.at[first_bad], golden.level[first_bad]);
+      }
+      fprintf(report, "\n");
+    }
+    if (scenario->check) {
+      ok = scenario->check() && ok;
+    }
+  }
+
+  fclose(report);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+/*
+ * Native host import benchmark
+ *
+ * Calls the wokwi-api.h imports directly, the way a chip would, and reports
+ * what the host charges per call: the floor under every chip measurement
+ * made on it. Then plays the far end of each peripheral stand-in (UART,
+ * I2C, SPI, framebuffer, scheduled events) and checks the results, so every
+ * import the API declares is linked and exercised.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "wokwi-host.h"
+
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#undef timer_t
+
+#define CALLS 10000000u
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static volatile uint32_t sink;
+
+static void nothing(void *user_data) {
+  (void)user_data;
+}
+
+static void cost(const char *name, void (*body)(uint32_t calls)) {
+  host_reset();
+  double start = wall_seconds();
+  body(CALLS);
+  printf("%-18s %8.2f ns/call\n", name, (wall_seconds() - start) * 1e9 / CALLS);
+}
+
+static void bench_pin_read(uint32_t calls) {
+  pin_t pin = pin_init("IN", INPUT);
+  for (uint32_t i = 0; i < calls; i++) {
+    sink += pin_read(pin);
+  }
+}
+
+static void bench_pin_write(uint32_t calls) {
+  pin_t pin = pin_init("OUT", OUTPUT_LOW);
+  for (uint32_t i = 0; i < calls; i++) {
+    pin_write(pin, i & 1);
+  }
+}
+
+static void bench_attr_read(uint32_t calls) {
+  uint32_t attr = attr_init("value", 1);
+  for (uint32_t i = 0; i < calls; i++) {
+    sink += attr_read(attr);
+  }
+}
+
+static void bench_attr_read_float(uint32_t calls) {
+  uint32_t attr = attr_init_float("value", 1.5f);
+  for (uint32_t i = 0; i < calls; i++) {
+    sink += (uint32_t)attr_read_float(attr);
+  }
+}
+
+static void bench_timer_start(uint32_t calls) {
+  const timer_config_t config = {.callback = nothing, .user_data = NULL};
+  wokwi_timer_t timer = timer_init(&config);
+  for (uint32_t i = 0; i < calls; i++) {
+    timer_start(timer, 1000 + (i & 255), false);
+  }
+}
+
+static void bench_get_sim_nanos(uint32_t calls) {
+  for (uint32_t i = 0; i < calls; i++) {
+    sink += (uint32_t)get_sim_nanos();
+  }
+}
+
+// Peripheral checks
+
+static uint64_t write_done_at;
+static uint8_t i2c_register;
+static uint8_t spi_buffer[4];
+static uint32_t spi_done_count;
+static uint64_t event_order[3];
+static uint32_t event_count;
+
+static void on_write_done(void *user_data) {
+  (void)user_data;
+  write_done_at = host_now();
+}
+
+static bool on_i2c_connect(void *user_data, uint32_t address, bool read) {
+  (void)user_data;
+  (void)read;
+  return address == 0x42;
+}
+
+static uint8_t on_i2c_read(void *user_data) {
+  (void)user_data;
+  return i2c_register;
+}
+
+static bool on_i2c_write(void *user_data, uint8_t data) {
+  (void)user_data;
+  i2c_register = data;
+  return true;
+}
+
+static void on_spi_done(void *user_data, uint8_t *buffer, uint32_t count) {
+  (void)user_data;
+  (void)buffer;
+  (void)count;
+  spi_done_count++;
+}
+
+static void record_order(void *arg) {
+  event_order[event_count++] = (uint64_t)(uintptr_t)arg;
+}
+
+static bool check_peripherals(void) {
+  host_reset();
+  bool ok = true;
+
+  // UART: 10 bytes at 115200 baud take 100 bit times
+  const uart_config_t uart_config = {.baud_rate = 115200, .write_done = on_write_done};
+  uart_dev_t uart = uart_init(&uart_config);
+  uint8_t text[10] = "0123456789";
+  ok = ok && uart_write(uart, text, sizeof(text));
+  ok = ok && !uart_write(uart, text, 1);
+  host_run_for(HOST_MS(1));
+  uint32_t length;
+  const uint8_t *output = host_uart_output(uart, &length);
+  ok = ok && write_done_at == 100ull * 1000000000ull / 115200 && length == 10 && memcmp(output, text, 10) == 0;
+
+  // I2C: a one-register device at 0x42
+  const i2c_config_t i2c_config = {
+    .address = 0x42, .connect = on_i2c_connect, .read = on_i2c_read, .write = on_i2c_write,
+  };
+  uint32_t i2c = i2c_init(&i2c_config);
+  ok = ok && !host_i2c_connect(i2c, 0x10, false);
+  ok = ok && host_i2c_connect(i2c, 0x42, false) && host_i2c_write(i2c, 0x5a);
+  host_i2c_disconnect(i2c);
+  ok = ok && host_i2c_connect(i2c, 0x42, true) && host_i2c_read(i2c) == 0x5a;
+
+  // SPI: the chip's buffer goes out on MISO while MOSI fills it
+  const spi_config_t spi_config = {.done = on_spi_done};
+  spi_dev_t spi = spi_init(&spi_config);
+  memcpy(spi_buffer, "\x01\x02\x03\x04", 4);
+  spi_start(spi, spi_buffer, 4);
+  uint8_t miso[4];
+  ok = ok && host_spi_transfer(spi, (const uint8_t *)"\xa1\xa2\xa3\xa4", miso, 8) == 4;
+  ok = ok && spi_done_count == 1 && memcmp(miso, "\x01\x02\x03\x04", 4) == 0 &&
+       memcmp(spi_buffer, "\xa1\xa2\xa3\xa4", 4) == 0;
+  spi_stop(spi);
+
+  // Framebuffer and buffers
+  uint32_t width, height, size;
+  host_framebuffer_size(32, 16);
+  buffer_t fb = framebuffer_init(&width, &height);
+  uint32_t pixel = 0xff00ff00u, back = 0;
+  buffer_write(fb, 4 * (width * 2 + 3), &pixel, 4);
+  buffer_read(fb, 4 * (width * 2 + 3), &back, 4);
+  uint8_t *data = host_buffer_data(fb, &size);
+  ok = ok && width == 32 && height == 16 && size == 32 * 16 * 4 && back == pixel &&
+       memcmp(data + 4 * (width * 2 + 3), &pixel, 4) == 0;
+
+  // Analog pins
+  pin_t analog = pin_init("A0", ANALOG);
+  host_pin_set_voltage("A0", 1.25f);
+  ok = ok && pin_adc_read(analog) == 1.25f && pin_dac_write(analog, 3.0f) == 3.0f &&
+       host_pin_voltage("A0") == 3.0f;
+
+  // Events and chip timers sharing a nanosecond run in scheduling order
+  const timer_config_t config = {.callback = record_order, .user_data = (void *)(uintptr_t)2};
+  uint64_t at = host_now() + HOST_US(10);
+  event_count = 0;
+  host_schedule(at, record_order, (void *)(uintptr_t)1);
+  timer_start(timer_init(&config), 10, false);
+  host_schedule(at, record_order, (void *)(uintptr_t)3);
+  host_run_until(at);
+  ok = ok && event_count == 3 && event_order[0] == 1 && event_order[1] == 2 && event_order[2] == 3;
+
+  // No MCU on a native host
+  uint32_t word = 1;
+  ok = ok && !_symbol_resolve("main") && !_mcu_read_memory(NULL, &word, 4) && word == 0 &&
+       _mcu_read_uint32(NULL) == 0 && !_mcu_read_ptr(NULL) && _mcu_read_pc() == 0 && _mcu_read_sp() == 0;
+  const sp_monitor_config_t monitor = {0};
+  _mcu_monitor_sp(&monitor);
+  return ok;
+}
+
+int main(void) {
+  cost("pinRead", bench_pin_read);
+  cost("pinWrite", bench_pin_write);
+  cost("attrRead", bench_attr_read);
+  cost("attrReadFloat", bench_attr_read_float);
+  cost("timerStart", bench_timer_start);
+  cost("getSimNanos", bench_get_sim_nanos);
+  bool ok = check_peripherals();
+  printf("peripheral stand-ins: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/*
+ * A3144 multi-instance benchmark
+ *
+ * Creates 1,000 sensors on one host and pins all of them to the 250 us
+ * poll floor, so every tick of the shared schedule updates every sensor.
+ * Reports the chip's per-instance footprint (measured as the distance
+ * between the user_data pointers handed to timer_init), the host's own
+ * bookkeeping per instance, and sensor updates per wall-clock second.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define INSTANCES 1000
+#define SIM_MS 200
+
+static FILE *report;
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void run(const char *scenario, bool busy) {
+  host_reset();
+  for (uint32_t i = 0; i < INSTANCES; i++) {
+    if (i > 0) {
+      host_instance_new();
+    }
+    host_attr_set("pollMaxMicros", 250);
+    chip_init();
+  }
+
+  // The poll timers of consecutive instances carry consecutive pool slots;
+  // timers without user_data (the log flush timer) are skipped
+  char *slots[2];
+  for (uint32_t timer = 0, found = 0; found < 2; timer++) {
+    if (host_timer_user_data(timer)) {
+      slots[found++] = host_timer_user_data(timer);
+    }
+  }
+  size_t chip_bytes = (size_t)(slots[1] - slots[0]);
+
+  uint32_t lcg = 1;
+  double start = wall_seconds();
+  for (uint64_t t = HOST_MS(1); t <= HOST_MS(SIM_MS); t += HOST_MS(1)) {
+    host_run_until(t);
+    if (busy) {
+      // Move the field on a tenth of the sensors every millisecond
+      for (uint32_t i = 0; i < INSTANCES / 10; i++) {
+        lcg = lcg * 1103515245u + 12345u;
+        host_instance_select((lcg >> 8) % INSTANCES);
+        host_attr_set("magneticField", (lcg >> 16) % 101);
+      }
+    }
+  }
+  double elapsed = wall_seconds() - start;
+
+  const host_counters_t *c = host_counters();
+  fprintf(report, "%-6s %9u %10zu %10zu %14.0f %12.1f\n",
+          scenario, INSTANCES, chip_bytes, host_instance_bytes(),
+          (double)c->callbacks / elapsed,
+          (double)host_import_calls(c) / c->callbacks);
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  fprintf(report, "%-6s %9s %10s %10s %14s %12s\n",
+          "load", "instances", "chip_B", "host_B", "updates/s", "imports/upd");
+  run("idle", false);
+  run("busy", true);
+  fclose(report);
+  return 0;
+}
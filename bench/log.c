@@ -0,0 +1,77 @@
+/*
+ * Chip logging benchmark
+ *
+ * Compares the cost per logged event of the old printf path in
+ * update_output() with the chip-log ring: a record write on the hot path,
+ * and the write plus its share of a batched flush. Console output goes to
+ * /dev/null so only formatting and stdio costs are measured.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+// wokwi-api.h's timer_t clashes with the POSIX one from <time.h>
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#include "../common/chip-log.h"
+#undef timer_t
+
+#define EVENTS 2000000
+
+static const chip_log_event_t events[] = {
+  {"output", {"field", "inverted", "level"}, 0},
+};
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+  FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  host_reset();
+  chip_log_init("A3144", events);
+
+  double start = wall_seconds();
+  for (uint32_t i = 0; i < EVENTS; i++) {
+    printf("A3144: Magnetic field=%u, Inverted=%u, Output=%s\n",
+           i % 101, 1u, (i & 1) ? "HIGH" : "LOW");
+  }
+  double printf_ns = (wall_seconds() - start) * 1e9 / EVENTS;
+
+  start = wall_seconds();
+  for (uint32_t i = 0; i < EVENTS; i++) {
+    chip_log_info(0, i % 101, 1, i & 1);
+  }
+  double write_ns = (wall_seconds() - start) * 1e9 / EVENTS;
+  chip_log_reset();
+  chip_log_init("A3144", events);
+
+  start = wall_seconds();
+  for (uint32_t i = 0; i < EVENTS; i++) {
+    chip_log_info(0, i % 101, 1, i & 1);
+    if ((i & (CHIP_LOG_RING_SIZE - 1)) == CHIP_LOG_RING_SIZE - 1) {
+      chip_log_flush();
+    }
+  }
+  double flushed_ns = (wall_seconds() - start) * 1e9 / EVENTS;
+
+  fprintf(report, "%-24s %10s\n", "path", "ns/event");
+  fprintf(report, "%-24s %10.1f\n", "printf", printf_ns);
+  fprintf(report, "%-24s %10.1f\n", "ring write", write_ns);
+  fprintf(report, "%-24s %10.1f\n", "ring write + flush", flushed_ns);
+  fprintf(report, "record size %zu bytes, ring %d records\n",
+          sizeof(chip_log_record_t), CHIP_LOG_RING_SIZE);
+  fclose(report);
+  return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * A3144 output path micro-benchmark
+ *
+ * Pins the poll interval to the 250 us floor (pollMaxMicros=250) so every
+ * simulated second has the same number of ticks, then counts host imports
+ * per tick and per simulated second for a steady field and for a field
+ * dithering around the operate point. The previous update_output() made three
+ * imports per tick (2x attrRead + pinWrite) whatever the input did.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define SIM_SECONDS 10
+
+static FILE *report;
+
+// Field sequence applied every 5 ms; NULL keeps the field constant
+static void run(const char *scenario, uint32_t field, const uint32_t *dither, unsigned dither_len) {
+  host_reset();
+  host_attr_set("pollMaxMicros", 250);
+  host_attr_set("magneticField", field);
+  chip_init();
+
+  uint64_t end = HOST_SEC(SIM_SECONDS);
+  unsigned naive_edges = 0;
+  if (dither) {
+    bool above = field >= 25;
+    unsigned i = 0;
+    for (uint64_t t = HOST_MS(5); t < end; t += HOST_MS(5), i++) {
+      host_run_until(t);
+      uint32_t value = dither[i % dither_len];
+      host_attr_set("magneticField", value);
+      if ((value >= 25) != above) {
+        above = !above;
+        naive_edges++;
+      }
+    }
+  }
+  host_run_until(end);
+
+  const host_counters_t *c = host_counters();
+  double ticks = (double)c->callbacks;
+  uint64_t tick_imports = c->attr_read + c->pin_write + c->timer_start;
+  fprintf(report, "%-10s %10.0f %12.3f %12.1f %8lu %12u\n",
+          scenario, ticks / SIM_SECONDS,
+          (double)tick_imports / ticks,
+          (double)host_import_calls(c) / SIM_SECONDS,
+          (unsigned long)host_pin_edges("OUT"), naive_edges);
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  static const uint32_t dither[] = {22, 24, 26, 27, 25, 23, 21, 22, 24, 26};
+
+  fprintf(report, "%-10s %10s %12s %12s %8s %12s\n",
+          "scenario", "ticks/s", "imports/tick", "imports/s", "edges", "edges@25mT");
+  run("idle-low", 0, NULL, 0);
+  run("idle-high", 80, NULL, 0);
+  run("dither", 22, dither, sizeof(dither) / sizeof(dither[0]));
+  fprintf(report, "baseline: 3.000 imports/tick (%d imports/s at this tick rate)\n",
+          3 * 4000);
+  fclose(report);
+  return 0;
+}
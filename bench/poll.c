@@ -0,0 +1,71 @@
+/*
+ * A3144 polling benchmark
+ *
+ * Runs the chip against the native host on an idle sensor (no attribute
+ * changes) and a busy one (field moves every 20 ms) for several values of
+ * the pollMaxMicros ceiling, and reports polls per simulated second, host
+ * import calls per simulated second and the change-to-detection latency.
+ *
+ * The previous fixed 100 ms poll costs 10 polls/s (20 attrRead + 10 pinWrite)
+ * with a worst-case latency of 100 ms regardless of activity.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define SIM_SECONDS 60
+
+static FILE *report;
+
+static void run(const char *scenario, uint32_t poll_max_us, uint64_t change_every_ns) {
+  host_reset();
+  host_attr_set("pollMaxMicros", poll_max_us);
+  chip_init();
+
+  uint32_t lcg = 12345;
+  uint64_t end = HOST_SEC(SIM_SECONDS);
+  if (change_every_ns) {
+    for (uint64_t t = change_every_ns; t < end; t += change_every_ns) {
+      host_run_until(t);
+      lcg = lcg * 1103515245u + 12345u;
+      host_attr_set("magneticField", (lcg >> 16) % 101);
+    }
+  }
+  host_run_until(end);
+
+  const host_counters_t *c = host_counters();
+  const host_latency_t *l = host_latency();
+  fprintf(report, "%-6s %9u %12.1f %12.1f %12.1f %12.3f\n",
+          scenario, poll_max_us,
+          (double)c->callbacks / SIM_SECONDS,
+          (double)host_import_calls(c) / SIM_SECONDS,
+          l->samples ? (double)l->total_ns / l->samples / 1e6 : 0.0,
+          (double)l->worst_ns / 1e6);
+}
+
+int main(void) {
+  // Keep the chip's console output away from the report
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  static const uint32_t ceilings[] = {10000, 100000, 1000000};
+
+  fprintf(report, "%-6s %9s %12s %12s %12s %12s\n",
+          "load", "max_us", "polls/s", "imports/s", "mean_lat_ms", "worst_lat_ms");
+  for (unsigned i = 0; i < sizeof(ceilings) / sizeof(ceilings[0]); i++) {
+    run("idle", ceilings[i], 0);
+  }
+  for (unsigned i = 0; i < sizeof(ceilings) / sizeof(ceilings[0]); i++) {
+    run("busy", ceilings[i], HOST_MS(20));
+  }
+  fclose(report);
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * A3144 supply benchmark
+ *
+ * Runs 100 sensors per mode, then switches VCC off on all of them, then back
+ * on, and reports chip callbacks per simulated second in each phase. The
+ * unpowered window starts the moment the supply drops. Also checks that OUT
+ * is tri-stated while unpowered and, after power-up, follows the field and
+ * an outputInverted cleared while the supply was off.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+// For the pin levels and modes; its timer_t clashes with the POSIX one
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#undef timer_t
+
+#define INSTANCES 100
+#define PHASE_SECONDS 10
+
+static FILE *report;
+
+static uint64_t callbacks_over(uint64_t seconds) {
+  uint64_t before = host_counters()->callbacks;
+  host_run_for(HOST_SEC(seconds));
+  return host_counters()->callbacks - before;
+}
+
+static void set_vcc(uint32_t value) {
+  for (uint32_t i = 0; i < INSTANCES; i++) {
+    host_instance_select(i);
+    host_pin_set("VCC", value);
+  }
+}
+
+// OUT tri-stated (INPUT) on every instance, or driven (any output mode) on all
+static bool all_out_floating(bool floating) {
+  for (uint32_t i = 0; i < INSTANCES; i++) {
+    host_instance_select(i);
+    if ((host_pin_mode("OUT") == INPUT) != floating) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool run(const char *scenario, const char *trajectory, uint32_t tach_poles) {
+  host_reset();
+  for (uint32_t i = 0; i < INSTANCES; i++) {
+    if (i > 0) {
+      host_instance_new();
+    }
+    host_attr_set("pollMaxMicros", 1000);
+    host_attr_set("tachPoles", tach_poles);
+    host_attr_set("tachRpm", 6000);
+    host_attr_set_string("trajectory", trajectory);
+    chip_init();
+  }
+
+  double on = (double)callbacks_over(PHASE_SECONDS) / PHASE_SECONDS;
+
+  set_vcc(LOW);
+  bool floating = all_out_floating(true);
+  double off = (double)callbacks_over(PHASE_SECONDS) / PHASE_SECONDS;
+
+  // A magnet arrives and the output turns active HIGH while the sensors are off
+  for (uint32_t i = 0; i < INSTANCES; i++) {
+    host_instance_select(i);
+    host_attr_set_float("magneticField", 40.0);
+    host_attr_set("outputInverted", 0);
+  }
+  set_vcc(HIGH);
+  bool driven = all_out_floating(false);
+  host_instance_select(0);
+  bool follows = tach_poles || trajectory[0] || host_pin_get("OUT") == HIGH;
+  double again = (double)callbacks_over(PHASE_SECONDS) / PHASE_SECONDS;
+
+  bool ok = floating && driven && follows && off == 0 && again > 0;
+  fprintf(report, "%-11s %9u %12.1f %12.1f %12.1f %6s\n",
+          scenario, INSTANCES, on, off, again, ok ? "yes" : "NO");
+  return ok;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  fprintf(report, "%-11s %9s %12s %12s %12s %6s\n",
+          "mode", "instances", "cb/s_on", "cb/s_off", "cb/s_again", "ok");
+  bool ok = run("field", "", 0);
+  ok = run("trajectory", "rotate rpm=600 peak=80", 0) && ok;
+  ok = run("tachometer", "", 5) && ok;
+  fclose(report);
+  return ok ? 0 : 1;
+}
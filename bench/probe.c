@@ -0,0 +1,130 @@
+/*
+ * A3144 import instrumentation benchmark
+ *
+ * Built with CHIP_PROBE (see the Makefile), so every import the chip calls
+ * is counted and timed by common/chip-probe.h. Runs a busy sensor for 60
+ * simulated seconds: field moves every 20 ms across the switch points and
+ * VCC drops for 100 ms every 10 s. Then prints the probe's own summary,
+ * taken on demand through chip_probe_dump(), and checks its counts against
+ * what the native host saw: every import call, and every callback.
+ *
+ * Also reports the probe clock's cost; each probed call reads it twice.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+void chip_probe_dump(void);
+
+#define SIM_SECONDS 60
+#define MOVE_EVERY_NS HOST_MS(20)
+#define VCC_EVERY_NS HOST_SEC(10)
+#define VCC_DROP_NS HOST_MS(100)
+#define CLOCK_READS 1000000u
+#define DUMP_FILE "build/bench-probe.txt"
+
+static FILE *report;
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void run(void) {
+  host_reset();
+  chip_init();
+  uint32_t lcg = 12345;
+  for (uint64_t t = MOVE_EVERY_NS; t <= HOST_SEC(SIM_SECONDS); t += MOVE_EVERY_NS) {
+    host_run_until(t);
+    lcg = lcg * 1103515245u + 12345u;
+    host_attr_set("magneticField", (lcg >> 16) % 101);
+    if (t % VCC_EVERY_NS == 0) {
+      host_pin_set("VCC", 0);
+    } else if (t % VCC_EVERY_NS == VCC_DROP_NS) {
+      host_pin_set("VCC", 1);
+    }
+  }
+}
+
+// Calls per name from the summary lines, "probe: <name> <calls> ..."
+static uint64_t dumped_calls(const char *path, const char *name) {
+  FILE *file = fopen(path, "r");
+  char line[256], row[32];
+  unsigned long long calls, total = 0;
+  while (file && fgets(line, sizeof(line), file)) {
+    if (sscanf(line, "probe: %31s %llu", row, &calls) == 2 && strcmp(row, name) == 0) {
+      total += calls;
+    }
+  }
+  if (file) {
+    fclose(file);
+  }
+  return total;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  double begin = wall_seconds();
+  run();
+  double elapsed = wall_seconds() - begin;
+  const host_counters_t *counters = host_counters();
+
+  // The summary goes to stdout, so point stdout at a file for the dump
+  bool ok = freopen(DUMP_FILE, "w", stdout) != NULL;
+  chip_probe_dump();
+  ok = freopen("/dev/null", "w", stdout) && ok;
+
+  static const char *const imports[] = {
+    "pinInit", "pinRead", "pinWrite", "pinWatch", "pinWatchStop", "pinMode", "pinADCRead",
+    "pinDACWrite", "stringGetLength", "stringRead", "attrInit", "attrInitFloat", "attrRead",
+    "attrReadFloat", "attrStringInit", "i2cInit", "uartInit", "uartWrite", "spiInit", "spiStart",
+    "spiStop", "timerInit", "timerStart", "timerStartNanos", "timerStop", "getSimNanos",
+    "framebufferInit", "bufferRead", "bufferWrite",
+  };
+  uint64_t probed = 0;
+  for (size_t i = 0; i < sizeof(imports) / sizeof(imports[0]); i++) {
+    probed += dumped_calls(DUMP_FILE, imports[i]);
+  }
+  uint64_t callbacks = dumped_calls(DUMP_FILE, "callbacks");
+  ok = ok && probed == host_import_calls(counters) && callbacks == counters->callbacks &&
+       dumped_calls(DUMP_FILE, "attrRead") + dumped_calls(DUMP_FILE, "attrReadFloat") == counters->attr_read &&
+       dumped_calls(DUMP_FILE, "pinWrite") == counters->pin_write;
+
+  FILE *dump = fopen(DUMP_FILE, "r");
+  char line[256];
+  fprintf(report, "busy sensor for %u s, %.1f ms wall, summary from chip_probe_dump():\n", SIM_SECONDS,
+          elapsed * 1e3);
+  while (dump && fgets(line, sizeof(line), dump)) {
+    fprintf(report, "  %s", line);
+  }
+  if (dump) {
+    fclose(dump);
+  }
+  fprintf(report, "  probe counted %lu imports and %lu callbacks, host %lu and %lu: %s\n",
+          (unsigned long)probed, (unsigned long)callbacks, (unsigned long)host_import_calls(counters),
+          (unsigned long)counters->callbacks, ok ? "match" : "MISMATCH");
+  unlink(DUMP_FILE);
+
+  struct timespec ts;
+  begin = wall_seconds();
+  for (uint32_t i = 0; i < CLOCK_READS; i++) {
+    timespec_get(&ts, TIME_UTC);
+  }
+  fprintf(report, "probe clock: %.1f ns per read, two per probed call\n",
+          (wall_seconds() - begin) * 1e9 / CLOCK_READS);
+
+  fclose(report);
+  return ok ? 0 : 1;
+}
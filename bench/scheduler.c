@@ -0,0 +1,102 @@
+/*
+ * Native host scheduler benchmark
+ *
+ * Runs the same timer load on the timing wheel and on the binary heap and
+ * reports wall-clock ns per callback. Loads:
+ *   repeat   N repeating timers, periods spread over 100 us - 10 ms
+ *   rearm    N one-shot timers, each callback re-arms its own timer with a
+ *            fresh delay and cancels another one, which the next callback
+ *            that lands on it starts again
+ * Every callback folds (timer, sim time) into a checksum; the two schedulers
+ * must produce the same one, that is the same callbacks in the same order.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "wokwi-host.h"
+
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#undef timer_t
+
+#define CALLBACKS 2000000u
+#define MAX_TIMERS 100000u
+
+static wokwi_timer_t handles[MAX_TIMERS];
+static uint32_t timer_total;
+static uint32_t lcg;
+static uint64_t checksum;
+static bool rearm;
+
+static double wall_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t lcg_next(void) {
+  lcg = lcg * 1103515245u + 12345u;
+  return lcg >> 8;
+}
+
+static uint32_t random_delay_ns(void) {
+  return 100000 + lcg_next() % 9900000;
+}
+
+static void on_timer(void *user_data) {
+  uint32_t id = (uint32_t)(uintptr_t)user_data;
+  checksum = (checksum ^ (id + host_now())) * 0x100000001b3ull;
+  if (rearm) {
+    timer_start_ns(handles[id], random_delay_ns(), false);
+    uint32_t other = lcg_next() % timer_total;
+    if (other != id) {
+      timer_stop(handles[other]);
+      timer_start_ns(handles[(other + 1) % timer_total], random_delay_ns(), false);
+    }
+  }
+}
+
+static double run(host_scheduler_t queue, uint32_t count, bool one_shot, uint64_t *sum) {
+  host_set_scheduler(queue);
+  host_reset();
+  timer_total = count;
+  rearm = one_shot;
+  lcg = 1;
+  checksum = 0xcbf29ce484222325ull;
+  for (uint32_t i = 0; i < count; i++) {
+    const timer_config_t config = {.callback = on_timer, .user_data = (void *)(uintptr_t)i};
+    handles[i] = timer_init(&config);
+    timer_start_ns(handles[i], random_delay_ns(), !one_shot);
+  }
+
+  double start = wall_ns();
+  while (host_counters()->callbacks < CALLBACKS) {
+    host_run_for(HOST_MS(1));
+  }
+  double elapsed = wall_ns() - start;
+  *sum = checksum;
+  return elapsed / (double)host_counters()->callbacks;
+}
+
+int main(void) {
+  static const uint32_t counts[] = {10, 1000, 100000};
+  bool ok = true;
+
+  printf("%-7s %7s %10s %10s %7s %6s\n", "load", "timers", "heap_ns", "wheel_ns", "speedup", "same");
+  for (int one_shot = 0; one_shot <= 1; one_shot++) {
+    for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+      uint64_t heap_sum, wheel_sum;
+      double heap_ns = run(HOST_SCHEDULER_HEAP, counts[i], one_shot, &heap_sum);
+      double wheel_ns = run(HOST_SCHEDULER_WHEEL, counts[i], one_shot, &wheel_sum);
+      bool same = heap_sum == wheel_sum;
+      ok = ok && same;
+      printf("%-7s %7u %10.1f %10.1f %6.2fx %6s\n", one_shot ? "rearm" : "repeat", counts[i],
+             heap_ns, wheel_ns, heap_ns / wheel_ns, same ? "yes" : "NO");
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/*
+ * A3144 sharded regression benchmark
+ *
+ * A regression farm in miniature: 512 independent scenarios, each a shard
+ * of its own run through host_shard_run() on 1, 2, 4 and 8 workers.
+ *   even shards  threshold sweep: field ramped 0-40-0 mT in 0.05 mT steps
+ *                every millisecond, at a temperature from -40 to 150 °C
+ *   odd shards   toggle rate: field toggling between 5 and 40 mT for one
+ *                simulated second, at 10 Hz to 1.3 kHz
+ * Every shard records its OUT edges (count and a checksum of times and
+ * levels) and the callbacks it took. Reports shards per wall-clock second,
+ * the speedup over one worker, steals, and whether every shard's results
+ * match the one-worker run exactly.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-shard.h"
+
+void chip_init(void);
+
+#define SHARDS 512
+
+typedef struct {
+  uint32_t edges;
+  uint64_t checksum;
+  uint64_t callbacks;
+} shard_result_t;
+
+static shard_result_t baseline[SHARDS];
+static shard_result_t results[SHARDS];
+static _Thread_local shard_result_t *recording;
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void record_edge(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  (void)instance;
+  (void)pin;
+  recording->edges++;
+  recording->checksum = (recording->checksum ^ (sim_ns * 2 + value)) * 0x100000001b3ull;
+}
+
+static void threshold_sweep(uint32_t index) {
+  host_attr_set_float("temperature", -40.0 + (double)(index % 96) * 2.0);
+  host_attr_set("pollMaxMicros", 1000);
+  chip_init();
+  for (uint32_t step = 0; step <= 1600; step++) {
+    host_run_for(HOST_MS(1));
+    uint32_t level = step <= 800 ? step : 1600 - step;
+    host_attr_set_float("magneticField", level * 0.05);
+  }
+}
+
+static void toggle_rate(uint32_t index) {
+  uint64_t half_period_ns = HOST_SEC(1) / (2 * (10 + (uint64_t)index * 5));
+  chip_init();
+  bool high = false;
+  for (uint64_t t = half_period_ns; t < HOST_SEC(1); t += half_period_ns) {
+    host_run_until(t);
+    high = !high;
+    host_attr_set_float("magneticField", high ? 40.0 : 5.0);
+  }
+}
+
+static void run_shard(uint32_t shard, void *context) {
+  shard_result_t *out = &((shard_result_t *)context)[shard];
+  memset(out, 0, sizeof(*out));
+  out->checksum = 0xcbf29ce484222325ull;
+  recording = out;
+  host_set_pin_listener(record_edge);
+  if (shard % 2 == 0) {
+    threshold_sweep(shard / 2);
+  } else {
+    toggle_rate(shard / 2);
+  }
+  out->callbacks = host_counters()->callbacks;
+}
+
+int main(void) {
+  FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  static const uint32_t workers[] = {1, 2, 4, 8};
+  double base_rate = 0;
+  bool ok = true;
+
+  fprintf(report, "online CPUs: %ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+  fprintf(report, "%7s %7s %10s %12s %8s %7s %5s\n",
+          "workers", "shards", "wall_ms", "shards/s", "speedup", "steals", "same");
+  for (unsigned i = 0; i < sizeof(workers) / sizeof(workers[0]); i++) {
+    shard_result_t *out = i == 0 ? baseline : results;
+    host_shard_stats_t stats;
+    double start = wall_seconds();
+    ok = host_shard_run(SHARDS, workers[i], run_shard, out, &stats) && ok;
+    double elapsed = wall_seconds() - start;
+    double rate = SHARDS / elapsed;
+    base_rate = i == 0 ? rate : base_rate;
+
+    bool same = memcmp(baseline, out, sizeof(baseline)) == 0;
+    ok = ok && same;
+    fprintf(report, "%7u %7u %10.1f %12.1f %7.2fx %7lu %5s\n",
+            workers[i], SHARDS, elapsed * 1e3, rate, rate / base_rate,
+            (unsigned long)stats.steals, same ? "yes" : "NO");
+  }
+  fclose(report);
+  return ok ? 0 : 1;
+}
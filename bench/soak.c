@@ -0,0 +1,141 @@
+/*
+ * A3144 soak benchmark
+ *
+ * Four simulated hours with a magnet passing once a minute (40 mT for
+ * 200 ms) and outputInverted flipped every ten minutes between passes, all
+ * scheduled up front as host events. The flips reach OUT on the chip's next
+ * config read, so their edges also show whether fast-forward shifted when
+ * the chip picks up its configuration. The chip's poll
+ * ceiling is set to the default 100 ms, 1 ms and 250 us, and each is run
+ * three times:
+ *   plain    every callback runs
+ *   fast     idle fast-forward on, quiet after 16 callbacks
+ *   strict   same, but the skipped callbacks run and are checked to have
+ *            no effect
+ * Reports wall time, the speedup over the plain run, callbacks run and
+ * skipped, and whether the OUT edges match the plain run's exactly.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define SOAK_HOURS 4
+#define PASS_EVERY_S 60
+#define PASS_MS 200
+#define FLIP_EVERY_S 600
+#define QUIET_CALLBACKS 16
+#define MAX_EDGES 1024
+
+typedef struct {
+  uint64_t at[MAX_EDGES];
+  uint32_t level[MAX_EDGES];
+  uint32_t count;
+} edges_t;
+
+static edges_t plain_edges;
+static edges_t run_edges;
+static edges_t *recording;
+static FILE *report;
+
+static double wall_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void record_edge(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  (void)instance;
+  (void)pin;
+  if (recording->count < MAX_EDGES) {
+    recording->at[recording->count] = sim_ns;
+    recording->level[recording->count] = value;
+    recording->count++;
+  }
+}
+
+static void set_field(void *arg) {
+  host_attr_set_float("magneticField", (double)(uintptr_t)arg);
+}
+
+static void set_inverted(void *arg) {
+  host_attr_set("outputInverted", (uint32_t)(uintptr_t)arg);
+}
+
+static double run(uint32_t poll_max_us, uint32_t quiet_callbacks, bool strict, edges_t *edges) {
+  host_set_fast_forward(quiet_callbacks, strict);
+  host_reset();
+  host_attr_set("pollMaxMicros", poll_max_us);
+  edges->count = 0;
+  recording = edges;
+  chip_init();
+  for (uint64_t t = HOST_SEC(PASS_EVERY_S); t < HOST_SEC(SOAK_HOURS * 3600); t += HOST_SEC(PASS_EVERY_S)) {
+    host_schedule(t, set_field, (void *)(uintptr_t)40);
+    host_schedule(t + HOST_MS(PASS_MS), set_field, (void *)(uintptr_t)0);
+  }
+  uint32_t inverted = 1;
+  for (uint64_t t = HOST_SEC(FLIP_EVERY_S / 2 + PASS_EVERY_S / 2); t < HOST_SEC(SOAK_HOURS * 3600);
+       t += HOST_SEC(FLIP_EVERY_S)) {
+    inverted = !inverted;
+    host_schedule(t, set_inverted, (void *)(uintptr_t)inverted);
+  }
+
+  double start = wall_ms();
+  host_run_until(HOST_SEC(SOAK_HOURS * 3600));
+  return wall_ms() - start;
+}
+
+static bool same_edges(const edges_t *a, const edges_t *b) {
+  if (a->count != b->count) {
+    return false;
+  }
+  for (uint32_t i = 0; i < a->count; i++) {
+    if (a->at[i] != b->at[i] || a->level[i] != b->level[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool soak(uint32_t poll_max_us) {
+  static const char *const modes[] = {"plain", "fast", "strict"};
+  double plain_ms = 0;
+  bool ok = true;
+  for (int mode = 0; mode < 3; mode++) {
+    edges_t *edges = mode == 0 ? &plain_edges : &run_edges;
+    double ms = run(poll_max_us, mode == 0 ? 0 : QUIET_CALLBACKS, mode == 2, edges);
+    plain_ms = mode == 0 ? ms : plain_ms;
+    bool same = same_edges(&plain_edges, edges);
+    ok = ok && same;
+
+    const host_fast_forward_t *ff = host_fast_forward_stats();
+    fprintf(report, "%7u %-7s %10.2f %9.1fx %11lu %11lu %6u %5s\n",
+            poll_max_us, modes[mode], ms, plain_ms / ms,
+            (unsigned long)host_counters()->callbacks, (unsigned long)ff->skipped_callbacks,
+            edges->count, same ? "yes" : "NO");
+  }
+  return ok;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  host_set_pin_listener(record_edge);
+
+  fprintf(report, "%7s %-7s %10s %10s %11s %11s %6s %5s\n",
+          "max_us", "mode", "wall_ms", "speedup", "callbacks", "skipped", "edges", "same");
+  bool ok = soak(100000);
+  ok = soak(1000) && ok;
+  ok = soak(250) && ok;
+  host_set_fast_forward(0, false);
+  fclose(report);
+  return ok ? 0 : 1;
+}
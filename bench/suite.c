@@ -0,0 +1,152 @@
+/*
+ * A3144 scenario suite
+ *
+ * The numbers to judge a chip.c change by. Each scenario runs in a child
+ * process of its own so that peak memory is per scenario, and the results
+ * are printed as one JSON document:
+ *   sim_per_wall        simulated ns per wall-clock ns
+ *   attr_read_per_s     attrRead(+Float) calls per simulated second
+ *   pin_write_per_s     pinWrite calls per simulated second
+ *   timer_calls_per_s   timerInit/Start/Stop calls per simulated second
+ *   callbacks_per_s     callbacks into the chip per simulated second
+ *   imports_per_s       all imports per simulated second
+ *   peak_rss_kb         peak resident set of the scenario's process
+ *
+ * Scenarios:
+ *   idle         one sensor, constant field, default poll ceiling
+ *   slow_sweep   one sensor, field dragged 0-60-0 mT over 10 s in 10 ms steps
+ *   fast_toggle  one sensor, field toggling across the switch points every 1 ms
+ *   instances    1,000 sensors, each slider moved about once a second
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+static FILE *report;
+
+static double wall_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void init_instances(uint32_t count) {
+  host_reset();
+  for (uint32_t i = 0; i < count; i++) {
+    if (i > 0) {
+      host_instance_new();
+    }
+    chip_init();
+  }
+}
+
+static void idle(void) {
+  init_instances(1);
+  host_run_until(HOST_SEC(60));
+}
+
+static void slow_sweep(void) {
+  init_instances(1);
+  for (uint64_t t = HOST_MS(10); t <= HOST_SEC(60); t += HOST_MS(10)) {
+    host_run_until(t);
+    uint64_t phase_ms = (t / HOST_MS(1)) % 10000;
+    double field = phase_ms < 5000 ? phase_ms * 0.012 : (10000 - phase_ms) * 0.012;
+    host_attr_set_float("magneticField", field);
+  }
+}
+
+static void fast_toggle(void) {
+  init_instances(1);
+  bool high = false;
+  for (uint64_t t = HOST_MS(1); t <= HOST_SEC(10); t += HOST_MS(1)) {
+    host_run_until(t);
+    high = !high;
+    host_attr_set_float("magneticField", high ? 40.0 : 5.0);
+  }
+}
+
+static void instances(void) {
+  init_instances(1000);
+  uint32_t lcg = 1;
+  for (uint64_t t = HOST_MS(1); t <= HOST_SEC(10); t += HOST_MS(1)) {
+    host_run_until(t);
+    lcg = lcg * 1103515245u + 12345u;
+    host_instance_select((lcg >> 8) % 1000);
+    host_attr_set_float("magneticField", (lcg >> 16) % 61);
+  }
+}
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+  {"idle", idle},
+  {"slow_sweep", slow_sweep},
+  {"fast_toggle", fast_toggle},
+  {"instances", instances},
+};
+
+static void run_scenario(const scenario_t *scenario) {
+  double start = wall_ns();
+  scenario->run();
+  double elapsed = wall_ns() - start;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  const host_counters_t *c = host_counters();
+  double sim_s = (double)host_now() / 1e9;
+  fprintf(report,
+          "    {\"name\": \"%s\", \"instances\": %u, \"sim_ns\": %lu, \"wall_ns\": %.0f, "
+          "\"sim_per_wall\": %.1f, \"attr_read_per_s\": %.1f, \"pin_write_per_s\": %.1f, "
+          "\"timer_calls_per_s\": %.1f, \"callbacks_per_s\": %.1f, \"imports_per_s\": %.1f, "
+          "\"peak_rss_kb\": %ld}",
+          scenario->name, host_instance_count(), (unsigned long)host_now(), elapsed,
+          (double)host_now() / elapsed,
+          c->attr_read / sim_s, c->pin_write / sim_s,
+          (c->timer_init + c->timer_start + c->timer_stop) / sim_s,
+          c->callbacks / sim_s, host_import_calls(c) / sim_s,
+          usage.ru_maxrss);
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  fprintf(report, "{\n  \"chip\": \"a3144\",\n  \"scenarios\": [\n");
+  uint32_t count = sizeof(scenarios) / sizeof(scenarios[0]);
+  for (uint32_t i = 0; i < count; i++) {
+    fflush(report);
+    pid_t child = fork();
+    if (child < 0) {
+      return 1;
+    }
+    if (child == 0) {
+      run_scenario(&scenarios[i]);
+      fflush(report);
+      _exit(0);
+    }
+    int status;
+    if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      return 1;
+    }
+    fprintf(report, "%s\n", i + 1 < count ? "," : "");
+  }
+  fprintf(report, "  ]\n}\n");
+  fclose(report);
+  return 0;
+}
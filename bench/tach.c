@@ -0,0 +1,77 @@
+/*
+ * A3144 tachometer mode benchmark
+ *
+ * Runs pulse trains up to ~100 kHz edge rate for millions of edges and
+ * reports OUT edges per wall-clock second, host imports per edge, and the
+ * drift of the last edge from its exact time k * 60 s / edges_per_min.
+ * Speeds that divide a minute into whole nanoseconds run on a repeating
+ * timer; the others re-arm on every edge.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+static uint64_t edge_count;
+static uint64_t last_edge_ns;
+
+static void count_edge(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  (void)instance;
+  (void)pin;
+  (void)value;
+  edge_count++;
+  last_edge_ns = sim_ns;
+}
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void run(FILE *report, uint32_t poles, uint32_t rpm, uint32_t sim_seconds) {
+  host_reset();
+  host_attr_set("tachPoles", poles);
+  host_attr_set("tachRpm", rpm);
+  chip_init();
+  edge_count = 0;
+
+  double start = wall_seconds();
+  host_run_until(HOST_SEC(sim_seconds));
+  double elapsed = wall_seconds() - start;
+
+  // The train starts at t=0, so edge k is due at floor(k * 1 min / edges_per_min)
+  uint64_t edges_per_min = 2ull * poles * rpm;
+  uint64_t expected_ns = (uint64_t)((unsigned __int128)edge_count * 60000000000ull / edges_per_min);
+  int64_t drift_ns = (int64_t)(last_edge_ns - expected_ns);
+
+  const host_counters_t *c = host_counters();
+  fprintf(report, "%6u %7u %11.0f %10lu %14.0f %12.3f %10ld\n",
+          poles, rpm, edges_per_min / 60.0, (unsigned long)edge_count,
+          edge_count / elapsed,
+          (double)host_import_calls(c) / edge_count, (long)drift_ns);
+}
+
+int main(void) {
+  FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  host_set_pin_listener(count_edge);
+
+  fprintf(report, "%6s %7s %11s %10s %14s %12s %10s\n",
+          "poles", "rpm", "edges/sim_s", "edges", "edges/wall_s", "imports/edge", "drift_ns");
+  run(report, 5, 6000, 60);       // 1 kHz, whole-ns interval
+  run(report, 50, 6000, 60);      // 10 kHz
+  run(report, 50, 60000, 30);     // 100 kHz
+  run(report, 7, 5999, 60);       // fractional interval, re-armed per edge
+  run(report, 49, 61223, 30);     // ~100 kHz, fractional
+  fclose(report);
+  return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * A3144 stimulus trace benchmark
+ *
+ * Record and replay: four sensors for five simulated minutes, one slider
+ * moved by a 0.1 mT random walk step around the switch points every
+ * millisecond (round robin), and one sensor's VCC dropped for a second
+ * every 30 s. The run is recorded, then replayed into fresh sensors;
+ * reports wall time of the plain, recording and replaying runs, trace bytes
+ * per input against a fixed 24-byte record (time, name id, value), and
+ * whether the replay reproduced every OUT edge and chip callback.
+ *
+ * Streaming: a chip-less trace of 32M slider moves, one per simulated
+ * microsecond, replayed in a child process. Reports the replay rate in
+ * records and MB per second next to plain read() of the same file (both from
+ * the page cache, the file having just been written), and the replay's peak
+ * resident size against the file size.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-trace.h"
+
+void chip_init(void);
+
+#define SENSORS 4
+#define SIM_SECONDS 300
+#define VCC_EVERY_S 30
+#define STREAM_RECORDS (32u << 20)
+#define FIXED_RECORD_BYTES 24
+#define SENSOR_TRACE "build/bench-trace-sensors.wktr"
+#define STREAM_TRACE "build/bench-trace-stream.wktr"
+
+typedef struct {
+  uint32_t edges[SENSORS];
+  uint64_t checksum[SENSORS];
+  uint64_t callbacks;
+} outcome_t;
+
+static outcome_t *recording;
+static FILE *report;
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void record_edge(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  (void)pin;
+  recording->edges[instance]++;
+  recording->checksum[instance] = (recording->checksum[instance] ^ (sim_ns * 2 + value)) * 0x100000001b3ull;
+}
+
+static void start(outcome_t *outcome) {
+  *outcome = (outcome_t){0};
+  recording = outcome;
+  host_set_pin_listener(record_edge);
+  host_reset();
+  for (uint32_t i = 1; i < SENSORS; i++) {
+    host_instance_new();
+  }
+}
+
+static void init_sensors(void) {
+  for (uint32_t i = 0; i < SENSORS; i++) {
+    host_instance_select(i);
+    chip_init();
+  }
+}
+
+// The driving program the trace captures
+static double drive(outcome_t *outcome) {
+  start(outcome);
+  for (uint32_t i = 0; i < SENSORS; i++) {
+    host_instance_select(i);
+    host_attr_set("pollMaxMicros", 1000);
+  }
+  init_sensors();
+
+  int32_t position[SENSORS] = {225, 225, 225, 225};   // 22.5 mT, between the switch points
+  uint32_t lcg = 1;
+  double begin = wall_seconds();
+  for (uint64_t step = 1; step <= (uint64_t)SIM_SECONDS * 1000; step++) {
+    host_run_until(HOST_MS(step));
+    uint32_t i = step % SENSORS;
+    lcg = lcg * 1103515245u + 12345u;
+    position[i] += (lcg >> 16) & 1 ? 1 : -1;
+    position[i] = position[i] < 0 ? 1 : position[i] > 400 ? 399 : position[i];
+    host_instance_select(i);
+    host_attr_set_float("magneticField", position[i] / 10.0);
+    if (step % (VCC_EVERY_S * 1000) == 0) {
+      host_instance_select((step / 1000) % SENSORS);
+      host_pin_set("VCC", 0);
+    } else if (step % (VCC_EVERY_S * 1000) == 1000) {
+      host_instance_select((step / 1000 - 1) % SENSORS);
+      host_pin_set("VCC", 1);
+    }
+  }
+  host_run_until(HOST_SEC(SIM_SECONDS) + HOST_MS(1));
+  outcome->callbacks = host_counters()->callbacks;
+  return wall_seconds() - begin;
+}
+
+static double replay(outcome_t *outcome, bool *ok) {
+  start(outcome);
+  host_trace_t *trace = host_trace_open(SENSOR_TRACE);
+  if (!trace) {
+    *ok = false;
+    return 0;
+  }
+  *ok = host_trace_replay_until(trace, 0);
+  init_sensors();
+  double begin = wall_seconds();
+  *ok = host_trace_replay_until(trace, HOST_SEC(SIM_SECONDS) + HOST_MS(1)) && *ok;
+  *ok = host_trace_done(trace) && *ok;
+  outcome->callbacks = host_counters()->callbacks;
+  double elapsed = wall_seconds() - begin;
+  host_reset();
+  host_trace_close(trace);
+  return elapsed;
+}
+
+static bool sensors(void) {
+  outcome_t plain, recorded, replayed;
+  double plain_s = drive(&plain);
+
+  uint64_t records = 0, bytes = 0;
+  bool ok = host_trace_record(SENSOR_TRACE);
+  double record_s = drive(&recorded);
+  ok = host_trace_stop(&records, &bytes) && ok;
+
+  bool replay_ok;
+  double replay_s = replay(&replayed, &replay_ok);
+  ok = ok && replay_ok;
+  bool same = ok && memcmp(&plain, &replayed, sizeof(plain)) == 0 &&
+              memcmp(&plain, &recorded, sizeof(plain)) == 0;
+  uint32_t edges = 0;
+  for (uint32_t i = 0; i < SENSORS; i++) {
+    edges += plain.edges[i];
+  }
+
+  fprintf(report, "sensors: %u x %u s, %lu records, %lu bytes (%.2f per record, %.1fx smaller than %u)\n",
+          SENSORS, SIM_SECONDS, (unsigned long)records, (unsigned long)bytes,
+          (double)bytes / records, (double)records * FIXED_RECORD_BYTES / bytes, FIXED_RECORD_BYTES);
+  fprintf(report, "  %-8s %9s\n", "run", "wall_ms");
+  fprintf(report, "  %-8s %9.1f\n", "plain", plain_s * 1e3);
+  fprintf(report, "  %-8s %9.1f\n", "record", record_s * 1e3);
+  fprintf(report, "  %-8s %9.1f\n", "replay", replay_s * 1e3);
+  fprintf(report, "  %u edges, %lu callbacks, replay identical: %s\n",
+          edges, (unsigned long)plain.callbacks, same ? "yes" : "NO");
+  unlink(SENSOR_TRACE);
+  return same;
+}
+
+static bool write_stream(uint64_t *bytes) {
+  host_reset();
+  uint64_t records;
+  bool ok = host_trace_record(STREAM_TRACE);
+  int32_t position = 0;
+  uint32_t lcg = 1;
+  for (uint32_t i = 0; i < STREAM_RECORDS; i++) {
+    host_run_for(HOST_US(1));
+    lcg = lcg * 1103515245u + 12345u;
+    position += (lcg >> 16) & 1 ? 1 : -1;
+    host_attr_set_float("magneticField", position / 10.0);
+  }
+  ok = host_trace_stop(&records, bytes) && ok;
+  host_reset();
+  return ok && records == STREAM_RECORDS + 1;
+}
+
+static double read_stream(void) {
+  static char chunk[1 << 20];
+  int fd = open(STREAM_TRACE, O_RDONLY);
+  double begin = wall_seconds();
+  while (fd >= 0 && read(fd, chunk, sizeof(chunk)) > 0) {
+  }
+  double elapsed = wall_seconds() - begin;
+  close(fd);
+  return elapsed;
+}
+
+// In a child, so its peak resident size is the replay's alone
+static bool replay_stream(double *seconds, long *peak_kb) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    host_reset();
+    host_trace_t *trace = host_trace_open(STREAM_TRACE);
+    double begin = wall_seconds();
+    bool ok = trace && host_trace_replay_until(trace, UINT64_MAX / 2) &&
+              host_trace_records(trace) == STREAM_RECORDS + 1;
+    double elapsed = ok ? wall_seconds() - begin : -1;
+    host_reset();
+    host_trace_close(trace);
+    host_release();
+    _exit(write(fds[1], &elapsed, sizeof(elapsed)) == sizeof(elapsed) ? 0 : 1);
+  }
+  close(fds[1]);
+  bool ok = pid > 0 && read(fds[0], seconds, sizeof(*seconds)) == sizeof(*seconds) && *seconds >= 0;
+  close(fds[0]);
+  int status;
+  struct rusage usage;
+  ok = pid > 0 && wait4(pid, &status, 0, &usage) == pid && WIFEXITED(status) &&
+       WEXITSTATUS(status) == 0 && ok;
+  *peak_kb = usage.ru_maxrss;
+  return ok;
+}
+
+static bool stream(void) {
+  uint64_t bytes = 0;
+  double read_s = 0, replay_s = 0;
+  long peak_kb = 0;
+  bool ok = write_stream(&bytes);
+  if (ok) {
+    read_s = read_stream();
+    ok = replay_stream(&replay_s, &peak_kb);
+  }
+  double mb = bytes / 1e6;
+  fprintf(report, "stream: %u records, %.1f MB (%.2f bytes per record)\n",
+          STREAM_RECORDS, mb, (double)bytes / STREAM_RECORDS);
+  fprintf(report, "  %-8s %9s %12s %10s\n", "pass", "wall_ms", "records/s", "MB/s");
+  fprintf(report, "  %-8s %9.1f %12s %10.1f\n", "read()", read_s * 1e3, "-", mb / read_s);
+  fprintf(report, "  %-8s %9.1f %12.3g %10.1f\n", "replay", replay_s * 1e3,
+          STREAM_RECORDS / replay_s, mb / replay_s);
+  fprintf(report, "  replay peak RSS %.1f MB for a %.1f MB trace, ok: %s\n",
+          peak_kb / 1e3, mb, ok ? "yes" : "NO");
+  unlink(STREAM_TRACE);
+  return ok;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  bool ok = sensors();
+  ok = stream() && ok;
+  fclose(report);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/*
+ * A3144 trajectory mode benchmark
+ *
+ * A magnet spinning at several speeds, simulated two ways:
+ *  - trajectory: the motion is given in the "trajectory" attribute and the
+ *    chip schedules each OUT edge from the solved threshold crossings
+ *  - polling: the benchmark plays the same field into magneticField every
+ *    100 us and the chip finds the crossings by adaptive polling
+ * Reports host imports per simulated second, OUT edges and how far the
+ * polled edges land from the exact ones.
+ *
+ * Also clears outputInverted one second into a trajectory run and checks
+ * that OUT follows from the next scheduled edge on, at the same times.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define SIM_SECONDS 10
+#define PEAK 80
+#define MAX_EDGES 4096
+
+typedef struct {
+  uint64_t at[MAX_EDGES];
+  uint32_t level[MAX_EDGES];
+  uint32_t count;
+} edges_t;
+
+static edges_t exact;
+static edges_t polled;
+static edges_t flipped;
+static edges_t *recording;
+static FILE *report;
+
+static void record_edge(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  (void)instance;
+  (void)pin;
+  if (recording->count < MAX_EDGES) {
+    recording->at[recording->count] = sim_ns;
+    recording->level[recording->count] = value;
+    recording->count++;
+  }
+}
+
+static void run_trajectory(uint32_t rpm) {
+  char text[64];
+  snprintf(text, sizeof(text), "rotate rpm=%u peak=%u", rpm, PEAK);
+
+  host_reset();
+  host_attr_set_string("trajectory", text);
+  exact.count = 0;
+  recording = &exact;
+  chip_init();
+  host_run_until(HOST_SEC(SIM_SECONDS));
+}
+
+static void run_polling(uint32_t rpm) {
+  host_reset();
+  polled.count = 0;
+  recording = &polled;
+  host_attr_set("magneticField", 0);
+  chip_init();
+
+  double period_ns = 60e9 / rpm;
+  const double two_pi = 6.283185307179586;
+  for (uint64_t t = HOST_US(100); t <= HOST_SEC(SIM_SECONDS); t += HOST_US(100)) {
+    host_run_until(t);
+    double field = -PEAK * cos(two_pi * fmod((double)t, period_ns) / period_ns);
+    host_attr_set_float("magneticField", field);
+  }
+}
+
+static void clear_inverted(void *arg) {
+  (void)arg;
+  host_attr_set("outputInverted", 0);
+}
+
+// The run with outputInverted cleared at 1 s matches the plain one before
+// that, drops the edge the flip cancels out, then has every level inverted
+static bool inverted_midway(uint32_t rpm) {
+  run_trajectory(rpm);
+  char text[64];
+  snprintf(text, sizeof(text), "rotate rpm=%u peak=%u", rpm, PEAK);
+  host_reset();
+  host_attr_set_string("trajectory", text);
+  flipped.count = 0;
+  recording = &flipped;
+  chip_init();
+  host_schedule(HOST_SEC(1), clear_inverted, NULL);
+  host_run_until(HOST_SEC(SIM_SECONDS));
+
+  uint32_t split = 0;
+  while (split < exact.count && exact.at[split] < HOST_SEC(1)) {
+    split++;
+  }
+  bool ok = split + 1 < exact.count && flipped.count == exact.count - 1;
+  for (uint32_t i = 0; ok && i < flipped.count; i++) {
+    uint32_t j = i < split ? i : i + 1;
+    ok = flipped.at[i] == exact.at[j] && (flipped.level[i] == exact.level[j]) == (i < split);
+  }
+  return ok;
+}
+
+// Mean and worst distance from each polled edge to the exact edge of the
+// same level closest to it
+static void edge_error(double *mean_us, double *worst_us) {
+  double total = 0, worst = 0;
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < polled.count; i++) {
+    while (j + 1 < exact.count && exact.at[j + 1] <= polled.at[i]) {
+      j++;
+    }
+    double best = INFINITY;
+    for (uint32_t k = j > 0 ? j - 1 : 0; k < exact.count && k <= j + 2; k++) {
+      double d = fabs((double)polled.at[i] - (double)exact.at[k]);
+      if (exact.level[k] == polled.level[i] && d < best) {
+        best = d;
+      }
+    }
+    if (best != INFINITY) {
+      total += best;
+      worst = best > worst ? best : worst;
+    }
+  }
+  *mean_us = polled.count ? total / polled.count / 1e3 : 0;
+  *worst_us = worst / 1e3;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  host_set_pin_listener(record_edge);
+
+  static const uint32_t speeds[] = {6, 60, 600, 6000};
+
+  fprintf(report, "%6s %-10s %12s %8s %14s %14s\n",
+          "rpm", "mode", "imports/s", "edges", "mean_err_us", "worst_err_us");
+  for (unsigned i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+    run_trajectory(speeds[i]);
+    fprintf(report, "%6u %-10s %12.1f %8u %14.3f %14.3f\n", speeds[i], "trajectory",
+            (double)host_import_calls(host_counters()) / SIM_SECONDS, exact.count, 0.0, 0.0);
+
+    run_polling(speeds[i]);
+    double mean_us, worst_us;
+    edge_error(&mean_us, &worst_us);
+    fprintf(report, "%6u %-10s %12.1f %8u %14.3f %14.3f\n", speeds[i], "polling",
+            (double)host_import_calls(host_counters()) / SIM_SECONDS, polled.count, mean_us, worst_us);
+  }
+  bool ok = inverted_midway(600);
+  fprintf(report, "outputInverted cleared at 1 s, OUT follows from the next edge: %s\n",
+          ok ? "yes" : "NO");
+  fclose(report);
+  return ok ? 0 : 1;
+}
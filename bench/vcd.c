@@ -0,0 +1,198 @@
+/*
+ * A3144 VCD export benchmark
+ *
+ * Pulse train: tachometer mode at a 100 kHz edge rate for 60 simulated
+ * seconds, once counting edges only and once dumping them to a VCD file.
+ * Reports OUT edges per wall-clock second for both, the cost per edge, and
+ * the file size, and checks that the file holds one value change per edge
+ * at the right times.
+ *
+ * Writer alone: 32M OUT edges, 500 ns apart, handed straight to
+ * host_vcd_pin() as the chip would. Reports edges and MB per second up to
+ * the closed file (in the page cache; no fsync).
+ *
+ * Power cycle: VCC off for a second and back on. Checks that both VCC edges
+ * are in the file, and that OUT is dumped as z while the chip floats it and
+ * driven again after power-up.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-vcd.h"
+
+void chip_init(void);
+
+#define POLES 50
+#define RPM 60000
+#define EDGES_PER_SEC (2ull * POLES * RPM / 60)
+#define SIM_SECONDS 60
+#define WRITER_EDGES (32u << 20)
+#define WRITER_GAP_NS 500
+#define TRAIN_VCD "build/bench-vcd-train.vcd"
+#define WRITER_VCD "build/bench-vcd-writer.vcd"
+#define POWER_VCD "build/bench-vcd-power.vcd"
+
+static FILE *report;
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void start_train(void) {
+  host_reset();
+  host_attr_set("tachPoles", POLES);
+  host_attr_set("tachRpm", RPM);
+  chip_init();
+}
+
+// Value changes after $dumpvars must alternate on OUT, one per edge, at
+// strictly increasing times
+static bool check_train(const char *path, uint64_t edges) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  char line[256], out_line[16] = "";
+  bool body = false, ok = true;
+  uint64_t changes = 0, last_ns = 0, at_ns = 0;
+  int level = -1;
+  while (ok && fgets(line, sizeof(line), file)) {
+    char id[8], name[64];
+    if (sscanf(line, "$var wire 1 %7s %63s", id, name) == 2 && strcmp(name, "OUT") == 0) {
+      snprintf(out_line, sizeof(out_line), "%s\n", id);
+    } else if (strcmp(line, "$end\n") == 0) {
+      body = true;
+    } else if (line[0] == '#') {
+      at_ns = strtoull(line + 1, NULL, 10);
+      ok = !body || at_ns > last_ns;
+      last_ns = at_ns;
+    } else if ((line[0] == '0' || line[0] == '1') && strcmp(line + 1, out_line) == 0) {
+      ok = !body || level != line[0] - '0';
+      changes += body;
+      level = line[0] - '0';
+    }
+  }
+  fclose(file);
+  return ok && changes == edges && last_ns <= HOST_SEC(SIM_SECONDS);
+}
+
+static bool train(void) {
+  start_train();
+  double begin = wall_seconds();
+  host_run_until(HOST_SEC(SIM_SECONDS));
+  double plain_s = wall_seconds() - begin;
+  uint64_t edges = host_pin_edges("OUT");
+
+  start_train();
+  uint64_t changes = 0, bytes = 0;
+  bool ok = host_vcd_open(TRAIN_VCD);
+  begin = wall_seconds();
+  host_run_until(HOST_SEC(SIM_SECONDS));
+  ok = host_vcd_close(&changes, &bytes) && ok;
+  double vcd_s = wall_seconds() - begin;
+  ok = ok && changes == edges && host_pin_edges("OUT") == edges && check_train(TRAIN_VCD, edges);
+
+  fprintf(report, "pulse train: %u poles at %u rpm, %llu edges/sim_s for %u s\n",
+          POLES, RPM, EDGES_PER_SEC, SIM_SECONDS);
+  fprintf(report, "  %-8s %10s %9s %13s %8s\n", "run", "edges", "wall_ms", "edges/wall_s", "MB");
+  fprintf(report, "  %-8s %10lu %9.1f %13.0f %8s\n", "count", (unsigned long)edges,
+          plain_s * 1e3, edges / plain_s, "-");
+  fprintf(report, "  %-8s %10lu %9.1f %13.0f %8.1f\n", "vcd", (unsigned long)changes,
+          vcd_s * 1e3, changes / vcd_s, bytes / 1e6);
+  fprintf(report, "  VCD cost %.1f ns per edge, file checked: %s\n",
+          (vcd_s - plain_s) * 1e9 / edges, ok ? "yes" : "NO");
+  unlink(TRAIN_VCD);
+  return ok;
+}
+
+static bool writer(void) {
+  host_reset();
+  chip_init();
+  const char *out = NULL;
+  for (uint32_t pin = 0; pin < host_pin_count(); pin++) {
+    out = strcmp(host_pin_name(pin), "OUT") == 0 ? host_pin_name(pin) : out;
+  }
+  uint64_t changes = 0, bytes = 0;
+  bool ok = out && host_vcd_open(WRITER_VCD);
+  double begin = wall_seconds();
+  uint64_t at_ns = host_now();
+  for (uint32_t i = 0; ok && i < WRITER_EDGES; i++) {
+    at_ns += WRITER_GAP_NS;
+    host_vcd_pin(0, out, i & 1, at_ns);
+  }
+  ok = host_vcd_close(&changes, &bytes) && ok && changes == WRITER_EDGES;
+  double elapsed = wall_seconds() - begin;
+
+  fprintf(report, "writer: %u edges, %.1f MB, %.1f ms, %.3g edges/s, %.0f MB/s, ok: %s\n",
+          WRITER_EDGES, bytes / 1e6, elapsed * 1e3, WRITER_EDGES / elapsed,
+          bytes / 1e6 / elapsed, ok ? "yes" : "NO");
+  unlink(WRITER_VCD);
+  return ok;
+}
+
+// A pin's values in the file with their times, as "<value>@<ns> ..."
+static bool pin_changes(const char *path, const char *pin, char *changes, size_t size) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  char line[256], pin_line[16] = "";
+  uint64_t at_ns = 0;
+  size_t used = 0;
+  changes[0] = '\0';
+  while (fgets(line, sizeof(line), file)) {
+    char id[8], name[64];
+    if (sscanf(line, "$var wire 1 %7s %63s", id, name) == 2 && strcmp(name, pin) == 0) {
+      snprintf(pin_line, sizeof(pin_line), "%s\n", id);
+    } else if (line[0] == '#') {
+      at_ns = strtoull(line + 1, NULL, 10);
+    } else if (strchr("01z", line[0]) && strcmp(line + 1, pin_line) == 0 && used < size) {
+      used += (size_t)snprintf(changes + used, size - used, "%s%c@%llu", used ? " " : "", line[0],
+                               (unsigned long long)at_ns);
+    }
+  }
+  fclose(file);
+  return used < size;
+}
+
+static bool power(void) {
+  host_reset();
+  chip_init();
+  bool ok = host_vcd_open(POWER_VCD);
+  host_run_until(HOST_SEC(1));
+  host_pin_set("VCC", 0);
+  host_run_until(HOST_SEC(2));
+  host_pin_set("VCC", 1);
+  host_run_until(HOST_SEC(3));
+  ok = host_vcd_close(NULL, NULL) && ok;
+
+  char out[256] = "?", vcc[256] = "?";
+  ok = ok && pin_changes(POWER_VCD, "OUT", out, sizeof(out)) &&
+       pin_changes(POWER_VCD, "VCC", vcc, sizeof(vcc)) &&
+       strcmp(out, "1@0 z@1000000000 1@2000000000") == 0 &&
+       strcmp(vcc, "1@0 0@1000000000 1@2000000000") == 0;
+  fprintf(report, "power cycle: VCC %s, OUT %s, ok: %s\n", vcc, out, ok ? "yes" : "NO");
+  unlink(POWER_VCD);
+  return ok;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  bool ok = train();
+  ok = writer() && ok;
+  ok = power() && ok;
+  fclose(report);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,688 @@
+/*
+ * WebAssembly runtime conformance check
+ *
+ * Builds one module with a small export per case and runs the cases through
+ * host/wokwi-wasm.c: integer and float arithmetic with their edge cases
+ * (wrapping, signed zeros, NaN operands, ties to even, saturating and
+ * trapping conversions, double rounding), loads and stores, bulk memory,
+ * memory.grow, br_table unwinding, multi-value blocks, loops, call and
+ * call_indirect, globals, and every trap those can raise. Float operands and
+ * results travel as their bit patterns, reinterpreted inside the export.
+ *
+ * A trap ends the process, so each trap case runs in a child of its own,
+ * which must exit with the runtime's message for it. Cases run in order on
+ * one instance, the memory cases relying on what the earlier ones stored.
+ * The expected values follow the WebAssembly spec. They were also checked
+ * against node's engine: build/bench/wasm-conformance <file> writes the
+ * module there for that.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-wasm.h"
+
+// Export bodies as string literals: opcodes and immediates, without the
+// final end
+#define CODE(s) s, sizeof(s) - 1
+#define GET0 "\x20\x00"
+#define GET1 "\x20\x01"
+#define GET2 "\x20\x02"
+#define F32 "\xbe"      // f32.reinterpret_i32
+#define F64 "\xbf"      // f64.reinterpret_i64
+#define BITS32 "\xbc"   // i32.reinterpret_f32
+#define BITS64 "\xbd"   // i64.reinterpret_f64
+
+typedef struct {
+  const char *name;     // export name
+  const char *params;   // i i32, I i64
+  const char *results;
+  const char *locals;   // i i32, I i64, f f32, F f64
+  const char *code;
+  size_t code_size;
+} conformance_func_t;
+
+#define BINARY(name, type, op) {name, type type, type, "", CODE(GET0 GET1 op)}
+#define UNARY(name, type, op) {name, type, type, "", CODE(GET0 op)}
+#define COMPARE(name, type, op) {name, type type, "i", "", CODE(GET0 GET1 op)}
+#define F32_BINARY(name, op) {name, "ii", "i", "", CODE(GET0 F32 GET1 F32 op BITS32)}
+#define F32_UNARY(name, op) {name, "i", "i", "", CODE(GET0 F32 op BITS32)}
+#define F32_COMPARE(name, op) {name, "ii", "i", "", CODE(GET0 F32 GET1 F32 op)}
+#define F64_BINARY(name, op) {name, "II", "I", "", CODE(GET0 F64 GET1 F64 op BITS64)}
+#define F64_UNARY(name, op) {name, "I", "I", "", CODE(GET0 F64 op BITS64)}
+#define F64_COMPARE(name, op) {name, "II", "i", "", CODE(GET0 F64 GET1 F64 op)}
+
+// Type 0 is [] -> [i32 i32] and type 1 [i32 i32] -> [i32], for the block
+// types below; function n has type n + 2. The first three functions fill
+// table slots 0-2, slot 3 stays empty.
+static const conformance_func_t funcs[] = {
+  {"_add", "ii", "i", "", CODE(GET0 GET1 "\x6a")},
+  {"_sub", "ii", "i", "", CODE(GET0 GET1 "\x6b")},
+  {"_neg64", "I", "I", "", CODE("\x42\x00" GET0 "\x7d")},
+  {"chipInit", "", "", "", CODE("")},
+  // (if (result i32) (i32.lt_u (local.get 0) (i32.const 2)) (then (local.get 0))
+  //   (else (i32.add (call 4 (i32.sub (local.get 0) (i32.const 1)))
+  //                  (call 4 (i32.sub (local.get 0) (i32.const 2))))))
+  {"call", "i", "i", "",
+   CODE(GET0 "\x41\x02\x49\x04\x7f" GET0 "\x05" GET0 "\x41\x01\x6b\x10\x04" GET0 "\x41\x02\x6b\x10\x04\x6a\x0b")},
+  // (call 5 (i32.add (local.get 0) (i32.const 1)))
+  {"recurse", "i", "i", "", CODE(GET0 "\x41\x01\x6a\x10\x05")},
+  {"unreachable", "", "", "", CODE("\x00")},
+
+  BINARY("i32.add", "i", "\x6a"),
+  BINARY("i32.sub", "i", "\x6b"),
+  BINARY("i32.mul", "i", "\x6c"),
+  BINARY("i32.div_s", "i", "\x6d"),
+  BINARY("i32.div_u", "i", "\x6e"),
+  BINARY("i32.rem_s", "i", "\x6f"),
+  BINARY("i32.rem_u", "i", "\x70"),
+  BINARY("i32.and", "i", "\x71"),
+  BINARY("i32.or", "i", "\x72"),
+  BINARY("i32.xor", "i", "\x73"),
+  BINARY("i32.shl", "i", "\x74"),
+  BINARY("i32.shr_s", "i", "\x75"),
+  BINARY("i32.shr_u", "i", "\x76"),
+  BINARY("i32.rotl", "i", "\x77"),
+  BINARY("i32.rotr", "i", "\x78"),
+  BINARY("i32.eq", "i", "\x46"),
+  BINARY("i32.ne", "i", "\x47"),
+  BINARY("i32.lt_s", "i", "\x48"),
+  BINARY("i32.lt_u", "i", "\x49"),
+  BINARY("i32.gt_s", "i", "\x4a"),
+  BINARY("i32.gt_u", "i", "\x4b"),
+  BINARY("i32.le_s", "i", "\x4c"),
+  BINARY("i32.ge_u", "i", "\x4f"),
+  UNARY("i32.clz", "i", "\x67"),
+  UNARY("i32.ctz", "i", "\x68"),
+  UNARY("i32.popcnt", "i", "\x69"),
+  UNARY("i32.eqz", "i", "\x45"),
+  UNARY("i32.extend8_s", "i", "\xc0"),
+  UNARY("i32.extend16_s", "i", "\xc1"),
+
+  BINARY("i64.add", "I", "\x7c"),
+  BINARY("i64.sub", "I", "\x7d"),
+  BINARY("i64.mul", "I", "\x7e"),
+  BINARY("i64.div_s", "I", "\x7f"),
+  BINARY("i64.div_u", "I", "\x80"),
+  BINARY("i64.rem_s", "I", "\x81"),
+  BINARY("i64.rem_u", "I", "\x82"),
+  BINARY("i64.and", "I", "\x83"),
+  BINARY("i64.or", "I", "\x84"),
+  BINARY("i64.xor", "I", "\x85"),
+  BINARY("i64.shl", "I", "\x86"),
+  BINARY("i64.shr_s", "I", "\x87"),
+  BINARY("i64.shr_u", "I", "\x88"),
+  BINARY("i64.rotl", "I", "\x89"),
+  BINARY("i64.rotr", "I", "\x8a"),
+  COMPARE("i64.eq", "I", "\x51"),
+  COMPARE("i64.lt_s", "I", "\x53"),
+  COMPARE("i64.lt_u", "I", "\x54"),
+  COMPARE("i64.ge_u", "I", "\x5a"),
+  UNARY("i64.clz", "I", "\x79"),
+  UNARY("i64.ctz", "I", "\x7a"),
+  UNARY("i64.popcnt", "I", "\x7b"),
+  {"i64.eqz", "I", "i", "", CODE(GET0 "\x50")},
+  UNARY("i64.extend8_s", "I", "\xc2"),
+  UNARY("i64.extend16_s", "I", "\xc3"),
+  UNARY("i64.extend32_s", "I", "\xc4"),
+  {"i32.wrap_i64", "I", "i", "", CODE(GET0 "\xa7")},
+  {"i64.extend_i32_s", "i", "I", "", CODE(GET0 "\xac")},
+  {"i64.extend_i32_u", "i", "I", "", CODE(GET0 "\xad")},
+
+  F32_BINARY("f32.add", "\x92"),
+  F32_BINARY("f32.sub", "\x93"),
+  F32_BINARY("f32.mul", "\x94"),
+  F32_BINARY("f32.div", "\x95"),
+  F32_BINARY("f32.min", "\x96"),
+  F32_BINARY("f32.max", "\x97"),
+  F32_BINARY("f32.copysign", "\x98"),
+  F32_UNARY("f32.abs", "\x8b"),
+  F32_UNARY("f32.neg", "\x8c"),
+  F32_UNARY("f32.ceil", "\x8d"),
+  F32_UNARY("f32.floor", "\x8e"),
+  F32_UNARY("f32.trunc", "\x8f"),
+  F32_UNARY("f32.nearest", "\x90"),
+  F32_UNARY("f32.sqrt", "\x91"),
+  F32_COMPARE("f32.eq", "\x5b"),
+  F32_COMPARE("f32.ge", "\x60"),
+  // (local.tee 2 (f32.max ...)) (f32.ne (local.get 2) (local.get 2)): 1 for NaN
+  {"f32.max nan", "ii", "i", "f", CODE(GET0 F32 GET1 F32 "\x97\x22\x02\x20\x02\x5c")},
+
+  F64_BINARY("f64.add", "\xa0"),
+  F64_BINARY("f64.sub", "\xa1"),
+  F64_BINARY("f64.mul", "\xa2"),
+  F64_BINARY("f64.div", "\xa3"),
+  F64_BINARY("f64.min", "\xa4"),
+  F64_BINARY("f64.max", "\xa5"),
+  F64_BINARY("f64.copysign", "\xa6"),
+  F64_UNARY("f64.abs", "\x99"),
+  F64_UNARY("f64.neg", "\x9a"),
+  F64_UNARY("f64.ceil", "\x9b"),
+  F64_UNARY("f64.floor", "\x9c"),
+  F64_UNARY("f64.trunc", "\x9d"),
+  F64_UNARY("f64.nearest", "\x9e"),
+  F64_UNARY("f64.sqrt", "\x9f"),
+  F64_COMPARE("f64.eq", "\x61"),
+  F64_COMPARE("f64.ne", "\x62"),
+  F64_COMPARE("f64.lt", "\x63"),
+  {"f64.min nan", "II", "i", "F", CODE(GET0 F64 GET1 F64 "\xa4\x22\x02\x20\x02\x62")},
+
+  {"i32.trunc_f32_s", "i", "i", "", CODE(GET0 F32 "\xa8")},
+  {"i32.trunc_f64_s", "I", "i", "", CODE(GET0 F64 "\xaa")},
+  {"i32.trunc_f64_u", "I", "i", "", CODE(GET0 F64 "\xab")},
+  {"i64.trunc_f32_u", "i", "I", "", CODE(GET0 F32 "\xaf")},
+  {"i64.trunc_f64_s", "I", "I", "", CODE(GET0 F64 "\xb0")},
+  {"i64.trunc_f64_u", "I", "I", "", CODE(GET0 F64 "\xb1")},
+  {"i32.trunc_sat_f32_s", "i", "i", "", CODE(GET0 F32 "\xfc\x00")},
+  {"i32.trunc_sat_f64_u", "I", "i", "", CODE(GET0 F64 "\xfc\x03")},
+  {"i64.trunc_sat_f64_s", "I", "I", "", CODE(GET0 F64 "\xfc\x06")},
+  {"i64.trunc_sat_f64_u", "I", "I", "", CODE(GET0 F64 "\xfc\x07")},
+  {"f32.convert_i32_s", "i", "i", "", CODE(GET0 "\xb2" BITS32)},
+  {"f32.convert_i32_u", "i", "i", "", CODE(GET0 "\xb3" BITS32)},
+  {"f32.convert_i64_u", "I", "i", "", CODE(GET0 "\xb5" BITS32)},
+  {"f64.convert_i32_u", "i", "I", "", CODE(GET0 "\xb8" BITS64)},
+  {"f64.convert_i64_s", "I", "I", "", CODE(GET0 "\xb9" BITS64)},
+  {"f64.convert_i64_u", "I", "I", "", CODE(GET0 "\xba" BITS64)},
+  {"f32.demote_f64", "I", "i", "", CODE(GET0 F64 "\xb6" BITS32)},
+  {"f64.promote_f32", "i", "I", "", CODE(GET0 F32 "\xbb" BITS64)},
+
+  // (i64.store32 (i32.const 64) (local.get 0)) (i64.load16_s (i32.const 64))
+  {"i64.store32 load16_s", "I", "I", "", CODE("\x41\xc0\x00" GET0 "\x3e\x02\x00\x41\xc0\x00\x32\x01\x00")},
+  // (i32.load8_u offset=67 (i32.const 0))
+  {"i32.load8_u offset", "", "i", "", CODE("\x41\x00\x2d\x00\x43")},
+  {"i32.load", "i", "i", "", CODE(GET0 "\x28\x02\x00")},
+  // (i32.load offset=0xffffffff (local.get 0))
+  {"i32.load offset", "i", "i", "", CODE(GET0 "\x28\x02\xff\xff\xff\xff\x0f")},
+  {"i64.load", "i", "I", "", CODE(GET0 "\x29\x03\x00")},
+  {"memory.fill", "iii", "", "", CODE(GET0 GET1 GET2 "\xfc\x0b\x00")},
+  {"memory.copy", "iii", "", "", CODE(GET0 GET1 GET2 "\xfc\x0a\x00\x00")},
+  {"memory.init", "iii", "", "", CODE(GET0 GET1 GET2 "\xfc\x08\x00\x00")},
+  {"data.drop", "", "", "", CODE("\xfc\x09\x00")},
+  {"memory.size", "", "i", "", CODE("\x3f\x00")},
+  {"memory.grow", "i", "i", "", CODE(GET0 "\x40\x00")},
+
+  // (block $d (result i32) (block $c (result i32) (block $b (result i32)
+  //   (block $a (result i32)
+  //     (i32.const 9) (i32.const 10) (br_table $a $b $c $d (local.get 0)))
+  //   (return (i32.add (i32.const 1))))
+  //   (return (i32.add (i32.const 2))))
+  //   (return (i32.add (i32.const 3))))
+  // (i32.add (i32.const 4))
+  {"br_table", "i", "i", "",
+   CODE("\x02\x7f\x02\x7f\x02\x7f\x02\x7f\x41\x09\x41\x0a" GET0 "\x0e\x03\x00\x01\x02\x03\x0b"
+        "\x41\x01\x6a\x0f\x0b\x41\x02\x6a\x0f\x0b\x41\x03\x6a\x0f\x0b\x41\x04\x6a")},
+  // (block (type 0) (local.get 1) (local.get 0)) (block (type 1) (i32.sub))
+  {"multi-value", "ii", "i", "", CODE("\x02\x00" GET1 GET0 "\x0b\x02\x01\x6b\x0b")},
+  // Factorial: (local.set 1 (i64.const 1))
+  // (block (loop (br_if 1 (i32.eqz (local.get 0)))
+  //   (local.set 1 (i64.mul (local.get 1) (i64.extend_i32_u (local.get 0))))
+  //   (local.set 0 (i32.sub (local.get 0) (i32.const 1))) (br 0)))
+  // (local.get 1)
+  {"loop", "i", "I", "I",
+   CODE("\x42\x01\x21\x01\x02\x40\x03\x40" GET0 "\x45\x0d\x01\x20\x01" GET0 "\xad\x7e\x21\x01" GET0
+        "\x41\x01\x6b\x21\x00\x0c\x00\x0b\x0b\x20\x01")},
+  {"if", "i", "i", "", CODE(GET0 "\x04\x7f\x41\x01\x05\x41\x02\x0b")},
+  {"select", "iii", "i", "", CODE(GET0 GET1 GET2 "\x1b")},
+  // (call_indirect (type 1) (local.get 1) (local.get 2) (local.get 0))
+  {"call_indirect", "iii", "i", "", CODE(GET1 GET2 GET0 "\x11\x01\x00")},
+  // (global.set 0 (i32.add (global.get 0) (local.get 0))) (global.get 0)
+  {"global", "i", "i", "", CODE("\x23\x00" GET0 "\x6a\x24\x00\x23\x00")},
+};
+
+#define FUNC_COUNT (sizeof(funcs) / sizeof(funcs[0]))
+
+typedef struct {
+  const char *name;
+  uint32_t count;
+  uint64_t args[3];
+  uint64_t expected;
+  const char *trap;     // the runtime's message, NULL when it returns
+} conformance_case_t;
+
+static const conformance_case_t cases[] = {
+  {"i32.add", 2, {0xffffffff, 1}, 0, NULL},  // wraps
+  {"i32.sub", 2, {0, 1}, 0xffffffff, NULL},
+  {"i32.mul", 2, {0x7fffffff, 3}, 0x7ffffffd, NULL},
+  {"i32.div_s", 2, {0xfffffff9, 2}, 0xfffffffd, NULL},  // rounds toward zero
+  {"i32.div_u", 2, {0xfffffff9, 2}, 0x7ffffffc, NULL},
+  {"i32.div_s", 2, {1, 0}, 0, "integer divide by zero"},
+  {"i32.div_s", 2, {0x80000000, 0xffffffff}, 0, "integer overflow"},  // INT32_MIN / -1
+  {"i32.rem_s", 2, {0xfffffff9, 2}, 0xffffffff, NULL},  // sign of the dividend
+  {"i32.rem_s", 2, {0x80000000, 0xffffffff}, 0, NULL},  // INT32_MIN % -1 does not trap
+  {"i32.rem_u", 2, {0xfffffff9, 2}, 1, NULL},
+  {"i32.rem_u", 2, {1, 0}, 0, "integer divide by zero"},
+  {"i32.and", 2, {0xff00ff00, 0xff00ff0}, 0xf000f00, NULL},
+  {"i32.or", 2, {0xff00ff00, 0xff00ff0}, 0xfff0fff0, NULL},
+  {"i32.xor", 2, {0xff00ff00, 0xff00ff0}, 0xf0f0f0f0, NULL},
+  {"i32.shl", 2, {1, 0x21}, 2, NULL},  // count taken mod 32
+  {"i32.shr_s", 2, {0x80000000, 0x1f}, 0xffffffff, NULL},
+  {"i32.shr_s", 2, {0x80000000, 0x20}, 0x80000000, NULL},
+  {"i32.shr_u", 2, {0x80000000, 0x1f}, 1, NULL},
+  {"i32.rotl", 2, {0x12345678, 0x24}, 0x23456781, NULL},
+  {"i32.rotr", 2, {1, 1}, 0x80000000, NULL},
+  {"i32.eq", 2, {5, 5}, 1, NULL},
+  {"i32.ne", 2, {5, 5}, 0, NULL},
+  {"i32.lt_s", 2, {0xffffffff, 0}, 1, NULL},
+  {"i32.lt_u", 2, {0xffffffff, 0}, 0, NULL},
+  {"i32.gt_s", 2, {1, 0xffffffff}, 1, NULL},
+  {"i32.gt_u", 2, {1, 0xffffffff}, 0, NULL},
+  {"i32.le_s", 2, {0x80000000, 0x7fffffff}, 1, NULL},
+  {"i32.ge_u", 2, {0, 0}, 1, NULL},
+  {"i32.clz", 1, {0}, 0x20, NULL},
+  {"i32.clz", 1, {1}, 0x1f, NULL},
+  {"i32.ctz", 1, {0}, 0x20, NULL},
+  {"i32.ctz", 1, {0x80000000}, 0x1f, NULL},
+  {"i32.popcnt", 1, {0xffffffff}, 0x20, NULL},
+  {"i32.eqz", 1, {0}, 1, NULL},
+  {"i32.eqz", 1, {5}, 0, NULL},
+  {"i32.extend8_s", 1, {0x80}, 0xffffff80, NULL},
+  {"i32.extend8_s", 1, {0x17f}, 0x7f, NULL},
+  {"i32.extend16_s", 1, {0x8000}, 0xffff8000, NULL},
+  {"i64.add", 2, {0xffffffffffffffff, 2}, 1, NULL},
+  {"i64.sub", 2, {0, 1}, 0xffffffffffffffff, NULL},
+  {"i64.mul", 2, {0x100000000, 0x100000000}, 0, NULL},
+  {"i64.mul", 2, {0x123456789, 0x987654321}, 0xd77d742cce1833a9, NULL},
+  {"i64.div_s", 2, {0xfffffffffffffff9, 2}, 0xfffffffffffffffd, NULL},
+  {"i64.div_u", 2, {0xffffffffffffffff, 2}, 0x7fffffffffffffff, NULL},
+  {"i64.div_s", 2, {0x8000000000000000, 0xffffffffffffffff}, 0, "integer overflow"},  // INT64_MIN / -1
+  {"i64.div_u", 2, {1, 0}, 0, "integer divide by zero"},
+  {"i64.rem_s", 2, {0x8000000000000000, 0xffffffffffffffff}, 0, NULL},
+  {"i64.rem_s", 2, {0xfffffffffffffff9, 2}, 0xffffffffffffffff, NULL},
+  {"i64.rem_u", 2, {0xffffffffffffffff, 0xa}, 5, NULL},
+  {"i64.rem_s", 2, {1, 0}, 0, "integer divide by zero"},
+  {"i64.and", 2, {0xff00ff00ff00ff00, 0xff00ff00ff00ff0}, 0xf000f000f000f00, NULL},
+  {"i64.or", 2, {0xff00, 0xff}, 0xffff, NULL},
+  {"i64.xor", 2, {0xffffffffffffffff, 0xf}, 0xfffffffffffffff0, NULL},
+  {"i64.shl", 2, {1, 0x41}, 2, NULL},  // count taken mod 64
+  {"i64.shr_s", 2, {0x8000000000000000, 0x3f}, 0xffffffffffffffff, NULL},
+  {"i64.shr_u", 2, {0x8000000000000000, 0x3f}, 1, NULL},
+  {"i64.rotl", 2, {0x8000000000000001, 1}, 3, NULL},
+  {"i64.rotr", 2, {1, 1}, 0x8000000000000000, NULL},
+  {"i64.eq", 2, {0x8000000000000000, 0x8000000000000000}, 1, NULL},
+  {"i64.lt_s", 2, {0xffffffffffffffff, 0}, 1, NULL},
+  {"i64.lt_u", 2, {0xffffffffffffffff, 0}, 0, NULL},
+  {"i64.ge_u", 2, {0xffffffffffffffff, 0}, 1, NULL},
+  {"i64.clz", 1, {0}, 0x40, NULL},
+  {"i64.clz", 1, {1}, 0x3f, NULL},
+  {"i64.ctz", 1, {0}, 0x40, NULL},
+  {"i64.ctz", 1, {0x8000000000000000}, 0x3f, NULL},
+  {"i64.popcnt", 1, {0xffffffffffffffff}, 0x40, NULL},
+  {"i64.eqz", 1, {0}, 1, NULL},
+  {"i64.extend8_s", 1, {0xff}, 0xffffffffffffffff, NULL},
+  {"i64.extend16_s", 1, {0x7fff}, 0x7fff, NULL},
+  {"i64.extend32_s", 1, {0x80000000}, 0xffffffff80000000, NULL},
+  {"i32.wrap_i64", 1, {0x123456789}, 0x23456789, NULL},
+  {"i64.extend_i32_s", 1, {0x80000000}, 0xffffffff80000000, NULL},
+  {"i64.extend_i32_u", 1, {0x80000000}, 0x80000000, NULL},
+  {"f32.add", 2, {0x3fc00000, 0x40100000}, 0x40700000, NULL},
+  {"f32.sub", 2, {0x3f800000, 0x3f800000}, 0, NULL},  // +0, not -0
+  {"f32.mul", 2, {0x80000000, 0x40a00000}, 0x80000000, NULL},
+  {"f32.div", 2, {0x3f800000, 0}, 0x7f800000, NULL},  // +inf
+  {"f32.div", 2, {0x3f800000, 0x40400000}, 0x3eaaaaab, NULL},
+  {"f32.min", 2, {0, 0x80000000}, 0x80000000, NULL},  // -0 is the smaller zero
+  {"f32.max", 2, {0x80000000, 0}, 0, NULL},
+  {"f32.copysign", 2, {0x3f800000, 0x80000000}, 0xbf800000, NULL},
+  {"f32.abs", 1, {0xffc00001}, 0x7fc00001, NULL},  // NaN payload kept
+  {"f32.neg", 1, {0x7fc00001}, 0xffc00001, NULL},
+  {"f32.ceil", 1, {0xbf000000}, 0x80000000, NULL},
+  {"f32.floor", 1, {0xbf000000}, 0xbf800000, NULL},
+  {"f32.trunc", 1, {0xbfe00000}, 0xbf800000, NULL},
+  {"f32.nearest", 1, {0x40200000}, 0x40000000, NULL},  // ties to even
+  {"f32.nearest", 1, {0x40600000}, 0x40800000, NULL},
+  {"f32.nearest", 1, {0xbf000000}, 0x80000000, NULL},
+  {"f32.sqrt", 1, {0x40000000}, 0x3fb504f3, NULL},
+  {"f32.ge", 2, {0, 0x80000000}, 1, NULL},
+  {"f32.eq", 2, {0x7fc00000, 0x7fc00000}, 0, NULL},
+  {"f32.max nan", 2, {0x7fc00000, 0x3f800000}, 1, NULL},  // NaN, not the other operand
+  {"f64.add", 2, {0x3fb999999999999a, 0x3fc999999999999a}, 0x3fd3333333333334, NULL},
+  {"f64.sub", 2, {0x8000000000000000, 0}, 0x8000000000000000, NULL},
+  {"f64.mul", 2, {0x7fe1ccf385ebc8a0, 0x4024000000000000}, 0x7ff0000000000000, NULL},
+  {"f64.div", 2, {0xbff0000000000000, 0}, 0xfff0000000000000, NULL},
+  {"f64.min", 2, {0x8000000000000000, 0}, 0x8000000000000000, NULL},
+  {"f64.max", 2, {0, 0x8000000000000000}, 0, NULL},
+  {"f64.min nan", 2, {0x3ff0000000000000, 0x7ff8000000000000}, 1, NULL},  // NaN, not the other operand
+  {"f64.copysign", 2, {0x4000000000000000, 0x8000000000000000}, 0xc000000000000000, NULL},
+  {"f64.abs", 1, {0x8000000000000000}, 0, NULL},
+  {"f64.neg", 1, {0}, 0x8000000000000000, NULL},
+  {"f64.ceil", 1, {0x3ff000001ad7f29b}, 0x4000000000000000, NULL},
+  {"f64.floor", 1, {0xbff8000000000000}, 0xc000000000000000, NULL},
+  {"f64.trunc", 1, {0xbfe8000000000000}, 0x8000000000000000, NULL},
+  {"f64.nearest", 1, {0xc004000000000000}, 0xc000000000000000, NULL},
+  {"f64.nearest", 1, {0x4330000000000001}, 0x4330000000000001, NULL},  // already integral
+  {"f64.sqrt", 1, {0x4000000000000000}, 0x3ff6a09e667f3bcd, NULL},
+  {"f64.eq", 2, {0, 0x8000000000000000}, 1, NULL},
+  {"f64.ne", 2, {0x7ff8000000000000, 0x7ff8000000000000}, 1, NULL},
+  {"f64.lt", 2, {0x8000000000000000, 0}, 0, NULL},
+  {"i32.trunc_f32_s", 1, {0x7fc00000}, 0, "invalid conversion to integer"},
+  {"i32.trunc_f32_s", 1, {0xcf000000}, 0x80000000, NULL},
+  {"i32.trunc_f32_s", 1, {0x4f000000}, 0, "integer overflow"},
+  {"i32.trunc_f64_s", 1, {0xc1e00000001ccccd}, 0x80000000, NULL},
+  {"i32.trunc_f64_s", 1, {0x41e0000000000000}, 0, "integer overflow"},
+  {"i32.trunc_f64_u", 1, {0xbfeccccccccccccd}, 0, NULL},  // truncates to -0 first
+  {"i32.trunc_f64_u", 1, {0xbff0000000000000}, 0, "integer overflow"},
+  {"i32.trunc_f64_u", 1, {0x41effffffffccccd}, 0xffffffff, NULL},
+  {"i64.trunc_f64_s", 1, {0xc3e0000000000000}, 0x8000000000000000, NULL},
+  {"i64.trunc_f64_s", 1, {0x43e0000000000000}, 0, "integer overflow"},
+  {"i64.trunc_f64_u", 1, {0x43efffffffffffff}, 0xfffffffffffff800, NULL},
+  {"i64.trunc_f64_u", 1, {0x43f0000000000000}, 0, "integer overflow"},
+  {"i64.trunc_f32_u", 1, {0x501502f9}, 0x2540be400, NULL},
+  {"i32.trunc_sat_f32_s", 1, {0x7fc00000}, 0, NULL},
+  {"i32.trunc_sat_f32_s", 1, {0x4f32d05e}, 0x7fffffff, NULL},
+  {"i32.trunc_sat_f32_s", 1, {0xcf32d05e}, 0x80000000, NULL},
+  {"i32.trunc_sat_f64_u", 1, {0xc014000000000000}, 0, NULL},
+  {"i32.trunc_sat_f64_u", 1, {0x41f2a05f20000000}, 0xffffffff, NULL},
+  {"i64.trunc_sat_f64_s", 1, {0x43e158e460913d00}, 0x7fffffffffffffff, NULL},
+  {"i64.trunc_sat_f64_u", 1, {0x43e158e460913d00}, 0x8ac7230489e80000, NULL},
+  {"i64.trunc_sat_f64_u", 1, {0xfff0000000000000}, 0, NULL},
+  {"f32.convert_i32_s", 1, {0xfffffffd}, 0xc0400000, NULL},
+  {"f32.convert_i32_u", 1, {0xffffffff}, 0x4f800000, NULL},  // rounds to 2^32
+  {"f32.convert_i64_u", 1, {0xffffffffffffffff}, 0x5f800000, NULL},
+  {"f32.convert_i64_u", 1, {0x20000020000001}, 0x5a000001, NULL},  // no double rounding through f64
+  {"f64.convert_i32_u", 1, {0xffffffff}, 0x41efffffffe00000, NULL},
+  {"f64.convert_i64_s", 1, {0xffffffffffffffff}, 0xbff0000000000000, NULL},
+  {"f64.convert_i64_u", 1, {0xffffffffffffffff}, 0x43f0000000000000, NULL},
+  {"f32.demote_f64", 1, {0x483d6329f1c35ca5}, 0x7f800000, NULL},
+  {"f32.demote_f64", 1, {0x3fb999999999999a}, 0x3dcccccd, NULL},
+  {"f64.promote_f32", 1, {0x3dcccccd}, 0x3fb99999a0000000, NULL},
+  {"i64.store32 load16_s", 1, {0x12348765}, 0xffffffffffff8765, NULL},  // low half, sign-extended
+  {"i32.load8_u offset", 0, {}, 0x12, NULL},  // the byte the store above left at 67
+  {"i32.load", 1, {0xfffc}, 0, NULL},  // last word of the page
+  {"i32.load", 1, {0xfffd}, 0, "out of bounds memory access"},
+  {"i32.load", 1, {0xffffffff}, 0, "out of bounds memory access"},
+  {"i32.load offset", 1, {0}, 0, "out of bounds memory access"},  // address + offset past 4 GiB
+  {"memory.fill", 3, {0x80, 0xab, 3}, 0, NULL},
+  {"memory.copy", 3, {0x81, 0x80, 4}, 0, NULL},  // overlapping, forward
+  {"i64.load", 1, {0x80}, 0xabababab, NULL},
+  {"memory.copy", 3, {0x80, 0x81, 4}, 0, NULL},  // overlapping, backward
+  {"i64.load", 1, {0x80}, 0xababab, NULL},
+  {"memory.init", 3, {0xc8, 1, 3}, 0, NULL},  // "asm" from the passive segment "wasm"
+  {"i64.load", 1, {0xc8}, 0x6d7361, NULL},
+  {"memory.fill", 3, {0xffff, 0, 2}, 0, "out of bounds memory access"},
+  {"memory.copy", 3, {0, 0xffff, 2}, 0, "out of bounds memory access"},
+  {"memory.init", 3, {0, 2, 3}, 0, "out of bounds memory access"},  // past the end of the segment
+  {"memory.fill", 3, {0x10000, 0, 0}, 0, NULL},  // empty at the end of memory
+  {"data.drop", 0, {}, 0, NULL},
+  {"memory.init", 3, {0, 0, 0}, 0, NULL},  // empty from a dropped segment
+  {"memory.init", 3, {0, 0, 1}, 0, "out of bounds memory access"},  // a dropped segment is empty
+  {"memory.size", 0, {}, 1, NULL},
+  {"memory.grow", 1, {2}, 0xffffffff, NULL},  // past the maximum of 2 pages
+  {"memory.grow", 1, {1}, 1, NULL},  // returns the old size
+  {"memory.size", 0, {}, 2, NULL},
+  {"i32.load", 1, {0x1fffc}, 0, NULL},
+  {"i32.load", 1, {0x1fffd}, 0, "out of bounds memory access"},
+  {"br_table", 1, {0}, 0xb, NULL},  // junk below the carried value is unwound
+  {"br_table", 1, {1}, 0xc, NULL},
+  {"br_table", 1, {2}, 0xd, NULL},
+  {"br_table", 1, {3}, 0xe, NULL},
+  {"br_table", 1, {4}, 0xe, NULL},  // default
+  {"br_table", 1, {0xffffffff}, 0xe, NULL},
+  {"multi-value", 2, {5, 0xc}, 7, NULL},
+  {"multi-value", 2, {0xc, 5}, 0xfffffff9, NULL},
+  {"loop", 1, {0}, 1, NULL},
+  {"loop", 1, {0x14}, 0x21c3677c82b40000, NULL},
+  {"loop", 1, {0x19}, 0x619fb0907bc00000, NULL},  // wraps
+  {"if", 1, {0}, 2, NULL},
+  {"if", 1, {7}, 1, NULL},
+  {"select", 3, {1, 2, 0}, 2, NULL},
+  {"select", 3, {1, 2, 5}, 1, NULL},
+  {"call_indirect", 3, {0, 7, 5}, 0xc, NULL},  // slot 0: _add, its own type index
+  {"call_indirect", 3, {1, 7, 5}, 2, NULL},
+  {"call_indirect", 3, {2, 7, 5}, 0, "indirect call signature mismatch"},  // slot 2: _neg64
+  {"call_indirect", 3, {3, 7, 5}, 0, "call through an empty table slot"},
+  {"call_indirect", 3, {9, 7, 5}, 0, "call through an empty table slot"},  // past the table
+  {"call", 1, {0x14}, 0x1a6d, NULL},  // recursive fib
+  {"global", 1, {5}, 5, NULL},
+  {"global", 1, {7}, 0xc, NULL},
+  {"recurse", 1, {0}, 0, "call stack exhausted"},
+  {"unreachable", 0, {}, 0, "unreachable executed"},
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+// Module assembly
+
+typedef struct {
+  uint8_t bytes[16384];
+  size_t size;
+} buffer_t;
+
+static buffer_t module, section, body;
+
+static void put_byte(buffer_t *b, uint8_t byte) {
+  if (b->size == sizeof(b->bytes)) {
+    fprintf(stderr, "wasm-conformance: module too large\n");
+    exit(1);
+  }
+  b->bytes[b->size++] = byte;
+}
+
+static void put_bytes(buffer_t *b, const void *bytes, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    put_byte(b, ((const uint8_t *)bytes)[i]);
+  }
+}
+
+static void put_uleb(buffer_t *b, uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    put_byte(b, (uint8_t)(byte | (value ? 0x80 : 0)));
+  } while (value);
+}
+
+static void put_name(buffer_t *b, const char *name) {
+  put_uleb(b, strlen(name));
+  put_bytes(b, name, strlen(name));
+}
+
+static uint8_t value_type(char type) {
+  return type == 'i' ? 0x7f : type == 'I' ? 0x7e : type == 'f' ? 0x7d : 0x7c;
+}
+
+static void put_types(buffer_t *b, const char *types) {
+  put_uleb(b, strlen(types));
+  for (const char *t = types; *t; t++) {
+    put_byte(b, value_type(*t));
+  }
+}
+
+static void put_func_type(buffer_t *b, const char *params, const char *results) {
+  put_byte(b, 0x60);
+  put_types(b, params);
+  put_types(b, results);
+}
+
+static void end_section(uint8_t id) {
+  put_byte(&module, id);
+  put_uleb(&module, section.size);
+  put_bytes(&module, section.bytes, section.size);
+  section.size = 0;
+}
+
+static void assemble(void) {
+  static const uint8_t header[] = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+  put_bytes(&module, header, sizeof(header));
+
+  put_uleb(&section, FUNC_COUNT + 2);
+  put_func_type(&section, "", "ii");
+  put_func_type(&section, "ii", "i");
+  for (size_t i = 0; i < FUNC_COUNT; i++) {
+    put_func_type(&section, funcs[i].params, funcs[i].results);
+  }
+  end_section(1);
+
+  // (import "env" "memory" (memory 1 2))
+  put_uleb(&section, 1);
+  put_name(&section, "env");
+  put_name(&section, "memory");
+  put_bytes(&section, "\x02\x01\x01\x02", 4);
+  end_section(2);
+
+  put_uleb(&section, FUNC_COUNT);
+  for (size_t i = 0; i < FUNC_COUNT; i++) {
+    put_uleb(&section, i + 2);
+  }
+  end_section(3);
+
+  // (table 4 funcref)
+  put_bytes(&section, "\x01\x70\x00\x04", 4);
+  end_section(4);
+
+  // (global (mut i32) (i32.const 0))
+  put_bytes(&section, "\x01\x7f\x01\x41\x00\x0b", 6);
+  end_section(6);
+
+  put_uleb(&section, FUNC_COUNT);
+  for (size_t i = 0; i < FUNC_COUNT; i++) {
+    put_name(&section, funcs[i].name);
+    put_byte(&section, 0);
+    put_uleb(&section, i);
+  }
+  end_section(7);
+
+  // (elem (i32.const 0) 0 1 2)
+  put_bytes(&section, "\x01\x00\x41\x00\x0b\x03\x00\x01\x02", 9);
+  end_section(9);
+
+  put_uleb(&section, 1);
+  end_section(12);
+
+  put_uleb(&section, FUNC_COUNT);
+  for (size_t i = 0; i < FUNC_COUNT; i++) {
+    size_t locals = strlen(funcs[i].locals);
+    put_uleb(&body, locals);
+    for (size_t j = 0; j < locals; j++) {
+      put_uleb(&body, 1);
+      put_byte(&body, value_type(funcs[i].locals[j]));
+    }
+    put_bytes(&body, funcs[i].code, funcs[i].code_size);
+    put_byte(&body, 0x0b);
+    put_uleb(&section, body.size);
+    put_bytes(&section, body.bytes, body.size);
+    body.size = 0;
+  }
+  end_section(10);
+
+  // (data "wasm"), passive
+  put_bytes(&section, "\x01\x01\x04wasm", 7);
+  end_section(11);
+}
+
+// Running the cases
+
+static FILE *report;
+
+static const conformance_func_t *find_func(const char *name) {
+  for (size_t i = 0; i < FUNC_COUNT; i++) {
+    if (strcmp(funcs[i].name, name) == 0) {
+      return &funcs[i];
+    }
+  }
+  return NULL;
+}
+
+static uint64_t call(host_wasm_module_t *wasm, const conformance_case_t *c) {
+  const conformance_func_t *func = find_func(c->name);
+  uint64_t result = host_wasm_call(wasm, c->name, c->args, c->count);
+  return !func->results[0] ? 0 : func->results[0] == 'i' ? (uint32_t)result : result;
+}
+
+// Run a trap case in a child, true if it exited with the expected message
+static bool traps(host_wasm_module_t *wasm, const conformance_case_t *c, char *message, size_t size) {
+  int pipe_fds[2];
+  fflush(report);
+  fflush(stderr);
+  if (pipe(pipe_fds) != 0) {
+    return false;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(pipe_fds[1], STDERR_FILENO);
+    close(pipe_fds[0]);
+    call(wasm, c);
+    _exit(0);
+  }
+  close(pipe_fds[1]);
+  size_t used = 0;
+  ssize_t n;
+  while (used + 1 < size && (n = read(pipe_fds[0], message + used, size - used - 1)) > 0) {
+    used += (size_t)n;
+  }
+  message[used] = '\0';
+  message[strcspn(message, "\n")] = '\0';
+  close(pipe_fds[0]);
+  int status = 0;
+  if (pid < 0 || waitpid(pid, &status, 0) != pid) {
+    return false;
+  }
+  const char *prefix = "wokwi-wasm: trap: ";
+  return WIFEXITED(status) && WEXITSTATUS(status) == 1 &&
+         strncmp(message, prefix, strlen(prefix)) == 0 && strcmp(message + strlen(prefix), c->trap) == 0;
+}
+
+int main(int argc, char **argv) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  assemble();
+  if (argc > 1) {
+    FILE *out = fopen(argv[1], "wb");
+    if (!out || fwrite(module.bytes, 1, module.size, out) != module.size || fclose(out) != 0) {
+      fprintf(report, "cannot write %s\n", argv[1]);
+      return 1;
+    }
+  }
+
+  char error[256];
+  host_wasm_module_t *wasm = host_wasm_load_bytes(module.bytes, module.size, error, sizeof(error));
+  if (!wasm) {
+    fprintf(report, "module (%zu bytes) rejected: %s\n", module.size, error);
+    return 1;
+  }
+  host_reset();
+  host_wasm_chip_init(wasm);
+
+  uint32_t failed = 0, trap_count = 0;
+  for (size_t i = 0; i < CASE_COUNT; i++) {
+    const conformance_case_t *c = &cases[i];
+    char got[256];
+    bool ok;
+    if (!find_func(c->name)) {
+      snprintf(got, sizeof(got), "no such export");
+      ok = false;
+    } else if (c->trap) {
+      trap_count++;
+      ok = traps(wasm, c, got, sizeof(got));
+    } else {
+      uint64_t result = call(wasm, c);
+      snprintf(got, sizeof(got), "0x%llx", (unsigned long long)result);
+      ok = result == c->expected;
+    }
+    if (!ok) {
+      failed++;
+      fprintf(report, "  FAILED %s(0x%llx, 0x%llx, 0x%llx): got %s, expected ", c->name,
+              (unsigned long long)c->args[0], (unsigned long long)c->args[1],
+              (unsigned long long)c->args[2], got);
+      if (c->trap) {
+        fprintf(report, "trap: %s\n", c->trap);
+      } else {
+        fprintf(report, "0x%llx\n", (unsigned long long)c->expected);
+      }
+    }
+  }
+  fprintf(report, "conformance: %zu exports, %zu cases (%u traps), %zu-byte module, failed: %u\n",
+          FUNC_COUNT, CASE_COUNT, trap_count, module.size, failed);
+
+  host_reset();
+  host_wasm_free(wasm);
+  fclose(report);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * WebAssembly runtime benchmark
+ *
+ * Toggler: a chip that flips OUT from a 10 us repeating timer, once as
+ * native C and once as a wasm module built the way the Makefile links
+ * chips (imported memory, exported table, callback by table index), each
+ * run for 10 simulated seconds. Reports wall time per callback, wasm
+ * instructions and import calls per callback, and checks both runs made the
+ * same import calls and edges.
+ *
+ * Import overhead: a wasm loop calling getSimNanos against the same loop
+ * with a constant in its place, best of three rounds. The difference per
+ * iteration is what a call from wasm into the host costs; less the native
+ * call's own cost, that is the binding's.
+ *
+ * A3144: dist/a3144.chip.wasm (make build) against the native chip, with
+ * default attributes for 10 simulated seconds: OUT edges, import calls,
+ * instructions and wall time per chip callback. Skipped when the file is
+ * not there.
+ *
+ * Runtime: the freestanding dist/a3144.chip.wasm (common/chip-rt.h) against
+ * the same chip on WASI libc, dist/a3144.libc.chip.wasm (make libc): module
+ * size, load (decode) time and instantiation through chipInit, best of
+ * COST_ROUNDS. Skipped without both files.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-wasm.h"
+
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#undef timer_t
+
+#define SIM_SECONDS 10
+#define SPIN_CALLS 10000000u
+#define SPIN_ROUNDS 3
+#define CHIP_WASM "dist/a3144.chip.wasm"
+#define CHIP_LIBC_WASM "dist/a3144.libc.chip.wasm"
+#define COST_ROUNDS 20
+
+// The toggler as a wasm module, in WAT:
+//
+//   (import "env" "memory" (memory 1))
+//   (import "env" "pinInit" (func $pinInit (param i32 i32) (result i32)))
+//   (import "env" "pinWrite" (func $pinWrite (param i32 i32)))
+//   (import "env" "timerInit" (func $timerInit (param i32) (result i32)))
+//   (import "env" "timerStart" (func $timerStart (param i32 i32 i32)))
+//   (import "env" "getSimNanos" (func $getSimNanos (result f64)))
+//   (table (export "__indirect_function_table") 2 funcref)
+//   (elem (i32.const 1) $tick)
+//   (data (i32.const 16) "OUT\00")
+//   (data (i32.const 32) "\00\00\00\00\01\00\00\00")   ;; timer config
+//   (func (export "chipInit")
+//     (i32.store (i32.const 0) (call $pinInit (i32.const 16) (i32.const 1)))
+//     (i32.store (i32.const 4) (call $timerInit (i32.const 32)))
+//     (call $timerStart (i32.load (i32.const 4)) (i32.const 10) (i32.const 1)))
+//   (func $tick (param $user_data i32) (local $state i32)
+//     (i32.store (i32.const 8) (local.tee $state (i32.eqz (i32.load (i32.const 8)))))
+//     (call $pinWrite (i32.load (i32.const 0)) (local.get $state)))
+//   (func (export "spinCalls") (param $n i32) (result i32) (local $i i32)
+//     (block (br_if 0 (i32.eqz (local.get $n)))
+//       (loop (drop (call $getSimNanos))
+//         (local.set $i (i32.add (local.get $i) (i32.const 1)))
+//         (br_if 0 (local.tee $n (i32.sub (local.get $n) (i32.const 1))))))
+//     (local.get $i))
+//   (func (export "spinPlain") ...)   ;; spinCalls with (f64.const 0)
+static const uint8_t toggler_wasm[] = {
+  // header
+  0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,
+  // types
+  0x01, 0x22, 0x07, 0x60, 0x00, 0x00, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f, 0x60, 0x02, 0x7f, 0x7f,
+  0x00, 0x60, 0x01, 0x7f, 0x01, 0x7f, 0x60, 0x03, 0x7f, 0x7f, 0x7f, 0x00, 0x60, 0x00, 0x01, 0x7c,
+  0x60, 0x01, 0x7f, 0x00,
+  // imports
+  0x02, 0x5f, 0x06, 0x03, 0x65, 0x6e, 0x76, 0x06, 0x6d, 0x65, 0x6d, 0x6f, 0x72, 0x79, 0x02, 0x00,
+  0x01, 0x03, 0x65, 0x6e, 0x76, 0x07, 0x70, 0x69, 0x6e, 0x49, 0x6e, 0x69, 0x74, 0x00, 0x01, 0x03,
+  0x65, 0x6e, 0x76, 0x08, 0x70, 0x69, 0x6e, 0x57, 0x72, 0x69, 0x74, 0x65, 0x00, 0x02, 0x03, 0x65,
+  0x6e, 0x76, 0x09, 0x74, 0x69, 0x6d, 0x65, 0x72, 0x49, 0x6e, 0x69, 0x74, 0x00, 0x03, 0x03, 0x65,
+  0x6e, 0x76, 0x0a, 0x74, 0x69, 0x6d, 0x65, 0x72, 0x53, 0x74, 0x61, 0x72, 0x74, 0x00, 0x04, 0x03,
+  0x65, 0x6e, 0x76, 0x0b, 0x67, 0x65, 0x74, 0x53, 0x69, 0x6d, 0x4e, 0x61, 0x6e, 0x6f, 0x73, 0x00,
+  0x05,
+  // functions
+  0x03, 0x05, 0x04, 0x00, 0x06, 0x03, 0x03,
+  // table
+  0x04, 0x04, 0x01, 0x70, 0x00, 0x02,
+  // exports
+  0x07, 0x40, 0x04, 0x08, 0x63, 0x68, 0x69, 0x70, 0x49, 0x6e, 0x69, 0x74, 0x00, 0x05, 0x09, 0x73,
+  0x70, 0x69, 0x6e, 0x43, 0x61, 0x6c, 0x6c, 0x73, 0x00, 0x07, 0x09, 0x73, 0x70, 0x69, 0x6e, 0x50,
+  0x6c, 0x61, 0x69, 0x6e, 0x00, 0x08, 0x19, 0x5f, 0x5f, 0x69, 0x6e, 0x64, 0x69, 0x72, 0x65, 0x63,
+  0x74, 0x5f, 0x66, 0x75, 0x6e, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x5f, 0x74, 0x61, 0x62, 0x6c, 0x65,
+  0x01, 0x00,
+  // elements
+  0x09, 0x07, 0x01, 0x00, 0x41, 0x01, 0x0b, 0x01, 0x06,
+  // code: chipInit
+  0x0a, 0x8f, 0x01, 0x04,
+  0x21, 0x00, 0x41, 0x00, 0x41, 0x10, 0x41, 0x01, 0x10, 0x00, 0x36, 0x02, 0x00, 0x41, 0x04, 0x41,
+  0x20, 0x10, 0x02, 0x36, 0x02, 0x00, 0x41, 0x04, 0x28, 0x02, 0x00, 0x41, 0x0a, 0x41, 0x01, 0x10,
+  0x03, 0x0b,
+  // tick
+  0x1a, 0x01, 0x01, 0x7f, 0x41, 0x08, 0x41, 0x08, 0x28, 0x02, 0x00, 0x45, 0x22, 0x01, 0x36, 0x02,
+  0x00, 0x41, 0x00, 0x28, 0x02, 0x00, 0x20, 0x01, 0x10, 0x01, 0x0b,
+  // spinCalls
+  0x24, 0x01, 0x01, 0x7f, 0x02, 0x40, 0x20, 0x00, 0x45, 0x0d, 0x00, 0x03, 0x40, 0x10, 0x04, 0x1a,
+  0x20, 0x01, 0x41, 0x01, 0x6a, 0x21, 0x01, 0x20, 0x00, 0x41, 0x01, 0x6b, 0x22, 0x00, 0x0d, 0x00,
+  0x0b, 0x0b, 0x20, 0x01, 0x0b,
+  // spinPlain
+  0x2b, 0x01, 0x01, 0x7f, 0x02, 0x40, 0x20, 0x00, 0x45, 0x0d, 0x00, 0x03, 0x40, 0x44, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1a, 0x20, 0x01, 0x41, 0x01, 0x6a, 0x21, 0x01, 0x20, 0x00,
+  0x41, 0x01, 0x6b, 0x22, 0x00, 0x0d, 0x00, 0x0b, 0x0b, 0x20, 0x01, 0x0b,
+  // data
+  0x0b, 0x17, 0x02, 0x00, 0x41, 0x10, 0x0b, 0x04, 0x4f, 0x55, 0x54, 0x00, 0x00, 0x41, 0x20, 0x0b,
+  0x08, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+};
+
+void chip_init(void);
+
+static FILE *report;
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// The toggler in C, as the module does it
+static struct {
+  pin_t pin;
+  wokwi_timer_t timer;
+  uint32_t state;
+} toggler;
+
+static void toggler_tick(void *user_data) {
+  (void)user_data;
+  toggler.state = !toggler.state;
+  pin_write(toggler.pin, toggler.state);
+}
+
+static void toggler_init(void) {
+  toggler.state = 0;
+  toggler.pin = pin_init("OUT", OUTPUT);
+  const timer_config_t config = {.user_data = NULL, .callback = toggler_tick};
+  toggler.timer = timer_init(&config);
+  timer_start(toggler.timer, 10, true);
+}
+
+typedef struct {
+  double wall_s;
+  uint64_t edges;
+  uint64_t imports;
+  uint64_t callbacks;
+  host_wasm_stats_t wasm;
+} run_t;
+
+// One chip for SIM_SECONDS, native when module is NULL
+static run_t run(void (*native_init)(void), host_wasm_module_t *module) {
+  run_t result = {0};
+  host_reset();
+  double begin = wall_seconds();
+  if (module) {
+    host_wasm_chip_init(module);
+  } else {
+    native_init();
+  }
+  host_run_until(HOST_SEC(SIM_SECONDS));
+  result.wall_s = wall_seconds() - begin;
+  result.edges = host_pin_edges("OUT");
+  result.imports = host_import_calls(host_counters());
+  result.callbacks = host_counters()->callbacks;
+  if (module) {
+    result.wasm = *host_wasm_stats(module);
+  }
+  host_reset();
+  return result;
+}
+
+static void print_run(const char *name, const run_t *r, bool wasm) {
+  double callbacks = r->callbacks ? (double)r->callbacks : 1;
+  fprintf(report, "  %-8s %9lu %9lu %10lu %9.1f %8.1f", name, (unsigned long)r->edges,
+          (unsigned long)r->callbacks, (unsigned long)r->imports, r->wall_s * 1e3,
+          r->wall_s * 1e9 / callbacks);
+  if (wasm) {
+    fprintf(report, " %8.1f\n", r->wasm.instructions / callbacks);
+  } else {
+    fprintf(report, " %8s\n", "-");
+  }
+}
+
+static void print_header(void) {
+  fprintf(report, "  %-8s %9s %9s %10s %9s %8s %8s\n", "run", "edges", "callbacks", "imports",
+          "wall_ms", "ns/cb", "insn/cb");
+}
+
+// Both runs made the same import calls, each one through the wasm bindings
+static bool same_runs(const run_t *native, const run_t *wasm) {
+  return native->edges == wasm->edges && native->callbacks == wasm->callbacks &&
+         native->imports == wasm->imports && wasm->wasm.host_calls == wasm->imports;
+}
+
+static volatile double sink;
+
+// Best of SPIN_ROUNDS, native when module is NULL
+static double spin_ns(host_wasm_module_t *module, const char *name, bool *ok) {
+  double best = 0;
+  for (unsigned round = 0; round < SPIN_ROUNDS; round++) {
+    uint64_t n = SPIN_CALLS, count = 0;
+    double begin = wall_seconds();
+    if (module) {
+      count = host_wasm_call(module, name, &n, 1);
+    } else {
+      for (; count < n; count++) {
+        sink = get_sim_nanos_d();
+      }
+    }
+    double ns = (wall_seconds() - begin) * 1e9 / SPIN_CALLS;
+    best = round == 0 || ns < best ? ns : best;
+    *ok = *ok && count == SPIN_CALLS;
+  }
+  return best;
+}
+
+static bool toggler_run(void) {
+  char error[128];
+  host_wasm_module_t *module = host_wasm_load_bytes(toggler_wasm, sizeof(toggler_wasm), error, sizeof(error));
+  if (!module) {
+    fprintf(report, "toggler: module rejected: %s\n", error);
+    return false;
+  }
+  run_t native = run(toggler_init, NULL);
+  run_t wasm = run(NULL, module);
+  bool ok = same_runs(&native, &wasm) && native.edges == SIM_SECONDS * 100000ull;
+
+  fprintf(report, "toggler: OUT flipped every 10 us for %u s\n", SIM_SECONDS);
+  print_header();
+  print_run("native", &native, false);
+  print_run("wasm", &wasm, true);
+  fprintf(report, "  wasm/native %.1fx per callback, same imports and edges: %s\n",
+          wasm.wall_s / native.wall_s, ok ? "yes" : "NO");
+
+  // Import overhead, the spin loops in the same instance
+  host_reset();
+  host_wasm_chip_init(module);
+  host_wasm_stats_t before = *host_wasm_stats(module);
+  bool spin_ok = true;
+  double plain_ns = spin_ns(module, "spinPlain", &spin_ok);
+  host_wasm_stats_t middle = *host_wasm_stats(module);
+  double calls_ns = spin_ns(module, "spinCalls", &spin_ok);
+  host_wasm_stats_t after = *host_wasm_stats(module);
+  double native_ns = spin_ns(NULL, NULL, &spin_ok);
+  spin_ok = spin_ok && host_counters()->get_sim_nanos == 2ull * SPIN_ROUNDS * SPIN_CALLS &&
+            after.host_calls - middle.host_calls == (uint64_t)SPIN_ROUNDS * SPIN_CALLS &&
+            middle.host_calls == before.host_calls;
+  host_reset();
+  host_wasm_free(module);
+
+  fprintf(report, "import overhead: %u iterations, best of %u, %.1f insn each\n", SPIN_CALLS, SPIN_ROUNDS,
+          (double)(middle.instructions - before.instructions) / SPIN_ROUNDS / SPIN_CALLS);
+  fprintf(report, "  %-22s %6.2f ns\n", "spinPlain iteration", plain_ns);
+  fprintf(report, "  %-22s %6.2f ns\n", "spinCalls iteration", calls_ns);
+  fprintf(report, "  %-22s %6.2f ns\n", "native getSimNanos", native_ns);
+  fprintf(report, "  getSimNanos binding %.2f ns per call on top of native, counted: %s\n",
+          calls_ns - plain_ns - native_ns, spin_ok ? "yes" : "NO");
+  return ok && spin_ok;
+}
+
+static bool chip_run(void) {
+  if (access(CHIP_WASM, R_OK) != 0) {
+    fprintf(report, "a3144: skipped, no %s (make build)\n", CHIP_WASM);
+    return true;
+  }
+  char error[128];
+  host_wasm_module_t *module = host_wasm_load(CHIP_WASM, error, sizeof(error));
+  if (!module) {
+    fprintf(report, "a3144: %s rejected: %s\n", CHIP_WASM, error);
+    return false;
+  }
+  run_t native = run(chip_init, NULL);
+  run_t wasm = run(NULL, module);
+  host_wasm_free(module);
+  bool ok = same_runs(&native, &wasm);
+
+  fprintf(report, "a3144: %s, default attributes for %u s\n", CHIP_WASM, SIM_SECONDS);
+  print_header();
+  print_run("native", &native, false);
+  print_run("wasm", &wasm, true);
+  fprintf(report, "  wasm/native %.1fx per callback, same imports and edges: %s\n",
+          wasm.wall_s / native.wall_s, ok ? "yes" : "NO");
+  return ok;
+}
+
+typedef struct {
+  long bytes;
+  double load_us;
+  double init_us;
+} module_cost_t;
+
+// Best of COST_ROUNDS loads and instantiations, false if the module is rejected
+static bool module_cost(const char *path, module_cost_t *cost) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return false;
+  }
+  cost->bytes = (long)st.st_size;
+  cost->load_us = cost->init_us = 1e30;
+  char error[128];
+  for (int i = 0; i < COST_ROUNDS; i++) {
+    double begin = wall_seconds();
+    host_wasm_module_t *module = host_wasm_load(path, error, sizeof(error));
+    double loaded = wall_seconds();
+    if (!module) {
+      fprintf(report, "runtime: %s rejected: %s\n", path, error);
+      return false;
+    }
+    host_reset();
+    host_wasm_chip_init(module);
+    double end = wall_seconds();
+    host_reset();
+    host_wasm_free(module);
+    cost->load_us = (loaded - begin) * 1e6 < cost->load_us ? (loaded - begin) * 1e6 : cost->load_us;
+    cost->init_us = (end - loaded) * 1e6 < cost->init_us ? (end - loaded) * 1e6 : cost->init_us;
+  }
+  return true;
+}
+
+static bool runtime_run(void) {
+  if (access(CHIP_WASM, R_OK) != 0 || access(CHIP_LIBC_WASM, R_OK) != 0) {
+    fprintf(report, "runtime: skipped, needs %s (make build) and %s (make libc)\n", CHIP_WASM, CHIP_LIBC_WASM);
+    return true;
+  }
+  module_cost_t freestanding, libc;
+  if (!module_cost(CHIP_WASM, &freestanding) || !module_cost(CHIP_LIBC_WASM, &libc)) {
+    return false;
+  }
+  fprintf(report, "runtime: a3144 freestanding against WASI libc, best of %u\n", COST_ROUNDS);
+  fprintf(report, "  %-28s %8s %9s %9s\n", "module", "bytes", "load_us", "init_us");
+  fprintf(report, "  %-28s %8ld %9.1f %9.1f\n", CHIP_WASM, freestanding.bytes, freestanding.load_us,
+          freestanding.init_us);
+  fprintf(report, "  %-28s %8ld %9.1f %9.1f\n", CHIP_LIBC_WASM, libc.bytes, libc.load_us, libc.init_us);
+  fprintf(report, "  freestanding: %.0f%% of the bytes, %.0f%% of the load and instantiation time\n",
+          100.0 * freestanding.bytes / libc.bytes,
+          100.0 * (freestanding.load_us + freestanding.init_us) / (libc.load_us + libc.init_us));
+  return true;
+}
+
+int main(void) {
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+  bool ok = toggler_run();
+  ok = chip_run() && ok;
+  ok = runtime_run() && ok;
+  fclose(report);
+  return ok ? 0 : 1;
+}
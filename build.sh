@@ -1,6 +1,21 @@
 #!/bin/bash
 # Build script for Wokwi custom chips
 # This script compiles all chip source files to WebAssembly binaries
+#
+# Usage: ./build.sh [-j N] [--no-cache]
+#
+# Every directory with both a chip.c and a chip.json is built, like the
+# Makefile's CHIPS, to dist/<dir>.chip.wasm and dist/<dir>.chip.json.
+# -j N builds up to N chips at a time, each with its output captured to
+# build/logs/<dir>.log and replayed in chip order.
+#
+# Built modules are kept in a content-addressed cache (build/cache, or
+# $CHIP_CACHE_DIR). A chip whose sources, headers, chip.json and compiler
+# are unchanged is copied from there instead of being compiled again.
+# --no-cache compiles every chip and refreshes its cache entry.
+#
+# CHIP_COMPILER=clang skips wokwi-cli and builds with the Makefile's clang
+# command, freestanding on common/chip-rt.h; CI builds releases that way.
 
 set -euo pipefail  # Exit on error, undefined vars, and pipe failures
 IFS=$'\n\t'         # Set safe internal field separator
@@ -31,20 +46,132 @@ log_error() {
     echo -e "${RED}[ERROR]${NC} $1" >&2
 }
 
-# Check if wokwi-cli is installed
+# Compiler: wokwi-cli, or else (or with CHIP_COMPILER=clang) the clang
+# command of the Makefile
+CHIP_COMPILER=${CHIP_COMPILER:-}
+COMPILER=""
+COMPILER_ID=""
+CLANG_CMD=()
+
+# Build cache
+CACHE_DIR=${CHIP_CACHE_DIR:-build/cache}
+USE_CACHE=1
+# hit or miss, set by build_chip for the summary
+CACHE_RESULT=""
+
+# Per-chip output and exit status of parallel builds
+LOG_DIR=build/logs
+JOBS=1
+# Process IDs of the chip jobs, in chip order
+JOB_PIDS=()
+
+# Check if wokwi-cli is installed, fall back to clang if it is not
 check_wokwi_cli() {
-    if ! command -v wokwi-cli &> /dev/null; then
-        log_error "wokwi-cli is not installed"
-        echo "Installation options:"
-        echo "  1. Run: npm install -g wokwi-cli"
-        echo "  2. Visit: https://github.com/wokwi/wokwi-cli"
+    if [[ $CHIP_COMPILER != "clang" ]] && command -v wokwi-cli &> /dev/null; then
+        # Check version (requires v0.20.0 or later for chip compilation)
+        local version
+        version=$(wokwi-cli --version 2>/dev/null | grep -oE '[0-9]+\.[0-9]+\.[0-9]+' || echo "0.0.0")
+        log_info "wokwi-cli version: $version"
+        COMPILER="wokwi-cli"
+        COMPILER_ID="wokwi-cli $version"
+        return 0
+    fi
+
+    # The Makefile's compiler and flags, if that clang can link wasm32
+    local cmd
+    cmd=$(make -s --no-print-directory print-cc 2>/dev/null || true)
+    IFS=' ' read -r -a CLANG_CMD <<< "$cmd"
+    if [[ ${#CLANG_CMD[@]} -gt 0 ]] && printf 'void chip_init(void) {}\n' |
+            "${CLANG_CMD[@]}" -o /dev/null -x c - &> /dev/null; then
+        if [[ $CHIP_COMPILER == "clang" ]]; then
+            log_info "CHIP_COMPILER=clang, building with: $cmd"
+        else
+            log_warn "wokwi-cli not found, building with: $cmd"
+        fi
+        COMPILER="clang"
+        COMPILER_ID="$("${CLANG_CMD[0]}" --version 2>/dev/null | head -n 1) $cmd"
+        return 0
+    fi
+
+    if [[ $CHIP_COMPILER == "clang" ]]; then
+        log_error "CHIP_COMPILER=clang, but no clang for wasm32 was found"
         exit 1
     fi
+    log_error "wokwi-cli is not installed, and no clang for wasm32 was found"
+    echo "Installation options:"
+    echo "  1. Run: npm install -g wokwi-cli"
+    echo "  2. Visit: https://github.com/wokwi/wokwi-cli"
+    echo "  3. Install clang with wasm32-unknown-wasi support (see the Makefile)"
+    exit 1
+}
+
+# SHA-256 of stdin, or of the files given
+sha256() {
+    if command -v sha256sum &> /dev/null; then
+        sha256sum "$@"
+    else
+        shasum -a 256 "$@"
+    fi
+}
 
-    # Check version (requires v0.20.0 or later for chip compilation)
-    local version
-    version=$(wokwi-cli --version 2>/dev/null | grep -oE '[0-9]+\.[0-9]+\.[0-9]+' || echo "0.0.0")
-    log_info "wokwi-cli version: $version"
+# Path with "." and "dir/.." parts removed
+normalize_path() {
+    local IFS=/ part parts out=()
+    read -r -a parts <<< "$1"
+    for part in "${parts[@]}"; do
+        case $part in
+            ''|.) ;;
+            ..)
+                if [[ ${#out[@]} -gt 0 && ${out[${#out[@]}-1]} != ".." ]]; then
+                    unset "out[${#out[@]}-1]"
+                else
+                    out+=("..")
+                fi
+                ;;
+            *) out+=("$part") ;;
+        esac
+    done
+    echo "${out[*]}"
+}
+
+# A source file and every file it pulls in with #include "...", resolved
+# against the including file's directory. Headers that do not exist (such
+# as a wokwi-api.h wokwi-cli downloads) are left out.
+list_sources() {
+    local file
+    file=$(normalize_path "$1")
+    if [[ ! -f "$file" ]] || grep -qxF "$file" <<< "$SOURCES_SEEN"; then
+        return 0
+    fi
+    SOURCES_SEEN+="$file"$'\n'
+    echo "$file"
+
+    local dir include
+    dir=$(dirname "$file")
+    for include in $(sed -nE 's/^[[:space:]]*#[[:space:]]*include[[:space:]]*"([^"]+)".*/\1/p' "$file"); do
+        list_sources "$dir/$include"
+    done
+}
+
+# Cache key of a chip: compiler, the hash of each source and header file
+# under its path, and chip.json
+cache_key() {
+    local chip_dir=$1
+    local sources
+    SOURCES_SEEN=""
+    sources=$(list_sources "$chip_dir/chip.c" | sort)
+    {
+        echo "$COMPILER_ID"
+        # shellcheck disable=SC2086
+        sha256 $sources "$chip_dir/chip.json"
+    } | sha256 | cut -c1-64
+}
+
+# Milliseconds, for the build times
+now_ms() {
+    local now=${EPOCHREALTIME:-$(date +%s).000000}
+    now=${now/[.,]/}
+    echo $((10#$now / 1000))
 }
 
 # Validate chip directory structure
@@ -90,8 +217,29 @@ build_chip() {
         return 1
     fi
 
+    local key entry start
+    start=$(now_ms)
+    key=$(cache_key "$chip_dir")
+    entry="$CACHE_DIR/$key"
+
+    # Cache hit: copy the artifacts of the same inputs
+    if [[ $USE_CACHE -eq 1 && -f "$entry/chip.wasm" && -f "$entry/chip.json" ]]; then
+        if cp "$entry/chip.wasm" "$output_file" && cp "$entry/chip.json" "dist/${chip_name}.chip.json"; then
+            CACHE_RESULT=hit
+            log_info "Cached $chip_name: $output_file ($(du -h "$output_file" | cut -f1), key ${key:0:12}, $(( $(now_ms) - start )) ms)"
+            return 0
+        fi
+        log_warn "Could not copy $chip_name from $entry, compiling"
+    fi
+    CACHE_RESULT=miss
+
     # Compile the chip
-    if ! wokwi-cli chip compile "$chip_dir/chip.c" -o "$output_file"; then
+    if [[ $COMPILER == "wokwi-cli" ]]; then
+        if ! wokwi-cli chip compile "$chip_dir/chip.c" -o "$output_file"; then
+            log_error "Failed to compile $chip_name"
+            return 1
+        fi
+    elif ! "${CLANG_CMD[@]}" -o "$output_file" "$chip_dir/chip.c"; then
         log_error "Failed to compile $chip_name"
         return 1
     fi
@@ -108,16 +256,93 @@ build_chip() {
         return 1
     fi
 
+    # Store in the cache, renamed into place so that an interrupted or
+    # concurrent build never leaves a partial entry
+    local staging
+    if mkdir -p "$CACHE_DIR" && staging=$(mktemp -d "$CACHE_DIR/.staging.XXXXXX"); then
+        if cp "$output_file" "$staging/chip.wasm" && cp "$chip_dir/chip.json" "$staging/chip.json"; then
+            rm -rf "$entry"
+            mv "$staging" "$entry" 2>/dev/null || true
+        fi
+        rm -rf "$staging"
+    else
+        log_warn "Could not write the cache entry for $chip_name"
+    fi
+
     # Get file size
     local size
     size=$(du -h "$output_file" | cut -f1)
-    log_info "Built $chip_name: $output_file ($size)"
+    log_info "Built $chip_name: $output_file ($size, $(( $(now_ms) - start )) ms)"
 
     return 0
 }
 
+# Chips: every directory with both a chip.c and a chip.json, in name order,
+# the same rule as the Makefile's CHIPS
+discover_chips() {
+    local src
+    for src in */chip.c; do
+        if [[ -f "$src" && -f "$(dirname "$src")/chip.json" ]]; then
+            dirname "$src"
+        fi
+    done
+}
+
+# Build one chip as a background job: its output goes to its log, then
+# "<exit status> <cache result>" to its status file, renamed into place
+# last so that the status only appears once the log is complete
+start_chip_job() {
+    local chip=$1
+    (
+        local status=0
+        build_chip "$chip" "$chip" > "$LOG_DIR/$chip.log" 2>&1 || status=$?
+        echo "$status $CACHE_RESULT" > "$LOG_DIR/$chip.status.tmp"
+        mv "$LOG_DIR/$chip.status.tmp" "$LOG_DIR/$chip.status"
+    ) &
+    JOB_PIDS+=("$!")
+}
+
+usage() {
+    echo "Usage: $0 [-j N] [--no-cache]"
+    echo "  -j N        Build up to N chips at a time (default 1)"
+    echo "  --no-cache  Compile every chip, refreshing its entry in $CACHE_DIR"
+}
+
 # Main build process
 main() {
+    while [[ $# -gt 0 ]]; do
+        case $1 in
+            -j|--jobs)
+                JOBS=${2:-}
+                if [[ $# -gt 1 ]]; then
+                    shift
+                fi
+                ;;
+            -j*) JOBS=${1#-j} ;;
+            --no-cache) USE_CACHE=0 ;;
+            -h|--help)
+                usage
+                exit 0
+                ;;
+            *)
+                log_error "Unknown option: $1"
+                usage >&2
+                exit 1
+                ;;
+        esac
+        shift
+    done
+    if ! [[ $JOBS =~ ^[1-9][0-9]*$ ]]; then
+        log_error "-j needs a number of jobs, 1 or more"
+        exit 1
+    fi
+    # wait -n, to start the next chip when any job ends, is bash 4.3 or
+    # later; before that the pool waits for the oldest job still running
+    local wait_any=1
+    if [[ ${BASH_VERSINFO[0]} -lt 4 || ( ${BASH_VERSINFO[0]} -eq 4 && ${BASH_VERSINFO[1]} -lt 3 ) ]]; then
+        wait_any=0
+    fi
+
     log_info "Starting Wokwi custom chips build..."
 
     # Create dist directory
@@ -126,22 +351,94 @@ main() {
     # Check dependencies
     check_wokwi_cli
 
+    local chips=()
+    local chip
+    for chip in $(discover_chips); do
+        chips+=("$chip")
+    done
+    if [[ ${#chips[@]} -eq 0 ]]; then
+        log_error "No chips found: no */chip.c with a chip.json"
+        exit 1
+    fi
+    log_info "Building ${#chips[@]} chip(s), $JOBS at a time"
+
+    rm -rf "$LOG_DIR"
+    mkdir -p "$LOG_DIR"
+    trap 'kill $(jobs -p) 2>/dev/null; exit 130' INT TERM
+
     # Track build status
     local failed_builds=0
     local successful_builds=0
+    local cache_hits=0
+    local cache_misses=0
+    local started=0
+    local running=0
+    local replayed=0
+    local waited=-1
+    local start
+    start=$(now_ms)
 
-    # Build all chips (add new chips here)
-    if build_chip "a3144" "a3144"; then
-        ((successful_builds++))
-    else
-        ((failed_builds++))
-    fi
+    # Start up to JOBS chips; whenever one ends, replay the logs of the
+    # finished chips that are next in order, then start another
+    while [[ $replayed -lt ${#chips[@]} ]]; do
+        while [[ $started -lt ${#chips[@]} && $running -lt $JOBS ]]; do
+            start_chip_job "${chips[$started]}"
+            started=$((started + 1))
+            running=$((running + 1))
+        done
+        if [[ $running -gt 0 ]]; then
+            if [[ $wait_any -eq 1 ]]; then
+                wait -n 2>/dev/null || true
+            else
+                wait "${JOB_PIDS[$replayed]}" 2>/dev/null || true
+                waited=$replayed
+            fi
+            running=$((running - 1))
+        fi
+
+        while [[ $replayed -lt ${#chips[@]} && $replayed -lt $started ]]; do
+            chip=${chips[$replayed]}
+            local status=1 result=""
+            if [[ ! -f "$LOG_DIR/$chip.status" && $running -eq 0 ]]; then
+                # Its job has to have ended before the status counts as missing
+                wait "${JOB_PIDS[$replayed]}" 2>/dev/null || true
+            fi
+            if [[ -f "$LOG_DIR/$chip.status" ]]; then
+                IFS=" " read -r status result < "$LOG_DIR/$chip.status"
+            elif [[ $running -gt 0 && $waited -ne $replayed ]]; then
+                break
+            else
+                # Its job has ended without writing a status
+                log_error "Build of $chip ended without a status" >> "$LOG_DIR/$chip.log" 2>&1
+            fi
+            cat "$LOG_DIR/$chip.log" 2>/dev/null || true
+            if [[ $status -eq 0 ]]; then
+                successful_builds=$((successful_builds + 1))
+            else
+                failed_builds=$((failed_builds + 1))
+            fi
+            case $result in
+                hit) cache_hits=$((cache_hits + 1)) ;;
+                miss) cache_misses=$((cache_misses + 1)) ;;
+            esac
+            rm -f "$LOG_DIR/$chip.status"
+            replayed=$((replayed + 1))
+        done
+    done
+    wait
+    trap - INT TERM
 
     # Summary
     echo ""
     log_info "Build Summary"
     echo "  Successful: $successful_builds"
     echo "  Failed: $failed_builds"
+    if [[ $USE_CACHE -eq 1 ]]; then
+        echo "  Cache: $cache_hits hits, $cache_misses misses ($CACHE_DIR)"
+    else
+        echo "  Cache: off, $cache_misses compiled ($CACHE_DIR refreshed)"
+    fi
+    echo "  Time: $(( $(now_ms) - start )) ms, $JOBS job(s), logs in $LOG_DIR/"
 
     if [[ $failed_builds -gt 0 ]]; then
         log_error "Some chips failed to build"
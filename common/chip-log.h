@@ -0,0 +1,247 @@
+/*
+ * Ring-buffered binary logging for Wokwi custom chips
+ *
+ * Logging an event stores a fixed-size record (simulation timestamp, event
+ * id, up to three integer arguments) in a ring buffer. Nothing is formatted
+ * on the hot path: records are turned into text in batches by a low-rate
+ * one-shot timer, armed only while the ring holds records, or on demand with
+ * chip_log_flush(). When the ring is full the oldest record is overwritten
+ * and the next flush reports how many were lost.
+ *
+ * Levels are resolved at compile time: calls above CHIP_LOG_LEVEL compile
+ * to nothing, including their arguments.
+ *
+ * Include after wokwi-api.h. Usage:
+ *   enum { EV_INIT, EV_OUTPUT };
+ *   static const chip_log_event_t events[] = {
+ *     [EV_INIT] = {"initialized", {0}},
+ *     [EV_OUTPUT] = {"output", {"field", "out"}, 0x1},  // field is signed
+ *   };
+ *   chip_log_init("A3144", events);
+ *   chip_log_info(EV_OUTPUT, field, level, 0);
+ */
+
+#ifndef CHIP_LOG_H
+#define CHIP_LOG_H
+
+#include "chip-rt.h"
+#include "chip-thread.h"
+
+#define CHIP_LOG_NONE 0
+#define CHIP_LOG_ERROR 1
+#define CHIP_LOG_WARN 2
+#define CHIP_LOG_INFO 3
+#define CHIP_LOG_DEBUG 4
+
+#ifndef CHIP_LOG_LEVEL
+#define CHIP_LOG_LEVEL CHIP_LOG_INFO
+#endif
+
+// Number of records kept between flushes, must be a power of two
+#ifndef CHIP_LOG_RING_SIZE
+#define CHIP_LOG_RING_SIZE 64
+#endif
+
+// Delay between the first record entering an empty ring and its flush
+#ifndef CHIP_LOG_FLUSH_US
+#define CHIP_LOG_FLUSH_US 500000
+#endif
+
+#define CHIP_LOG_MAX_ARGS 3
+
+typedef struct {
+  const char *text;
+  const char *args[CHIP_LOG_MAX_ARGS];  // argument names, NULL when unused
+  uint8_t signed_args;                  // bit i set: args[i] is an int32_t
+} chip_log_event_t;
+
+typedef struct {
+  uint64_t timestamp;                   // simulation time in nanoseconds
+  uint16_t event;
+  uint16_t level;
+  uint32_t args[CHIP_LOG_MAX_ARGS];
+} chip_log_record_t;
+
+typedef struct {
+  const char *prefix;
+  const chip_log_event_t *events;
+  chip_log_record_t ring[CHIP_LOG_RING_SIZE];
+  uint32_t head;                        // next record to write
+  uint32_t tail;                        // oldest record not yet flushed
+  uint32_t lost;                        // records overwritten since the last flush
+  timer_t flush_timer;
+  bool timer_ready;
+  bool flush_armed;
+} chip_log_t;
+
+static CHIP_THREAD_LOCAL chip_log_t chip_log;
+
+static void chip_log_flush(void);
+
+static void chip_log_flush_callback(void *user_data) {
+  (void)user_data;
+  chip_log.flush_armed = false;
+  chip_log_flush();
+}
+
+// Register the chip's event table. Safe to call from every chip_init().
+static inline void chip_log_init(const char *prefix, const chip_log_event_t *events) {
+  chip_log.prefix = prefix;
+  chip_log.events = events;
+  if (!chip_log.timer_ready) {
+    const timer_config_t config = {
+      .callback = chip_log_flush_callback,
+      .user_data = NULL,
+    };
+    chip_log.flush_timer = timer_init(&config);
+    chip_log.timer_ready = true;
+  }
+}
+
+// Drop all records and forget the flush timer (native host resets only)
+static inline void chip_log_reset(void) {
+  chip_log.head = chip_log.tail = chip_log.lost = 0;
+  chip_log.timer_ready = false;
+  chip_log.flush_armed = false;
+}
+
+static inline void chip_log_write(uint16_t level, uint16_t event, uint32_t a0, uint32_t a1, uint32_t a2) {
+  if (chip_log.head - chip_log.tail == CHIP_LOG_RING_SIZE) {
+    chip_log.tail++;
+    chip_log.lost++;
+  }
+  chip_log_record_t *record = &chip_log.ring[chip_log.head++ & (CHIP_LOG_RING_SIZE - 1)];
+  record->timestamp = get_sim_nanos();
+  record->event = event;
+  record->level = level;
+  record->args[0] = a0;
+  record->args[1] = a1;
+  record->args[2] = a2;
+
+  if (!chip_log.flush_armed && chip_log.timer_ready) {
+    chip_log.flush_armed = true;
+    timer_start(chip_log.flush_timer, CHIP_LOG_FLUSH_US, false);
+  }
+}
+
+#if CHIP_LOG_LEVEL >= CHIP_LOG_ERROR
+#define chip_log_error(event, a0, a1, a2) chip_log_write(CHIP_LOG_ERROR, (event), (a0), (a1), (a2))
+#else
+#define chip_log_error(event, a0, a1, a2) ((void)0)
+#endif
+
+#if CHIP_LOG_LEVEL >= CHIP_LOG_WARN
+#define chip_log_warn(event, a0, a1, a2) chip_log_write(CHIP_LOG_WARN, (event), (a0), (a1), (a2))
+#else
+#define chip_log_warn(event, a0, a1, a2) ((void)0)
+#endif
+
+#if CHIP_LOG_LEVEL >= CHIP_LOG_INFO
+#define chip_log_info(event, a0, a1, a2) chip_log_write(CHIP_LOG_INFO, (event), (a0), (a1), (a2))
+#else
+#define chip_log_info(event, a0, a1, a2) ((void)0)
+#endif
+
+#if CHIP_LOG_LEVEL >= CHIP_LOG_DEBUG
+#define chip_log_debug(event, a0, a1, a2) chip_log_write(CHIP_LOG_DEBUG, (event), (a0), (a1), (a2))
+#else
+#define chip_log_debug(event, a0, a1, a2) ((void)0)
+#endif
+
+// Formatting, only reached from the flush path
+
+// Longest formatted record: prefix, event text and argument names are
+// expected to stay well within this
+#define CHIP_LOG_LINE_MAX 160
+
+typedef struct {
+  char data[1024];
+  uint32_t length;
+} chip_log_buffer_t;
+
+static void chip_log_emit(chip_log_buffer_t *buffer) {
+  chip_rt_write(buffer->data, buffer->length);
+  buffer->length = 0;
+}
+
+// Callers make room with chip_log_reserve() once per line
+static void chip_log_reserve(chip_log_buffer_t *buffer, uint32_t length) {
+  if (buffer->length + length > sizeof(buffer->data)) {
+    chip_log_emit(buffer);
+  }
+}
+
+static void chip_log_append(chip_log_buffer_t *buffer, const char *text) {
+  char *out = &buffer->data[buffer->length];
+  while (*text) {
+    *out++ = *text++;
+  }
+  buffer->length = (uint32_t)(out - buffer->data);
+}
+
+// Decimal, zero-padded to at least min_digits
+static void chip_log_append_u32(chip_log_buffer_t *buffer, uint32_t value, uint32_t min_digits) {
+  buffer->length += chip_rt_format_u64(&buffer->data[buffer->length], value, min_digits);
+}
+
+static void chip_log_append_i32(chip_log_buffer_t *buffer, int32_t value) {
+  buffer->length += chip_rt_format_i64(&buffer->data[buffer->length], value);
+}
+
+static const char *const chip_log_level_names[] = {"", "E", "W", "I", "D"};
+
+// Format and print every pending record, oldest first. A flush on demand
+// also cancels the scheduled one, so the timer is not left armed.
+static void chip_log_flush(void) {
+  if (chip_log.flush_armed) {
+    chip_log.flush_armed = false;
+    timer_stop(chip_log.flush_timer);
+  }
+  if (chip_log.head == chip_log.tail) {
+    return;
+  }
+
+  chip_log_buffer_t buffer;
+  buffer.length = 0;
+  if (chip_log.lost) {
+    chip_log_reserve(&buffer, CHIP_LOG_LINE_MAX);
+    chip_log_append(&buffer, chip_log.prefix);
+    chip_log_append(&buffer, ": ");
+    chip_log_append_u32(&buffer, chip_log.lost, 1);
+    chip_log_append(&buffer, " log records lost\n");
+    chip_log.lost = 0;
+  }
+
+  while (chip_log.tail != chip_log.head) {
+    const chip_log_record_t *record = &chip_log.ring[chip_log.tail++ & (CHIP_LOG_RING_SIZE - 1)];
+    const chip_log_event_t *event = &chip_log.events[record->event];
+
+    // [seconds.nanoseconds] L PREFIX: text name=value ...
+    chip_log_reserve(&buffer, CHIP_LOG_LINE_MAX);
+    chip_log_append(&buffer, "[");
+    chip_log_append_u32(&buffer, (uint32_t)(record->timestamp / 1000000000u), 1);
+    chip_log_append(&buffer, ".");
+    chip_log_append_u32(&buffer, (uint32_t)(record->timestamp % 1000000000u), 9);
+    chip_log_append(&buffer, "] ");
+    chip_log_append(&buffer, chip_log_level_names[record->level]);
+    chip_log_append(&buffer, " ");
+    chip_log_append(&buffer, chip_log.prefix);
+    chip_log_append(&buffer, ": ");
+    chip_log_append(&buffer, event->text);
+    for (uint32_t i = 0; i < CHIP_LOG_MAX_ARGS && event->args[i]; i++) {
+      chip_log_append(&buffer, " ");
+      chip_log_append(&buffer, event->args[i]);
+      chip_log_append(&buffer, "=");
+      if (event->signed_args & (1u << i)) {
+        chip_log_append_i32(&buffer, (int32_t)record->args[i]);
+      } else {
+        chip_log_append_u32(&buffer, record->args[i], 1);
+      }
+    }
+    chip_log_append(&buffer, "\n");
+  }
+  chip_log_emit(&buffer);
+  chip_rt_flush();
+}
+
+#endif /* CHIP_LOG_H */
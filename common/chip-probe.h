@@ -0,0 +1,507 @@
+/*
+ * Import call instrumentation for Wokwi custom chips
+ *
+ * Built with -DCHIP_PROBE, every wokwi-api.h import the chip calls goes
+ * through a wrapper that counts the call and adds its wall-clock duration
+ * to a per-import histogram (power-of-two buckets in nanoseconds). The
+ * stdio calls that end in WASI fd_write (printf, puts, fwrite, fflush) are
+ * counted the same way. Callbacks registered through the wrappers are
+ * routed through a trampoline, so the summary can give calls per callback
+ * and the time spent in chip code. Without CHIP_PROBE the header defines
+ * nothing but empty chip_probe_dump()/chip_probe_reset() macros.
+ *
+ * Include after wokwi-api.h and before anything else that calls imports
+ * (chip-log.h included), once per chip. Usage:
+ *   chip_probe_dump();   // summary to stdout, also exported as chipProbeDump
+ *
+ * A WASM build prints on demand when the host calls the chipProbeDump
+ * export (host/wokwi-wasm.h does), and every CHIP_PROBE_DUMP_US of
+ * simulated time when that is set. Durations come from timespec_get(),
+ * WASI clock_time_get in a WASM build, whose resolution is the host's;
+ * define CHIP_PROBE_CLOCK_NS() to use another clock. The experimental
+ * _mcu* calls are not wrapped.
+ */
+
+#ifndef CHIP_PROBE_H
+#define CHIP_PROBE_H
+
+#ifdef CHIP_PROBE
+
+#ifdef CHIP_FREESTANDING
+#error "chip-probe.h prints through WASI libc, build CHIP_PROBE chips without CHIP_FREESTANDING"
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+// POSIX time.h (native builds with -pthread, WASI libc) has a timer_t of
+// its own; keep it out of the way of the wokwi-api.h one
+#define timer_t chip_probe_libc_timer_t
+#include <time.h>
+#undef timer_t
+
+#include "chip-thread.h"
+
+// Callback registrations the trampolines can track, later ones are passed
+// through uncounted
+#ifndef CHIP_PROBE_SLOTS
+#define CHIP_PROBE_SLOTS 32
+#endif
+
+// Period of the automatic summary, 0 for on demand only
+#ifndef CHIP_PROBE_DUMP_US
+#define CHIP_PROBE_DUMP_US 0
+#endif
+
+#define CHIP_PROBE_BUCKETS 32   // bucket i: durations below 2^i ns, the last one open
+
+#define CHIP_PROBE_CALLS(X) \
+  X(CALLBACK, "callbacks") \
+  X(PIN_INIT, "pinInit") \
+  X(PIN_READ, "pinRead") \
+  X(PIN_WRITE, "pinWrite") \
+  X(PIN_WATCH, "pinWatch") \
+  X(PIN_WATCH_STOP, "pinWatchStop") \
+  X(PIN_MODE, "pinMode") \
+  X(PIN_ADC_READ, "pinADCRead") \
+  X(PIN_DAC_WRITE, "pinDACWrite") \
+  X(STRING_GET_LENGTH, "stringGetLength") \
+  X(STRING_READ, "stringRead") \
+  X(ATTR_INIT, "attrInit") \
+  X(ATTR_INIT_FLOAT, "attrInitFloat") \
+  X(ATTR_READ, "attrRead") \
+  X(ATTR_READ_FLOAT, "attrReadFloat") \
+  X(ATTR_STRING_INIT, "attrStringInit") \
+  X(I2C_INIT, "i2cInit") \
+  X(UART_INIT, "uartInit") \
+  X(UART_WRITE, "uartWrite") \
+  X(SPI_INIT, "spiInit") \
+  X(SPI_START, "spiStart") \
+  X(SPI_STOP, "spiStop") \
+  X(TIMER_INIT, "timerInit") \
+  X(TIMER_START, "timerStart") \
+  X(TIMER_START_NS, "timerStartNanos") \
+  X(TIMER_STOP, "timerStop") \
+  X(GET_SIM_NANOS, "getSimNanos") \
+  X(FRAMEBUFFER_INIT, "framebufferInit") \
+  X(BUFFER_READ, "bufferRead") \
+  X(BUFFER_WRITE, "bufferWrite") \
+  X(PRINTF, "printf") \
+  X(PUTS, "puts") \
+  X(FWRITE, "fwrite") \
+  X(FFLUSH, "fflush")
+
+#define CHIP_PROBE_ID(id, name) CHIP_PROBE_##id,
+enum { CHIP_PROBE_CALLS(CHIP_PROBE_ID) CHIP_PROBE_COUNT };
+#undef CHIP_PROBE_ID
+
+typedef struct {
+  uint64_t calls;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t buckets[CHIP_PROBE_BUCKETS];
+} chip_probe_stat_t;
+
+// A registration's config as the chip passed it, the trampoline's user_data
+typedef union {
+  timer_config_t timer;
+  pin_watch_config_t watch;
+  i2c_config_t i2c;
+  uart_config_t uart;
+  spi_config_t spi;
+} chip_probe_slot_t;
+
+typedef struct {
+  chip_probe_stat_t stats[CHIP_PROBE_COUNT];
+  chip_probe_slot_t slots[CHIP_PROBE_SLOTS];
+  uint32_t slots_used;
+  uint32_t unwrapped;                   // registrations past CHIP_PROBE_SLOTS
+  bool dump_armed;
+} chip_probe_t;
+
+static CHIP_THREAD_LOCAL chip_probe_t chip_probe;
+
+static const char *const chip_probe_names[] = {
+#define CHIP_PROBE_NAME(id, name) name,
+  CHIP_PROBE_CALLS(CHIP_PROBE_NAME)
+#undef CHIP_PROBE_NAME
+};
+
+#ifndef CHIP_PROBE_CLOCK_NS
+static inline uint64_t chip_probe_clock_ns(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#define CHIP_PROBE_CLOCK_NS() chip_probe_clock_ns()
+#endif
+
+#ifdef __wasm__
+#define CHIP_PROBE_EXPORT __attribute__((export_name("chipProbeDump")))
+#else
+#define CHIP_PROBE_EXPORT
+#endif
+
+CHIP_PROBE_EXPORT void chip_probe_dump(void);
+
+static void chip_probe_dump_callback(void *user_data) {
+  (void)user_data;
+  chip_probe_dump();
+}
+
+static inline uint64_t chip_probe_begin(void) {
+  if (CHIP_PROBE_DUMP_US && !chip_probe.dump_armed) {
+    const timer_config_t config = {.callback = chip_probe_dump_callback, .user_data = NULL};
+    chip_probe.dump_armed = true;
+    timer_start(timer_init(&config), CHIP_PROBE_DUMP_US, true);
+  }
+  return CHIP_PROBE_CLOCK_NS();
+}
+
+static inline void chip_probe_end(uint32_t id, uint64_t start_ns) {
+  uint64_t ns = CHIP_PROBE_CLOCK_NS() - start_ns;
+  chip_probe_stat_t *stat = &chip_probe.stats[id];
+  uint32_t bucket = ns ? 64u - (uint32_t)__builtin_clzll(ns) : 0;
+  stat->calls++;
+  stat->total_ns += ns;
+  stat->max_ns = ns > stat->max_ns ? ns : stat->max_ns;
+  stat->buckets[bucket < CHIP_PROBE_BUCKETS ? bucket : CHIP_PROBE_BUCKETS - 1]++;
+}
+
+// Time one import call: value-returning and void forms
+#define CHIP_PROBE_RETURN(id, type, call) \
+  uint64_t chip_probe_start = chip_probe_begin(); \
+  type chip_probe_result = call; \
+  chip_probe_end(CHIP_PROBE_##id, chip_probe_start); \
+  return chip_probe_result
+#define CHIP_PROBE_VOID(id, call) \
+  uint64_t chip_probe_start = chip_probe_begin(); \
+  call; \
+  chip_probe_end(CHIP_PROBE_##id, chip_probe_start)
+
+static inline chip_probe_slot_t *chip_probe_slot(void) {
+  if (chip_probe.slots_used == CHIP_PROBE_SLOTS) {
+    chip_probe.unwrapped++;
+    return NULL;
+  }
+  return &chip_probe.slots[chip_probe.slots_used++];
+}
+
+// Trampolines: user_data is the slot holding the chip's own config
+
+static void chip_probe_timer_callback(void *user_data) {
+  const timer_config_t *config = user_data;
+  CHIP_PROBE_VOID(CALLBACK, config->callback(config->user_data));
+}
+
+static void chip_probe_pin_change(void *user_data, pin_t pin, uint32_t value) {
+  const pin_watch_config_t *config = user_data;
+  CHIP_PROBE_VOID(CALLBACK, config->pin_change(config->user_data, pin, value));
+}
+
+static bool chip_probe_i2c_connect(void *user_data, uint32_t address, bool read) {
+  const i2c_config_t *config = user_data;
+  CHIP_PROBE_RETURN(CALLBACK, bool, config->connect(config->user_data, address, read));
+}
+
+static uint8_t chip_probe_i2c_read(void *user_data) {
+  const i2c_config_t *config = user_data;
+  CHIP_PROBE_RETURN(CALLBACK, uint8_t, config->read(config->user_data));
+}
+
+static bool chip_probe_i2c_write(void *user_data, uint8_t data) {
+  const i2c_config_t *config = user_data;
+  CHIP_PROBE_RETURN(CALLBACK, bool, config->write(config->user_data, data));
+}
+
+static void chip_probe_i2c_disconnect(void *user_data) {
+  const i2c_config_t *config = user_data;
+  CHIP_PROBE_VOID(CALLBACK, config->disconnect(config->user_data));
+}
+
+static void chip_probe_uart_rx(void *user_data, uint8_t byte) {
+  const uart_config_t *config = user_data;
+  CHIP_PROBE_VOID(CALLBACK, config->rx_data(config->user_data, byte));
+}
+
+static void chip_probe_uart_write_done(void *user_data) {
+  const uart_config_t *config = user_data;
+  CHIP_PROBE_VOID(CALLBACK, config->write_done(config->user_data));
+}
+
+static void chip_probe_spi_done(void *user_data, uint8_t *buffer, uint32_t count) {
+  const spi_config_t *config = user_data;
+  CHIP_PROBE_VOID(CALLBACK, config->done(config->user_data, buffer, count));
+}
+
+// Wrappers, one per import
+
+static inline pin_t chip_probe_pin_init(const char *name, uint32_t mode) {
+  CHIP_PROBE_RETURN(PIN_INIT, pin_t, pin_init(name, mode));
+}
+
+static inline uint32_t chip_probe_pin_read(pin_t pin) {
+  CHIP_PROBE_RETURN(PIN_READ, uint32_t, pin_read(pin));
+}
+
+static inline void chip_probe_pin_write(pin_t pin, uint32_t value) {
+  CHIP_PROBE_VOID(PIN_WRITE, pin_write(pin, value));
+}
+
+static inline bool chip_probe_pin_watch(pin_t pin, const pin_watch_config_t *config) {
+  chip_probe_slot_t *slot = config->pin_change ? chip_probe_slot() : NULL;
+  pin_watch_config_t wrapped = *config;
+  if (slot) {
+    slot->watch = *config;
+    wrapped.user_data = slot;
+    wrapped.pin_change = chip_probe_pin_change;
+  }
+  CHIP_PROBE_RETURN(PIN_WATCH, bool, pin_watch(pin, &wrapped));
+}
+
+static inline void chip_probe_pin_watch_stop(pin_t pin) {
+  CHIP_PROBE_VOID(PIN_WATCH_STOP, pin_watch_stop(pin));
+}
+
+static inline void chip_probe_pin_mode(pin_t pin, uint32_t value) {
+  CHIP_PROBE_VOID(PIN_MODE, pin_mode(pin, value));
+}
+
+static inline float chip_probe_pin_adc_read(pin_t pin) {
+  CHIP_PROBE_RETURN(PIN_ADC_READ, float, pin_adc_read(pin));
+}
+
+static inline float chip_probe_pin_dac_write(pin_t pin, float voltage) {
+  CHIP_PROBE_RETURN(PIN_DAC_WRITE, float, pin_dac_write(pin, voltage));
+}
+
+static inline uint32_t chip_probe_string_get_length(string_t string) {
+  CHIP_PROBE_RETURN(STRING_GET_LENGTH, uint32_t, string_get_length(string));
+}
+
+static inline uint32_t chip_probe_string_read(string_t string, char *buf, uint32_t buffer_size) {
+  CHIP_PROBE_RETURN(STRING_READ, uint32_t, string_read(string, buf, buffer_size));
+}
+
+static inline uint32_t chip_probe_attr_init(const char *name, uint32_t default_value) {
+  CHIP_PROBE_RETURN(ATTR_INIT, uint32_t, attr_init(name, default_value));
+}
+
+static inline uint32_t chip_probe_attr_init_float(const char *name, float default_value) {
+  CHIP_PROBE_RETURN(ATTR_INIT_FLOAT, uint32_t, attr_init_float(name, default_value));
+}
+
+static inline uint32_t chip_probe_attr_read(uint32_t attr_id) {
+  CHIP_PROBE_RETURN(ATTR_READ, uint32_t, attr_read(attr_id));
+}
+
+static inline float chip_probe_attr_read_float(uint32_t attr_id) {
+  CHIP_PROBE_RETURN(ATTR_READ_FLOAT, float, attr_read_float(attr_id));
+}
+
+static inline string_t chip_probe_attr_string_init(const char *name) {
+  CHIP_PROBE_RETURN(ATTR_STRING_INIT, string_t, attr_string_init(name));
+}
+
+static inline i2c_dev_t chip_probe_i2c_init(const i2c_config_t *config) {
+  chip_probe_slot_t *slot = chip_probe_slot();
+  i2c_config_t wrapped = *config;
+  if (slot) {
+    slot->i2c = *config;
+    wrapped.user_data = slot;
+    wrapped.connect = config->connect ? chip_probe_i2c_connect : NULL;
+    wrapped.read = config->read ? chip_probe_i2c_read : NULL;
+    wrapped.write = config->write ? chip_probe_i2c_write : NULL;
+    wrapped.disconnect = config->disconnect ? chip_probe_i2c_disconnect : NULL;
+  }
+  CHIP_PROBE_RETURN(I2C_INIT, i2c_dev_t, i2c_init(&wrapped));
+}
+
+static inline uart_dev_t chip_probe_uart_init(const uart_config_t *config) {
+  chip_probe_slot_t *slot = chip_probe_slot();
+  uart_config_t wrapped = *config;
+  if (slot) {
+    slot->uart = *config;
+    wrapped.user_data = slot;
+    wrapped.rx_data = config->rx_data ? chip_probe_uart_rx : NULL;
+    wrapped.write_done = config->write_done ? chip_probe_uart_write_done : NULL;
+  }
+  CHIP_PROBE_RETURN(UART_INIT, uart_dev_t, uart_init(&wrapped));
+}
+
+static inline bool chip_probe_uart_write(uart_dev_t uart, uint8_t *buffer, uint32_t count) {
+  CHIP_PROBE_RETURN(UART_WRITE, bool, uart_write(uart, buffer, count));
+}
+
+static inline spi_dev_t chip_probe_spi_init(const spi_config_t *config) {
+  chip_probe_slot_t *slot = config->done ? chip_probe_slot() : NULL;
+  spi_config_t wrapped = *config;
+  if (slot) {
+    slot->spi = *config;
+    wrapped.user_data = slot;
+    wrapped.done = chip_probe_spi_done;
+  }
+  CHIP_PROBE_RETURN(SPI_INIT, spi_dev_t, spi_init(&wrapped));
+}
+
+static inline void chip_probe_spi_start(const spi_dev_t spi, uint8_t *buffer, uint32_t count) {
+  CHIP_PROBE_VOID(SPI_START, spi_start(spi, buffer, count));
+}
+
+static inline void chip_probe_spi_stop(const spi_dev_t spi) {
+  CHIP_PROBE_VOID(SPI_STOP, spi_stop(spi));
+}
+
+static inline timer_t chip_probe_timer_init(const timer_config_t *config) {
+  chip_probe_slot_t *slot = chip_probe_slot();
+  timer_config_t wrapped = *config;
+  if (slot) {
+    slot->timer = *config;
+    wrapped.user_data = slot;
+    wrapped.callback = chip_probe_timer_callback;
+  }
+  CHIP_PROBE_RETURN(TIMER_INIT, timer_t, timer_init(&wrapped));
+}
+
+static inline void chip_probe_timer_start(const timer_t timer, uint32_t micros, bool repeat) {
+  CHIP_PROBE_VOID(TIMER_START, timer_start(timer, micros, repeat));
+}
+
+static inline void chip_probe_timer_start_ns(const timer_t timer, uint64_t nanos, bool repeat) {
+  CHIP_PROBE_VOID(TIMER_START_NS, timer_start_ns(timer, nanos, repeat));
+}
+
+static inline void chip_probe_timer_start_ns_d(const timer_t timer, double nanos, bool repeat) {
+  CHIP_PROBE_VOID(TIMER_START_NS, timer_start_ns_d(timer, nanos, repeat));
+}
+
+static inline void chip_probe_timer_stop(const timer_t timer) {
+  CHIP_PROBE_VOID(TIMER_STOP, timer_stop(timer));
+}
+
+static inline uint64_t chip_probe_get_sim_nanos(void) {
+  CHIP_PROBE_RETURN(GET_SIM_NANOS, uint64_t, get_sim_nanos());
+}
+
+static inline double chip_probe_get_sim_nanos_d(void) {
+  CHIP_PROBE_RETURN(GET_SIM_NANOS, double, get_sim_nanos_d());
+}
+
+static inline buffer_t chip_probe_framebuffer_init(uint32_t *pixel_width, uint32_t *pixel_height) {
+  CHIP_PROBE_RETURN(FRAMEBUFFER_INIT, buffer_t, framebuffer_init(pixel_width, pixel_height));
+}
+
+static inline void chip_probe_buffer_read(buffer_t buffer, uint32_t offset, void *data, uint32_t data_len) {
+  CHIP_PROBE_VOID(BUFFER_READ, buffer_read(buffer, offset, data, data_len));
+}
+
+static inline void chip_probe_buffer_write(buffer_t buffer, uint32_t offset, void *data, uint32_t data_len) {
+  CHIP_PROBE_VOID(BUFFER_WRITE, buffer_write(buffer, offset, data, data_len));
+}
+
+static inline int chip_probe_printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  uint64_t chip_probe_start = chip_probe_begin();
+  int result = vprintf(format, args);
+  chip_probe_end(CHIP_PROBE_PRINTF, chip_probe_start);
+  va_end(args);
+  return result;
+}
+
+static inline int chip_probe_puts(const char *text) {
+  CHIP_PROBE_RETURN(PUTS, int, puts(text));
+}
+
+static inline size_t chip_probe_fwrite(const void *data, size_t size, size_t count, FILE *stream) {
+  CHIP_PROBE_RETURN(FWRITE, size_t, fwrite(data, size, count, stream));
+}
+
+static inline int chip_probe_fflush(FILE *stream) {
+  CHIP_PROBE_RETURN(FFLUSH, int, fflush(stream));
+}
+
+// Smallest bucket bound at or above the given share of the calls
+static uint64_t chip_probe_percentile_ns(const chip_probe_stat_t *stat, uint32_t percent) {
+  uint64_t wanted = (stat->calls * percent + 99) / 100, seen = 0;
+  for (uint32_t i = 0; i < CHIP_PROBE_BUCKETS; i++) {
+    seen += stat->buckets[i];
+    if (seen >= wanted) {
+      return i ? 1ull << i : 1;
+    }
+  }
+  return stat->max_ns;
+}
+
+// Summary of every import called so far: calls per callback, mean and max
+// duration, and the p50/p99 bucket bounds
+CHIP_PROBE_EXPORT void chip_probe_dump(void) {
+  const chip_probe_stat_t *callbacks = &chip_probe.stats[CHIP_PROBE_CALLBACK];
+  printf("probe: %llu callbacks, %llu us in chip code, %u callbacks unwrapped\n",
+         (unsigned long long)callbacks->calls, (unsigned long long)(callbacks->total_ns / 1000u),
+         chip_probe.unwrapped);
+  printf("probe: %-16s %10s %9s %9s %9s %9s %10s\n", "call", "calls", "per_cb", "mean_ns", "p50_ns",
+         "p99_ns", "max_ns");
+  for (uint32_t i = 0; i < CHIP_PROBE_COUNT; i++) {
+    const chip_probe_stat_t *stat = &chip_probe.stats[i];
+    if (!stat->calls) {
+      continue;
+    }
+    printf("probe: %-16s %10llu %9.2f %9llu %9llu %9llu %10llu\n", chip_probe_names[i],
+           (unsigned long long)stat->calls,
+           callbacks->calls ? (double)stat->calls / (double)callbacks->calls : 0.0,
+           (unsigned long long)(stat->total_ns / stat->calls),
+           (unsigned long long)chip_probe_percentile_ns(stat, 50),
+           (unsigned long long)chip_probe_percentile_ns(stat, 99), (unsigned long long)stat->max_ns);
+  }
+  fflush(stdout);
+}
+
+// Clear the counts and forget the registrations (native host resets only)
+static inline void chip_probe_reset(void) {
+  chip_probe = (chip_probe_t){0};
+}
+
+#define pin_init chip_probe_pin_init
+#define pin_read chip_probe_pin_read
+#define pin_write chip_probe_pin_write
+#define pin_watch chip_probe_pin_watch
+#define pin_watch_stop chip_probe_pin_watch_stop
+#define pin_mode chip_probe_pin_mode
+#define pin_adc_read chip_probe_pin_adc_read
+#define pin_dac_write chip_probe_pin_dac_write
+#define string_get_length chip_probe_string_get_length
+#define string_read chip_probe_string_read
+#define attr_init chip_probe_attr_init
+#define attr_init_float chip_probe_attr_init_float
+#define attr_read chip_probe_attr_read
+#define attr_read_float chip_probe_attr_read_float
+#define attr_string_init chip_probe_attr_string_init
+#define i2c_init chip_probe_i2c_init
+#define uart_init chip_probe_uart_init
+#define uart_write chip_probe_uart_write
+#define spi_init chip_probe_spi_init
+#define spi_start chip_probe_spi_start
+#define spi_stop chip_probe_spi_stop
+#define timer_init chip_probe_timer_init
+#define timer_start chip_probe_timer_start
+#define timer_start_ns chip_probe_timer_start_ns
+#define timer_start_ns_d chip_probe_timer_start_ns_d
+#define timer_stop chip_probe_timer_stop
+#define get_sim_nanos chip_probe_get_sim_nanos
+#define get_sim_nanos_d chip_probe_get_sim_nanos_d
+#define framebuffer_init chip_probe_framebuffer_init
+#define buffer_read chip_probe_buffer_read
+#define buffer_write chip_probe_buffer_write
+#define printf chip_probe_printf
+#define puts chip_probe_puts
+#define fwrite chip_probe_fwrite
+#define fflush chip_probe_fflush
+
+#else
+
+#define chip_probe_dump() ((void)0)
+#define chip_probe_reset() ((void)0)
+
+#endif /* CHIP_PROBE */
+
+#endif /* CHIP_PROBE_H */
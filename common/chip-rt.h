@@ -0,0 +1,349 @@
+/*
+ * Minimal runtime for Wokwi custom chips
+ *
+ * What a chip would otherwise take from WASI libc: text output, a small
+ * integer/float formatter with a printf-style debug print, and the few math
+ * functions the chips need. Built with -DCHIP_FREESTANDING (the Makefile's
+ * default for WASM, with -nostdlib) it also defines memcpy, memmove, memset
+ * and memcmp, which the compiler may call for struct copies and clears, and
+ * writes output straight through the WASI fd_write import. The module then
+ * imports nothing but wokwi-api.h calls and that one fd_write. Native builds
+ * write through stdio instead.
+ *
+ * The math is the same in every build, so native runs of a chip compute
+ * exactly what its WASM build does.
+ *
+ *   chip_rt_debug("field %d uT, %.3f mT\n", field_ut, field_ut / 1000.0);
+ *
+ * chip_rt_debug supports %d %i %u %x %c %s %f (%.Nf, N up to 9) and %%,
+ * with l/ll for long and long long arguments. Include once per chip.
+ */
+
+#ifndef CHIP_RT_H
+#define CHIP_RT_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CHIP_FREESTANDING
+#include <stdio.h>
+#endif
+
+// Output
+
+#ifdef CHIP_FREESTANDING
+
+typedef struct {
+  const void *data;
+  uint32_t length;
+} chip_rt_ciovec_t;
+
+extern __attribute__((import_module("wasi_snapshot_preview1"), import_name("fd_write")))
+int32_t chip_rt_fd_write(int32_t fd, const chip_rt_ciovec_t *iovs, uint32_t iovs_len, uint32_t *written);
+
+// Text to stdout, where the simulator shows chip output
+static inline void chip_rt_write(const char *data, uint32_t length) {
+  while (length) {
+    chip_rt_ciovec_t iov = {data, length};
+    uint32_t written = 0;
+    if (chip_rt_fd_write(1, &iov, 1, &written) != 0 || written == 0) {
+      return;
+    }
+    data += written;
+    length -= written;
+  }
+}
+
+// Nothing is buffered
+static inline void chip_rt_flush(void) {}
+
+#define CHIP_RT_NO_BUILTIN(name) __attribute__((used, no_builtin(name)))
+
+// The compiler may emit calls to these for struct copies and clears; no_builtin
+// keeps it from turning the loops back into calls to themselves
+CHIP_RT_NO_BUILTIN("memcpy") void *memcpy(void *restrict dst, const void *restrict src, size_t size) {
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  while (size--) {
+    *d++ = *s++;
+  }
+  return dst;
+}
+
+CHIP_RT_NO_BUILTIN("memmove") void *memmove(void *dst, const void *src, size_t size) {
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  if (d < s) {
+    while (size--) {
+      *d++ = *s++;
+    }
+  } else {
+    while (size--) {
+      d[size] = s[size];
+    }
+  }
+  return dst;
+}
+
+CHIP_RT_NO_BUILTIN("memset") void *memset(void *dst, int value, size_t size) {
+  unsigned char *d = dst;
+  while (size--) {
+    *d++ = (unsigned char)value;
+  }
+  return dst;
+}
+
+CHIP_RT_NO_BUILTIN("memcmp") int memcmp(const void *a, const void *b, size_t size) {
+  const unsigned char *x = a, *y = b;
+  for (; size; size--, x++, y++) {
+    if (*x != *y) {
+      return *x - *y;
+    }
+  }
+  return 0;
+}
+
+#else
+
+static inline void chip_rt_write(const char *data, uint32_t length) {
+  fwrite(data, 1, length, stdout);
+}
+
+static inline void chip_rt_flush(void) {
+  fflush(stdout);
+}
+
+#endif
+
+// Formatting. Each writes at most the noted number of characters to out, no
+// terminator, and returns how many it wrote.
+
+// Decimal, zero-padded to at least min_digits (at most 20 characters)
+static inline uint32_t chip_rt_format_u64(char *out, uint64_t value, uint32_t min_digits) {
+  char digits[20];
+  uint32_t count = 0;
+  do {
+    digits[count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value || (count < min_digits && count < sizeof(digits)));
+  for (uint32_t i = 0; i < count; i++) {
+    out[i] = digits[count - 1 - i];
+  }
+  return count;
+}
+
+// Signed decimal (at most 20 characters)
+static inline uint32_t chip_rt_format_i64(char *out, int64_t value) {
+  if (value < 0) {
+    out[0] = '-';
+    return 1 + chip_rt_format_u64(out + 1, 0u - (uint64_t)value, 1);
+  }
+  return chip_rt_format_u64(out, (uint64_t)value, 1);
+}
+
+// Lower-case hexadecimal (at most 16 characters)
+static inline uint32_t chip_rt_format_hex(char *out, uint64_t value) {
+  char digits[16];
+  uint32_t count = 0;
+  do {
+    digits[count++] = "0123456789abcdef"[value & 15];
+    value >>= 4;
+  } while (value);
+  for (uint32_t i = 0; i < count; i++) {
+    out[i] = digits[count - 1 - i];
+  }
+  return count;
+}
+
+// Fixed point with decimals (0-9) digits after the point, rounded half away
+// from zero; magnitudes from 1e18 print as d.ddde+NN (at most 32 characters)
+static inline uint32_t chip_rt_format_double(char *out, double value, uint32_t decimals) {
+  static const uint32_t scale[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+  uint32_t length = 0;
+  if (value != value) {
+    out[0] = 'n', out[1] = 'a', out[2] = 'n';
+    return 3;
+  }
+  if (value < 0) {
+    out[length++] = '-';
+    value = -value;
+  }
+  if (value > 1.7976931348623157e308) {
+    out[length++] = 'i', out[length++] = 'n', out[length++] = 'f';
+    return length;
+  }
+  decimals = decimals > 9 ? 9 : decimals;
+  uint32_t exponent = 0;
+  bool scientific = value >= 1e18;
+  while (value >= 10.0 && scientific) {
+    value /= 10.0;
+    exponent++;
+  }
+
+  uint64_t whole = (uint64_t)value;
+  double fraction = (value - (double)whole) * scale[decimals] + 0.5;
+  uint64_t digits = (uint64_t)fraction;
+  if (digits >= scale[decimals]) {
+    whole++;
+    digits -= scale[decimals];
+  }
+  length += chip_rt_format_u64(out + length, whole, 1);
+  if (decimals) {
+    out[length++] = '.';
+    length += chip_rt_format_u64(out + length, digits, decimals);
+  }
+  if (scientific) {
+    out[length++] = 'e';
+    out[length++] = '+';
+    length += chip_rt_format_u64(out + length, exponent, 2);
+  }
+  return length;
+}
+
+#define CHIP_RT_DEBUG_BUFFER 256
+
+// printf-like print to stdout, see the top of the file for the conversions
+static inline void chip_rt_debug(const char *format, ...) {
+  char buffer[CHIP_RT_DEBUG_BUFFER];
+  uint32_t length = 0;
+  va_list args;
+  va_start(args, format);
+  for (const char *at = format; *at; at++) {
+    // Room for the longest conversion
+    if (length > sizeof(buffer) - 40) {
+      chip_rt_write(buffer, length);
+      length = 0;
+    }
+    if (*at != '%') {
+      buffer[length++] = *at;
+      continue;
+    }
+
+    uint32_t decimals = 6;
+    if (at[1] == '.' && at[2] >= '0' && at[2] <= '9') {
+      decimals = (uint32_t)(at[2] - '0');
+      at += 2;
+    }
+    int longs = 0;
+    while (at[1] == 'l') {
+      longs++;
+      at++;
+    }
+    switch (*++at) {
+    case 'd':
+    case 'i': {
+      int64_t value = longs > 1 ? va_arg(args, long long) : longs ? va_arg(args, long) : va_arg(args, int);
+      length += chip_rt_format_i64(buffer + length, value);
+      break;
+    }
+    case 'u':
+    case 'x': {
+      uint64_t value = longs > 1   ? va_arg(args, unsigned long long)
+                       : longs     ? va_arg(args, unsigned long)
+                                   : va_arg(args, unsigned int);
+      length += *at == 'u' ? chip_rt_format_u64(buffer + length, value, 1) : chip_rt_format_hex(buffer + length, value);
+      break;
+    }
+    case 'f':
+      length += chip_rt_format_double(buffer + length, va_arg(args, double), decimals);
+      break;
+    case 'c':
+      buffer[length++] = (char)va_arg(args, int);
+      break;
+    case 's': {
+      const char *text = va_arg(args, const char *);
+      while (text && *text) {
+        if (length == sizeof(buffer)) {
+          chip_rt_write(buffer, length);
+          length = 0;
+        }
+        buffer[length++] = *text++;
+      }
+      break;
+    }
+    case '\0':
+      at--;
+      break;
+    default:
+      buffer[length++] = *at;
+      break;
+    }
+  }
+  va_end(args);
+  chip_rt_write(buffer, length);
+  chip_rt_flush();
+}
+
+// Math, accurate to a few units in the last place
+
+// value limited to [low, high], NaN to low (like fminf(fmaxf(value, low), high))
+static inline float chip_rt_clampf(float value, float low, float high) {
+  return value > low ? (value < high ? value : high) : low;
+}
+
+// f64.sqrt in WASM
+static inline double chip_rt_sqrt(double value) {
+  return __builtin_sqrt(value);
+}
+
+// Round half away from zero, |value| below 2^62
+static inline int64_t chip_rt_llround(double value) {
+  int64_t whole = (int64_t)value;
+  double rest = value - (double)whole;
+  if (rest >= 0.5) {
+    whole++;
+  } else if (rest <= -0.5) {
+    whole--;
+  }
+  return whole;
+}
+
+// Cube root: exponent divided by three for the first guess, then Newton
+static inline double chip_rt_cbrt(double value) {
+  if (value == 0 || value != value || value - value != 0) {
+    return value;
+  }
+  double x = value < 0 ? -value : value;
+  union {
+    double d;
+    uint64_t u;
+  } bits = {x};
+  bits.u = bits.u / 3 + ((uint64_t)0x3ff0000000000000ull / 3) * 2;
+  double y = bits.d;
+  for (int i = 0; i < 6; i++) {
+    y -= (y * y * y - x) / (3.0 * y * y);
+  }
+  return value < 0 ? -y : y;
+}
+
+// atan for 0 <= value <= 1, series around 0 after a pi/6 shift
+static inline double chip_rt_atan01(double value) {
+  const double tan_pi_12 = 0.2679491924311227;
+  const double sqrt3 = 1.7320508075688772;
+  double base = 0;
+  if (value > tan_pi_12) {
+    base = 0.5235987755982988;  // pi/6
+    value = (sqrt3 * value - 1.0) / (sqrt3 + value);
+  }
+  double z2 = value * value;
+  double sum = 0;
+  for (int n = 31; n >= 3; n -= 2) {
+    sum = z2 * ((n & 2 ? -1.0 : 1.0) / n + sum);
+  }
+  return base + value * (1.0 + sum);
+}
+
+// acos for -1 <= value <= 1, as 2 * atan(sqrt((1 - value) / (1 + value)))
+static inline double chip_rt_acos(double value) {
+  if (!(value >= -1.0 && value <= 1.0)) {
+    return __builtin_nan("");
+  }
+  double a = chip_rt_sqrt(1.0 - value);
+  double b = chip_rt_sqrt(1.0 + value);
+  const double half_pi = 1.5707963267948966;
+  return 2.0 * (a > b ? half_pi - chip_rt_atan01(b / a) : chip_rt_atan01(a / b));
+}
+
+#endif /* CHIP_RT_H */
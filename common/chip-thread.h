@@ -0,0 +1,20 @@
+/*
+ * Storage class for chip globals
+ *
+ * A chip keeps its state in file-scope variables: the simulator loads one
+ * WASM module per chip, so there is exactly one copy. Native host builds
+ * that run simulations on several threads at once (host/wokwi-shard.h)
+ * define CHIP_THREAD_LOCAL as _Thread_local to give each thread a copy of
+ * its own. Everywhere else it expands to nothing.
+ *
+ *   static CHIP_THREAD_LOCAL chip_state_t pool[4];
+ */
+
+#ifndef CHIP_THREAD_H
+#define CHIP_THREAD_H
+
+#ifndef CHIP_THREAD_LOCAL
+#define CHIP_THREAD_LOCAL
+#endif
+
+#endif /* CHIP_THREAD_H */
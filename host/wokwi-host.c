@@ -0,0 +1,1446 @@
+/*
+ * Native host stand-in for the Wokwi Chips API
+ *
+ * Everything that happens at a simulated time, chip timers, UART write
+ * completions and events scheduled by the driving program alike, is a timer
+ * in one event queue ordered by (deadline, arm sequence). Callbacks that
+ * fall on the same nanosecond run in the order they were armed, like they do
+ * in the simulator, so a run is fully deterministic.
+ *
+ * The queue is a binary min-heap by default, or a hierarchical timing wheel
+ * for runs with many armed timers (host_set_scheduler). Both deliver exactly
+ * the same sequence.
+ *
+ * All host state is thread-local: every thread that uses the host runs a
+ * simulation of its own (see wokwi-shard.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wokwi-host.h"
+
+// wokwi-api.h declares its own timer_t, which clashes with the POSIX one
+// pulled in by the libc headers above
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#undef timer_t
+
+#define HOST_MAX_ATTRS 16
+#define HOST_MAX_PINS 16
+
+typedef struct {
+  const char *name;
+  double value;      // integer and float attributes alike, like the simulator
+  const char *text;  // string attributes, NULL until set
+  uint64_t set_at;
+  bool pending;      // set by the host, not yet read by the chip
+} host_attr_t;
+
+typedef struct {
+  const char *name;
+  uint32_t mode;
+  uint32_t value;
+  uint64_t edges;
+  float voltage;     // pinADCRead/pinDACWrite
+  pin_watch_config_t watch;
+  bool watching;
+  bool set;          // driven by host_pin_set() since the chip last set its mode
+} host_pin_t;
+
+// One simulated chip. Attribute and pin handles are indexes into the
+// instance that created them, like they are per module in the simulator.
+typedef struct {
+  host_attr_t attrs[HOST_MAX_ATTRS];
+  uint32_t attr_count;
+  host_pin_t pins[HOST_MAX_PINS];
+  uint32_t pin_count;
+} host_instance_t;
+
+typedef struct {
+  timer_config_t config;
+  uint64_t deadline;
+  uint64_t period;
+  uint64_t seq;
+  uint32_t instance;
+  bool repeat;
+  bool event;        // host-side event rather than a chip timer
+  bool armed;
+  uint16_t wheel_slot;  // level * WHEEL_SLOTS + slot
+  uint32_t heap_index;
+  uint32_t next;     // wheel slot list links
+  uint32_t prev;
+  uint32_t quiet;    // callbacks in a row without an effect, since quiet_epoch
+  uint64_t quiet_epoch;
+  uint64_t skip_until;  // strict fast-forward: callbacks before this are checked
+} host_timer_t;
+
+typedef struct {
+  i2c_config_t config;
+  uint32_t instance;
+} host_i2c_t;
+
+typedef struct {
+  uart_config_t config;
+  uint32_t instance;
+  bool busy;         // write in flight, uartWrite refuses more
+  uint8_t *output;   // everything the chip has written
+  uint32_t output_length;
+  uint32_t output_capacity;
+} host_uart_t;
+
+typedef struct {
+  spi_config_t config;
+  uint32_t instance;
+  bool active;       // between spiStart and the end of the transfer
+  uint8_t *buffer;
+  uint32_t count;
+  uint32_t position;
+} host_spi_t;
+
+typedef struct {
+  uint8_t *data;
+  uint32_t size;
+} host_buffer_t;
+
+static _Thread_local host_instance_t *instances;
+static _Thread_local uint32_t instance_count;
+static _Thread_local uint32_t instance_capacity;
+static _Thread_local host_instance_t *current;
+
+// Timer handles are global, both queues hold timer handles
+static _Thread_local host_timer_t *timers;
+static _Thread_local uint32_t timer_count;
+static _Thread_local uint32_t timer_capacity;
+static _Thread_local uint64_t arm_seq;
+static _Thread_local host_scheduler_t scheduler = HOST_SCHEDULER_HEAP;
+static _Thread_local host_scheduler_t next_scheduler = HOST_SCHEDULER_HEAP;
+
+static _Thread_local uint32_t *heap;
+static _Thread_local uint32_t heap_size;
+
+// Timing wheel: WHEEL_LEVELS levels of WHEEL_SLOTS slots, level l slots
+// WHEEL_SLOTS^l ns wide, covering the whole 64-bit nanosecond range. A timer
+// sits at the level of the highest byte in which its deadline differs from
+// wheel_now, so everything at level 0 is due within the current 256 ns
+// window. Level 0 slots hold a single deadline each and are kept in arm
+// order; higher slots are cascaded down when wheel_now reaches them.
+#define WHEEL_LEVELS 8
+#define WHEEL_BITS 8
+#define WHEEL_SLOTS (1u << WHEEL_BITS)
+#define NO_TIMER UINT32_MAX
+
+typedef struct {
+  uint32_t head;
+  uint32_t tail;
+} wheel_list_t;
+
+static _Thread_local wheel_list_t wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static _Thread_local uint64_t wheel_occupied[WHEEL_LEVELS][WHEEL_SLOTS / 64];
+static _Thread_local uint32_t wheel_armed[WHEEL_LEVELS];
+static _Thread_local uint64_t wheel_now;      // never past the earliest armed deadline
+static _Thread_local uint64_t wheel_horizon;  // nothing armed is due before this
+
+// Idle fast-forward. A repeating chip timer is quiet once its last
+// ff_quiet_callbacks callbacks, all since the latest stimulus (input from the
+// driving program or a chip callback with an effect), made no import call
+// with an effect. When every armed repeating chip timer is quiet, nothing
+// observable can happen before the next host event or one-shot chip timer,
+// so their callbacks up to it are skipped (or, in strict mode, run and
+// checked).
+static _Thread_local uint32_t ff_quiet_callbacks;   // 0 when off
+static _Thread_local bool ff_strict;
+static _Thread_local uint64_t ff_until;       // no fast-forward needed before this
+static _Thread_local host_fast_forward_t ff_stats;
+static _Thread_local uint32_t *ff_batch;
+static _Thread_local uint32_t ff_batch_capacity;
+static _Thread_local uint64_t effects;        // imports that change pins, timers, buses...
+static _Thread_local uint64_t stimuli;        // inputs from the driving program
+static _Thread_local uint32_t chip_armed;     // armed chip timers
+static _Thread_local uint32_t quiet_armed;    // armed quiet repeating chip timers
+static _Thread_local uint32_t one_shot_armed; // armed one-shot chip timers
+
+// Finished host events, reused before growing the timer table
+static _Thread_local uint32_t *free_events;
+static _Thread_local uint32_t free_event_count;
+static _Thread_local uint32_t free_event_capacity;
+
+// Peripheral devices and buffers, handles are indexes in init order
+static _Thread_local host_i2c_t *i2c_devices;
+static _Thread_local uint32_t i2c_count;
+static _Thread_local uint32_t i2c_capacity;
+static _Thread_local host_uart_t *uart_devices;
+static _Thread_local uint32_t uart_count;
+static _Thread_local uint32_t uart_capacity;
+static _Thread_local host_spi_t *spi_devices;
+static _Thread_local uint32_t spi_count;
+static _Thread_local uint32_t spi_capacity;
+static _Thread_local host_buffer_t *buffers;
+static _Thread_local uint32_t buffer_count;
+static _Thread_local uint32_t buffer_capacity;
+static _Thread_local uint32_t framebuffer_width = 128;
+static _Thread_local uint32_t framebuffer_height = 64;
+
+// string_t handles are 1-based indexes, 0 is STRING_NULL
+static _Thread_local char **strings;
+static _Thread_local uint32_t string_count;
+static _Thread_local uint32_t string_capacity;
+
+static _Thread_local host_pin_listener_t pin_listener;
+static _Thread_local host_pin_mode_listener_t pin_mode_listener;
+static _Thread_local host_input_listener_t input_listener;
+
+static _Thread_local uint64_t now_ns;
+static _Thread_local host_counters_t counters;
+static _Thread_local host_latency_t latency;
+
+// Chips with instance pools define this to release them on host_reset()
+extern void chip_host_reset(void) __attribute__((weak));
+
+// wokwi-vcd.c, when linked in, dumps the inputs the driving program sets
+extern void host_vcd_pin_set(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns)
+    __attribute__((weak));
+
+static void host_fatal(const char *what, const char *name) {
+  fprintf(stderr, "wokwi-host: %s%s%s\n", what, name ? ": " : "", name ? name : "");
+  exit(1);
+}
+
+// Timer heap
+
+static bool timer_before(uint32_t a, uint32_t b) {
+  if (timers[a].deadline != timers[b].deadline) {
+    return timers[a].deadline < timers[b].deadline;
+  }
+  return timers[a].seq < timers[b].seq;
+}
+
+static void heap_place(uint32_t index, uint32_t timer) {
+  heap[index] = timer;
+  timers[timer].heap_index = (int)index;
+}
+
+static void heap_sift_up(uint32_t index) {
+  uint32_t timer = heap[index];
+  while (index > 0) {
+    uint32_t parent = (index - 1) / 2;
+    if (!timer_before(timer, heap[parent])) {
+      break;
+    }
+    heap_place(index, heap[parent]);
+    index = parent;
+  }
+  heap_place(index, timer);
+}
+
+static void heap_sift_down(uint32_t index) {
+  uint32_t timer = heap[index];
+  for (;;) {
+    uint32_t child = index * 2 + 1;
+    if (child >= heap_size) {
+      break;
+    }
+    if (child + 1 < heap_size && timer_before(heap[child + 1], heap[child])) {
+      child++;
+    }
+    if (!timer_before(heap[child], timer)) {
+      break;
+    }
+    heap_place(index, heap[child]);
+    index = child;
+  }
+  heap_place(index, timer);
+}
+
+static void heap_push(uint32_t timer) {
+  heap_size++;
+  heap_place(heap_size - 1, timer);
+  heap_sift_up(heap_size - 1);
+}
+
+static void heap_remove(uint32_t timer) {
+  uint32_t index = timers[timer].heap_index;
+  heap_size--;
+  if (index == heap_size) {
+    return;
+  }
+  heap_place(index, heap[heap_size]);
+  heap_sift_down(index);
+  heap_sift_up(timers[heap[index]].heap_index);
+}
+
+// Timing wheel
+
+static int wheel_find(uint32_t level, uint32_t from) {
+  for (uint32_t word = from / 64; word < WHEEL_SLOTS / 64; word++) {
+    uint64_t bits = wheel_occupied[level][word];
+    if (word == from / 64) {
+      bits &= ~0ull << (from % 64);
+    }
+    if (bits) {
+      return (int)(word * 64 + (uint32_t)__builtin_ctzll(bits));
+    }
+  }
+  return -1;
+}
+
+static void wheel_insert(uint32_t timer) {
+  host_timer_t *t = &timers[timer];
+  uint64_t differ = t->deadline ^ wheel_now;
+  uint32_t level = differ ? (63 - (uint32_t)__builtin_clzll(differ)) / WHEEL_BITS : 0;
+  uint32_t slot = (uint32_t)(t->deadline >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+  wheel_list_t *list = &wheel[level][slot];
+  t->wheel_slot = (uint16_t)(level * WHEEL_SLOTS + slot);
+  if (t->deadline < wheel_horizon) {
+    wheel_horizon = t->deadline;
+  }
+
+  // Append, except that level 0 stays in arm order for cascaded timers
+  uint32_t after = list->tail;
+  if (level == 0) {
+    while (after != NO_TIMER && timers[after].seq > t->seq) {
+      after = timers[after].prev;
+    }
+  }
+  t->prev = after;
+  t->next = after == NO_TIMER ? list->head : timers[after].next;
+  if (after == NO_TIMER) {
+    list->head = timer;
+  } else {
+    timers[after].next = timer;
+  }
+  if (t->next == NO_TIMER) {
+    list->tail = timer;
+  } else {
+    timers[t->next].prev = timer;
+  }
+  wheel_occupied[level][slot / 64] |= 1ull << (slot % 64);
+  wheel_armed[level]++;
+}
+
+static void wheel_remove(uint32_t timer) {
+  host_timer_t *t = &timers[timer];
+  uint32_t level = t->wheel_slot / WHEEL_SLOTS;
+  uint32_t slot = t->wheel_slot % WHEEL_SLOTS;
+  wheel_list_t *list = &wheel[level][slot];
+  if (t->prev == NO_TIMER) {
+    list->head = t->next;
+  } else {
+    timers[t->prev].next = t->next;
+  }
+  if (t->next == NO_TIMER) {
+    list->tail = t->prev;
+  } else {
+    timers[t->next].prev = t->prev;
+  }
+  if (list->head == NO_TIMER) {
+    wheel_occupied[level][slot / 64] &= ~(1ull << (slot % 64));
+  }
+  wheel_armed[level]--;
+}
+
+// Earliest timer if it is due by limit, NO_TIMER otherwise. Cascades higher
+// slots down on the way, never moving wheel_now past limit.
+static uint32_t wheel_next(uint64_t limit) {
+  if (limit < wheel_horizon) {
+    return NO_TIMER;
+  }
+  for (;;) {
+    int slot = wheel_find(0, (uint32_t)(wheel_now & (WHEEL_SLOTS - 1)));
+    if (slot >= 0) {
+      uint64_t deadline = (wheel_now & ~(uint64_t)(WHEEL_SLOTS - 1)) | (uint32_t)slot;
+      if (deadline > limit) {
+        wheel_horizon = deadline;
+        return NO_TIMER;
+      }
+      return wheel[0][slot].head;
+    }
+
+    uint32_t level;
+    for (level = 1; level < WHEEL_LEVELS; level++) {
+      if (wheel_armed[level] == 0) {
+        continue;
+      }
+      uint32_t position = (uint32_t)(wheel_now >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+      if (position + 1 < WHEEL_SLOTS && (slot = wheel_find(level, position + 1)) >= 0) {
+        break;
+      }
+    }
+    if (level == WHEEL_LEVELS) {
+      wheel_horizon = UINT64_MAX;
+      return NO_TIMER;
+    }
+
+    // Nothing is due before that slot, so the wheel can move up to its
+    // earliest deadline (but not past limit, later arms may come before it)
+    // and spread the slot's timers over the levels below
+    uint32_t shift = level * WHEEL_BITS;
+    uint64_t below = shift + WHEEL_BITS < 64 ? (1ull << (shift + WHEEL_BITS)) - 1 : ~0ull;
+    uint64_t start = (wheel_now & ~below) | ((uint64_t)slot << shift);
+    if (start > limit) {
+      wheel_horizon = start;
+      return NO_TIMER;
+    }
+    wheel_list_t *list = &wheel[level][slot];
+    wheel_now = limit;
+    for (uint32_t timer = list->head; timer != NO_TIMER; timer = timers[timer].next) {
+      if (timers[timer].deadline < wheel_now) {
+        wheel_now = timers[timer].deadline;
+      }
+    }
+    uint32_t timer = list->head;
+    list->head = list->tail = NO_TIMER;
+    wheel_occupied[level][slot / 64] &= ~(1ull << (slot % 64));
+    while (timer != NO_TIMER) {
+      uint32_t next = timers[timer].next;
+      wheel_armed[level]--;
+      wheel_insert(timer);
+      timer = next;
+    }
+  }
+}
+
+// Event queue, on whichever structure this run uses
+
+static bool timer_quiet(const host_timer_t *t) {
+  return ff_quiet_callbacks && t->repeat && !t->event &&
+         t->quiet >= ff_quiet_callbacks && t->quiet_epoch == stimuli;
+}
+
+// Input from the driving program: every chip timer has to prove quiet again
+static void stimulus(void) {
+  stimuli++;
+  quiet_armed = 0;
+}
+
+static void queue_insert(uint32_t timer) {
+  timers[timer].seq = arm_seq++;
+  timers[timer].armed = true;
+  chip_armed += !timers[timer].event;
+  one_shot_armed += !timers[timer].event && !timers[timer].repeat;
+  quiet_armed += timer_quiet(&timers[timer]);
+  if (scheduler == HOST_SCHEDULER_WHEEL) {
+    wheel_insert(timer);
+  } else {
+    heap_push(timer);
+  }
+}
+
+static void queue_remove(uint32_t timer) {
+  timers[timer].armed = false;
+  chip_armed -= !timers[timer].event;
+  one_shot_armed -= !timers[timer].event && !timers[timer].repeat;
+  quiet_armed -= timer_quiet(&timers[timer]);
+  if (scheduler == HOST_SCHEDULER_WHEEL) {
+    wheel_remove(timer);
+  } else {
+    heap_remove(timer);
+  }
+}
+
+static uint32_t queue_next(uint64_t limit) {
+  if (scheduler == HOST_SCHEDULER_WHEEL) {
+    return wheel_next(limit);
+  }
+  return heap_size > 0 && timers[heap[0]].deadline <= limit ? heap[0] : NO_TIMER;
+}
+
+static void queue_clear(void) {
+  heap_size = 0;
+  for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+    for (uint32_t slot = 0; slot < WHEEL_SLOTS; slot++) {
+      wheel[level][slot].head = wheel[level][slot].tail = NO_TIMER;
+    }
+  }
+  memset(wheel_occupied, 0, sizeof(wheel_occupied));
+  memset(wheel_armed, 0, sizeof(wheel_armed));
+  wheel_now = 0;
+  wheel_horizon = UINT64_MAX;
+}
+
+static void *grow(void *array, uint32_t *capacity, size_t element_size) {
+  *capacity = *capacity ? *capacity * 2 : 64;
+  array = realloc(array, *capacity * element_size);
+  if (!array) {
+    host_fatal("out of memory", NULL);
+  }
+  return array;
+}
+
+// Lookup helpers, all relative to the current instance
+
+static host_attr_t *find_attr(const char *name) {
+  for (uint32_t i = 0; i < current->attr_count; i++) {
+    if (strcmp(current->attrs[i].name, name) == 0) {
+      return &current->attrs[i];
+    }
+  }
+  return NULL;
+}
+
+static host_attr_t *add_attr(const char *name, double value) {
+  if (current->attr_count == HOST_MAX_ATTRS) {
+    host_fatal("too many attributes", name);
+  }
+  host_attr_t *attr = &current->attrs[current->attr_count++];
+  attr->name = name;
+  attr->value = value;
+  attr->text = NULL;
+  attr->pending = false;
+  return attr;
+}
+
+static host_pin_t *find_pin(const char *name) {
+  for (uint32_t i = 0; i < current->pin_count; i++) {
+    if (strcmp(current->pins[i].name, name) == 0) {
+      return &current->pins[i];
+    }
+  }
+  host_fatal("unknown pin", name);
+  return NULL;
+}
+
+static host_pin_t *pin_handle(pin_t pin) {
+  if (pin < 0 || (uint32_t)pin >= current->pin_count) {
+    host_fatal("invalid pin handle", NULL);
+  }
+  return &current->pins[pin];
+}
+
+static host_timer_t *timer_handle(wokwi_timer_t timer) {
+  if (timer >= timer_count) {
+    host_fatal("invalid timer handle", NULL);
+  }
+  return &timers[timer];
+}
+
+// Imports declared in wokwi-api.h
+
+pin_t pin_init(const char *name, uint32_t mode) {
+  counters.pin_init++;
+  effects++;
+  if (current->pin_count == HOST_MAX_PINS) {
+    host_fatal("too many pins", name);
+  }
+  host_pin_t *pin = &current->pins[current->pin_count];
+  pin->name = name;
+  pin->mode = mode;
+  pin->value = (mode == OUTPUT_HIGH || mode == INPUT_PULLUP) ? HIGH : LOW;
+  pin->edges = 0;
+  pin->voltage = 0;
+  pin->watching = false;
+  pin->set = false;
+  return (pin_t)current->pin_count++;
+}
+
+uint32_t pin_read(pin_t pin) {
+  counters.pin_read++;
+  return pin_handle(pin)->value;
+}
+
+static void drive_pin(host_pin_t *p, uint32_t value) {
+  if (p->value != value) {
+    effects++;
+    p->value = value;
+    p->edges++;
+    if (pin_listener) {
+      pin_listener((uint32_t)(current - instances), p->name, value, now_ns);
+    }
+  }
+}
+
+void pin_write(pin_t pin, uint32_t value) {
+  counters.pin_write++;
+  drive_pin(pin_handle(pin), value);
+}
+
+bool pin_watch(pin_t pin, const pin_watch_config_t *config) {
+  counters.pin_watch++;
+  effects++;
+  host_pin_t *p = pin_handle(pin);
+  if (p->watching) {
+    return false;
+  }
+  p->watch = *config;
+  p->watching = true;
+  return true;
+}
+
+void pin_watch_stop(pin_t pin) {
+  counters.pin_watch++;
+  effects++;
+  pin_handle(pin)->watching = false;
+}
+
+float pin_adc_read(pin_t pin) {
+  counters.analog++;
+  return pin_handle(pin)->voltage;
+}
+
+float pin_dac_write(pin_t pin, float voltage) {
+  counters.analog++;
+  effects++;
+  pin_handle(pin)->voltage = voltage;
+  return voltage;
+}
+
+void pin_mode(pin_t pin, uint32_t mode) {
+  counters.pin_mode++;
+  host_pin_t *p = pin_handle(pin);
+  bool changed = p->mode != mode;
+  effects += changed;
+  p->mode = mode;
+  p->set = p->set && !changed;
+  if (mode == OUTPUT_LOW || mode == OUTPUT_HIGH) {
+    drive_pin(p, mode == OUTPUT_HIGH ? HIGH : LOW);
+  }
+  if (changed && pin_mode_listener) {
+    pin_mode_listener((uint32_t)(current - instances), p->name, mode, p->value, now_ns);
+  }
+}
+
+static string_t add_string(const char *text) {
+  if (string_count == string_capacity) {
+    strings = grow(strings, &string_capacity, sizeof(*strings));
+  }
+  size_t length = strlen(text);
+  char *copy = malloc(length + 1);
+  if (!copy) {
+    host_fatal("out of memory", NULL);
+  }
+  memcpy(copy, text, length + 1);
+  strings[string_count++] = copy;
+  return string_count;
+}
+
+static const char *string_handle(string_t string) {
+  if (string == STRING_NULL || string > string_count) {
+    host_fatal("invalid string handle", NULL);
+  }
+  return strings[string - 1];
+}
+
+uint32_t string_get_length(string_t string) {
+  counters.string_read++;
+  return (uint32_t)strlen(string_handle(string));
+}
+
+uint32_t string_read(string_t string, char *buf, uint32_t buffer_size) {
+  counters.string_read++;
+  const char *text = string_handle(string);
+  uint32_t length = (uint32_t)strlen(text);
+  if (buffer_size == 0) {
+    return 0;
+  }
+  if (length > buffer_size - 1) {
+    length = buffer_size - 1;
+  }
+  memcpy(buf, text, length);
+  buf[length] = '\0';
+  return length;
+}
+
+string_t attr_string_init(const char *name) {
+  counters.attr_init++;
+  effects++;
+  host_attr_t *attr = find_attr(name);
+  if (!attr) {
+    attr = add_attr(name, 0);
+  }
+  return add_string(attr->text ? attr->text : "");
+}
+
+uint32_t attr_init(const char *name, uint32_t default_value) {
+  counters.attr_init++;
+  effects++;
+  host_attr_t *attr = find_attr(name);
+  if (!attr) {
+    attr = add_attr(name, default_value);
+  }
+  return (uint32_t)(attr - current->attrs);
+}
+
+static host_attr_t *read_attr(uint32_t attr_id) {
+  counters.attr_read++;
+  if (attr_id >= current->attr_count) {
+    host_fatal("invalid attribute handle", NULL);
+  }
+  host_attr_t *attr = &current->attrs[attr_id];
+  if (attr->pending) {
+    uint64_t delay = now_ns - attr->set_at;
+    latency.samples++;
+    latency.total_ns += delay;
+    if (delay > latency.worst_ns) {
+      latency.worst_ns = delay;
+    }
+    attr->pending = false;
+  }
+  return attr;
+}
+
+uint32_t attr_read(uint32_t attr_id) {
+  return (uint32_t)read_attr(attr_id)->value;
+}
+
+uint32_t attr_init_float(const char *name, float default_value) {
+  counters.attr_init++;
+  effects++;
+  host_attr_t *attr = find_attr(name);
+  if (!attr) {
+    attr = add_attr(name, default_value);
+  }
+  return (uint32_t)(attr - current->attrs);
+}
+
+float attr_read_float(uint32_t attr_id) {
+  return (float)read_attr(attr_id)->value;
+}
+
+static uint32_t add_timer(const timer_config_t *config, bool event) {
+  uint32_t index;
+  if (event && free_event_count) {
+    index = free_events[--free_event_count];
+  } else {
+    if (timer_count == timer_capacity) {
+      uint32_t heap_capacity = timer_capacity;
+      timers = grow(timers, &timer_capacity, sizeof(*timers));
+      heap = grow(heap, &heap_capacity, sizeof(*heap));
+    }
+    index = timer_count++;
+  }
+  host_timer_t *timer = &timers[index];
+  timer->config = *config;
+  timer->instance = (uint32_t)(current - instances);
+  timer->event = event;
+  timer->armed = false;
+  timer->quiet = 0;
+  timer->skip_until = 0;
+  return index;
+}
+
+wokwi_timer_t timer_init(const timer_config_t *config) {
+  counters.timer_init++;
+  effects++;
+  return add_timer(config, false);
+}
+
+static void arm_timer(wokwi_timer_t timer, uint64_t nanos, bool repeat) {
+  host_timer_t *t = timer_handle(timer);
+  effects++;
+  if (t->armed) {
+    queue_remove(timer);
+  }
+  t->quiet = 0;
+  t->deadline = now_ns + nanos;
+  t->period = nanos;
+  t->repeat = repeat && nanos > 0;
+  queue_insert(timer);
+}
+
+void timer_start(const wokwi_timer_t timer, uint32_t micros, bool repeat) {
+  counters.timer_start++;
+  arm_timer(timer, (uint64_t)micros * 1000u, repeat);
+}
+
+void timer_start_ns_d(const wokwi_timer_t timer, double nanos, bool repeat) {
+  counters.timer_start++;
+  arm_timer(timer, nanos > 0 ? (uint64_t)nanos : 0, repeat);
+}
+
+void timer_stop(const wokwi_timer_t timer) {
+  counters.timer_stop++;
+  effects++;
+  host_timer_t *t = timer_handle(timer);
+  if (t->armed) {
+    queue_remove(timer);
+  }
+}
+
+double get_sim_nanos_d(void) {
+  counters.get_sim_nanos++;
+  return (double)now_ns;
+}
+
+// One-shot host event in the event queue, runs in the current instance
+static void schedule_event(uint64_t sim_ns, void (*callback)(void *arg), void *arg) {
+  const timer_config_t config = {
+    .callback = callback,
+    .user_data = arg,
+  };
+  uint32_t timer = add_timer(&config, true);
+  timers[timer].deadline = sim_ns > now_ns ? sim_ns : now_ns;
+  timers[timer].period = 0;
+  timers[timer].repeat = false;
+  queue_insert(timer);
+}
+
+// Peripherals. The driving program plays the other end of each bus through
+// the host_i2c_*, host_uart_* and host_spi_* calls.
+
+i2c_dev_t i2c_init(const i2c_config_t *config) {
+  counters.bus++;
+  effects++;
+  if (i2c_count == i2c_capacity) {
+    i2c_devices = grow(i2c_devices, &i2c_capacity, sizeof(*i2c_devices));
+  }
+  i2c_devices[i2c_count].config = *config;
+  i2c_devices[i2c_count].instance = (uint32_t)(current - instances);
+  return i2c_count++;
+}
+
+uart_dev_t uart_init(const uart_config_t *config) {
+  counters.bus++;
+  effects++;
+  if (uart_count == uart_capacity) {
+    uart_devices = grow(uart_devices, &uart_capacity, sizeof(*uart_devices));
+  }
+  host_uart_t *uart = &uart_devices[uart_count];
+  memset(uart, 0, sizeof(*uart));
+  uart->config = *config;
+  uart->instance = (uint32_t)(current - instances);
+  return uart_count++;
+}
+
+static host_uart_t *uart_handle(uart_dev_t uart) {
+  if (uart >= uart_count) {
+    host_fatal("invalid UART handle", NULL);
+  }
+  return &uart_devices[uart];
+}
+
+static void uart_write_done(void *arg) {
+  host_uart_t *uart = &uart_devices[(uintptr_t)arg];
+  uart->busy = false;
+  if (uart->config.write_done) {
+    counters.callbacks++;
+    uart->config.write_done(uart->config.user_data);
+  }
+}
+
+// Bytes go out 10 bits each (8N1); writeDone fires when the last one has
+bool uart_write(uart_dev_t uart, uint8_t *buffer, uint32_t count) {
+  counters.bus++;
+  effects++;
+  host_uart_t *u = uart_handle(uart);
+  if (u->busy) {
+    return false;
+  }
+  while (u->output_length + count > u->output_capacity) {
+    u->output = grow(u->output, &u->output_capacity, 1);
+  }
+  memcpy(u->output + u->output_length, buffer, count);
+  u->output_length += count;
+  u->busy = true;
+  uint64_t nanos = u->config.baud_rate ? (uint64_t)count * 10u * 1000000000ull / u->config.baud_rate : 0;
+  schedule_event(now_ns + nanos, uart_write_done, (void *)(uintptr_t)uart);
+  return true;
+}
+
+spi_dev_t spi_init(const spi_config_t *config) {
+  counters.bus++;
+  effects++;
+  if (spi_count == spi_capacity) {
+    spi_devices = grow(spi_devices, &spi_capacity, sizeof(*spi_devices));
+  }
+  host_spi_t *spi = &spi_devices[spi_count];
+  memset(spi, 0, sizeof(*spi));
+  spi->config = *config;
+  spi->instance = (uint32_t)(current - instances);
+  return spi_count++;
+}
+
+static host_spi_t *spi_handle(spi_dev_t spi) {
+  if (spi >= spi_count) {
+    host_fatal("invalid SPI handle", NULL);
+  }
+  return &spi_devices[spi];
+}
+
+void spi_start(const spi_dev_t spi, uint8_t *buffer, uint32_t count) {
+  counters.bus++;
+  effects++;
+  host_spi_t *s = spi_handle(spi);
+  s->active = count > 0;
+  s->buffer = buffer;
+  s->count = count;
+  s->position = 0;
+}
+
+void spi_stop(const spi_dev_t spi) {
+  counters.bus++;
+  effects++;
+  spi_handle(spi)->active = false;
+}
+
+// Buffers: framebuffers are RGBA, 4 bytes per pixel
+
+static host_buffer_t *buffer_handle(buffer_t buffer, uint32_t offset, uint32_t length) {
+  if (buffer >= buffer_count) {
+    host_fatal("invalid buffer handle", NULL);
+  }
+  host_buffer_t *b = &buffers[buffer];
+  if (offset > b->size || length > b->size - offset) {
+    host_fatal("buffer access out of range", NULL);
+  }
+  return b;
+}
+
+buffer_t framebuffer_init(uint32_t *pixel_width, uint32_t *pixel_height) {
+  counters.buffer++;
+  effects++;
+  if (buffer_count == buffer_capacity) {
+    buffers = grow(buffers, &buffer_capacity, sizeof(*buffers));
+  }
+  host_buffer_t *b = &buffers[buffer_count];
+  b->size = framebuffer_width * framebuffer_height * 4;
+  b->data = calloc(b->size ? b->size : 1, 1);
+  if (!b->data) {
+    host_fatal("out of memory", NULL);
+  }
+  *pixel_width = framebuffer_width;
+  *pixel_height = framebuffer_height;
+  return buffer_count++;
+}
+
+void buffer_read(buffer_t buffer, uint32_t offset, void *data, uint32_t data_len) {
+  counters.buffer++;
+  memcpy(data, buffer_handle(buffer, offset, data_len)->data + offset, data_len);
+}
+
+void buffer_write(buffer_t buffer, uint32_t offset, void *data, uint32_t data_len) {
+  counters.buffer++;
+  effects++;
+  memcpy(buffer_handle(buffer, offset, data_len)->data + offset, data, data_len);
+}
+
+// Experimental MCU introspection. There is no MCU next to a native host:
+// symbols do not resolve and memory reads as zero.
+
+void *_symbol_resolve(char *symbol_name) {
+  (void)symbol_name;
+  counters.mcu++;
+  return NULL;
+}
+
+bool _mcu_read_memory(const void *address, void *target, uint32_t size) {
+  (void)address;
+  counters.mcu++;
+  memset(target, 0, size);
+  return false;
+}
+
+uint32_t _mcu_read_uint32(const void *address) {
+  (void)address;
+  counters.mcu++;
+  return 0;
+}
+
+void *_mcu_read_ptr(const void *address) {
+  (void)address;
+  counters.mcu++;
+  return NULL;
+}
+
+uint32_t _mcu_read_pc(void) {
+  counters.mcu++;
+  return 0;
+}
+
+uint32_t _mcu_read_sp(void) {
+  counters.mcu++;
+  return 0;
+}
+
+uint32_t _mcu_monitor_sp(const sp_monitor_config_t *config) {
+  (void)config;
+  counters.mcu++;
+  effects++;
+  return 0;
+}
+
+// Host control surface
+
+void host_set_fast_forward(uint32_t quiet_callbacks, bool strict) {
+  ff_quiet_callbacks = quiet_callbacks;
+  ff_strict = strict;
+  ff_until = now_ns;
+  stimulus();
+}
+
+const host_fast_forward_t *host_fast_forward_stats(void) {
+  return &ff_stats;
+}
+
+void host_set_scheduler(host_scheduler_t queue) {
+  next_scheduler = queue;
+}
+
+void host_reset(void) {
+  if (chip_host_reset) {
+    chip_host_reset();
+  }
+  for (uint32_t i = 0; i < string_count; i++) {
+    free(strings[i]);
+  }
+  string_count = 0;
+  for (uint32_t i = 0; i < uart_count; i++) {
+    free(uart_devices[i].output);
+  }
+  for (uint32_t i = 0; i < buffer_count; i++) {
+    free(buffers[i].data);
+  }
+  i2c_count = uart_count = spi_count = buffer_count = 0;
+  instance_count = 0;
+  host_instance_new();
+  timer_count = 0;
+  free_event_count = 0;
+  scheduler = next_scheduler;
+  queue_clear();
+  chip_armed = quiet_armed = one_shot_armed = 0;
+  arm_seq = 0;
+  now_ns = 0;
+  ff_until = 0;
+  memset(&ff_stats, 0, sizeof(ff_stats));
+  memset(&counters, 0, sizeof(counters));
+  memset(&latency, 0, sizeof(latency));
+}
+
+void host_release(void) {
+  host_reset();
+  free(instances);
+  free(timers);
+  free(heap);
+  free(ff_batch);
+  free(free_events);
+  free(i2c_devices);
+  free(uart_devices);
+  free(spi_devices);
+  free(buffers);
+  free(strings);
+  instances = current = NULL;
+  timers = NULL;
+  heap = ff_batch = free_events = NULL;
+  i2c_devices = NULL;
+  uart_devices = NULL;
+  spi_devices = NULL;
+  buffers = NULL;
+  strings = NULL;
+  instance_count = instance_capacity = timer_capacity = ff_batch_capacity = free_event_capacity = 0;
+  i2c_capacity = uart_capacity = spi_capacity = buffer_capacity = string_capacity = 0;
+}
+
+uint32_t host_instance_new(void) {
+  if (instance_count == instance_capacity) {
+    instances = grow(instances, &instance_capacity, sizeof(*instances));
+  }
+  current = &instances[instance_count];
+  current->attr_count = 0;
+  current->pin_count = 0;
+  return instance_count++;
+}
+
+void host_instance_select(uint32_t instance) {
+  if (instance >= instance_count) {
+    host_fatal("invalid instance", NULL);
+  }
+  current = &instances[instance];
+}
+
+uint32_t host_instance_count(void) {
+  return instance_count;
+}
+
+size_t host_instance_bytes(void) {
+  return sizeof(host_instance_t);
+}
+
+void *host_timer_user_data(uint32_t timer) {
+  return timer < timer_count ? timers[timer].config.user_data : NULL;
+}
+
+void host_attr_set(const char *name, uint32_t value) {
+  host_attr_set_float(name, value);
+}
+
+void host_attr_set_float(const char *name, double value) {
+  host_attr_t *attr = find_attr(name);
+  if (input_listener && (!attr || attr->value != value)) {
+    input_listener((uint32_t)(current - instances), name, false, value, now_ns);
+  }
+  if (!attr) {
+    attr = add_attr(name, value);
+  }
+  if (attr->value != value) {
+    stimulus();
+    attr->value = value;
+    if (!attr->pending) {
+      attr->pending = true;
+      attr->set_at = now_ns;
+    }
+  }
+}
+
+void host_attr_set_string(const char *name, const char *text) {
+  host_attr_t *attr = find_attr(name);
+  if (!attr) {
+    attr = add_attr(name, 0);
+  }
+  stimulus();
+  attr->text = text;
+}
+
+void host_set_pin_listener(host_pin_listener_t listener) {
+  pin_listener = listener;
+}
+
+void host_set_pin_mode_listener(host_pin_mode_listener_t listener) {
+  pin_mode_listener = listener;
+}
+
+void host_set_input_listener(host_input_listener_t listener) {
+  input_listener = listener;
+}
+
+uint32_t host_pin_get(const char *name) {
+  return find_pin(name)->value;
+}
+
+uint32_t host_pin_mode(const char *name) {
+  return find_pin(name)->mode;
+}
+
+bool host_pin_floating(const char *name) {
+  const host_pin_t *p = find_pin(name);
+  return p->mode == INPUT && !p->set;
+}
+
+uint32_t host_pin_count(void) {
+  return current->pin_count;
+}
+
+const char *host_pin_name(uint32_t pin) {
+  return pin < current->pin_count ? current->pins[pin].name : NULL;
+}
+
+void host_pin_set(const char *name, uint32_t value) {
+  host_pin_t *p = find_pin(name);
+  bool was_floating = p->mode == INPUT && !p->set;
+  p->set = true;
+  if (p->value == value && !was_floating) {
+    return;
+  }
+  if (host_vcd_pin_set) {
+    host_vcd_pin_set((uint32_t)(current - instances), p->name, value, now_ns);
+  }
+  if (p->value == value) {
+    return;
+  }
+  stimulus();
+  if (input_listener) {
+    input_listener((uint32_t)(current - instances), name, true, value, now_ns);
+  }
+  p->value = value;
+  p->edges++;
+  uint32_t edge = value ? RISING : FALLING;
+  if (p->watching && (p->watch.edge & edge)) {
+    counters.callbacks++;
+    p->watch.pin_change(p->watch.user_data, (pin_t)(p - current->pins), value);
+  }
+}
+
+uint64_t host_pin_edges(const char *name) {
+  return find_pin(name)->edges;
+}
+
+void host_pin_set_voltage(const char *name, float voltage) {
+  stimulus();
+  find_pin(name)->voltage = voltage;
+}
+
+float host_pin_voltage(const char *name) {
+  return find_pin(name)->voltage;
+}
+
+void host_schedule(uint64_t sim_ns, host_event_t event, void *arg) {
+  schedule_event(sim_ns, event, arg);
+}
+
+// Bus devices call back into the instance that created them; the selected
+// instance is restored afterwards
+
+static host_i2c_t *i2c_handle(uint32_t device) {
+  if (device >= i2c_count) {
+    host_fatal("invalid I2C handle", NULL);
+  }
+  return &i2c_devices[device];
+}
+
+bool host_i2c_connect(uint32_t device, uint32_t address, bool read) {
+  stimulus();
+  host_i2c_t *i2c = i2c_handle(device);
+  if (i2c->config.address && i2c->config.address != address) {
+    return false;
+  }
+  if (!i2c->config.connect) {
+    return true;
+  }
+  host_instance_t *selected = current;
+  current = &instances[i2c->instance];
+  counters.callbacks++;
+  bool ack = i2c->config.connect(i2c->config.user_data, address, read);
+  current = selected;
+  return ack;
+}
+
+uint8_t host_i2c_read(uint32_t device) {
+  stimulus();
+  host_i2c_t *i2c = i2c_handle(device);
+  if (!i2c->config.read) {
+    return 0xff;
+  }
+  host_instance_t *selected = current;
+  current = &instances[i2c->instance];
+  counters.callbacks++;
+  uint8_t data = i2c->config.read(i2c->config.user_data);
+  current = selected;
+  return data;
+}
+
+bool host_i2c_write(uint32_t device, uint8_t data) {
+  stimulus();
+  host_i2c_t *i2c = i2c_handle(device);
+  if (!i2c->config.write) {
+    return false;
+  }
+  host_instance_t *selected = current;
+  current = &instances[i2c->instance];
+  counters.callbacks++;
+  bool ack = i2c->config.write(i2c->config.user_data, data);
+  current = selected;
+  return ack;
+}
+
+void host_i2c_disconnect(uint32_t device) {
+  stimulus();
+  host_i2c_t *i2c = i2c_handle(device);
+  if (i2c->config.disconnect) {
+    host_instance_t *selected = current;
+    current = &instances[i2c->instance];
+    counters.callbacks++;
+    i2c->config.disconnect(i2c->config.user_data);
+    current = selected;
+  }
+}
+
+void host_uart_send(uint32_t device, const uint8_t *data, uint32_t count) {
+  stimulus();
+  host_uart_t *uart = uart_handle(device);
+  host_instance_t *selected = current;
+  current = &instances[uart->instance];
+  for (uint32_t i = 0; i < count && uart->config.rx_data; i++) {
+    counters.callbacks++;
+    uart->config.rx_data(uart->config.user_data, data[i]);
+  }
+  current = selected;
+}
+
+const uint8_t *host_uart_output(uint32_t device, uint32_t *length) {
+  host_uart_t *uart = uart_handle(device);
+  *length = uart->output_length;
+  return uart->output;
+}
+
+uint32_t host_spi_transfer(uint32_t device, const uint8_t *mosi, uint8_t *miso, uint32_t count) {
+  stimulus();
+  host_spi_t *spi = spi_handle(device);
+  host_instance_t *selected = current;
+  current = &instances[spi->instance];
+  uint32_t done = 0;
+  // The done callback may start the next transfer, which then continues
+  while (done < count && spi->active) {
+    if (miso) {
+      miso[done] = spi->buffer[spi->position];
+    }
+    spi->buffer[spi->position++] = mosi ? mosi[done] : 0xff;
+    done++;
+    if (spi->position == spi->count) {
+      spi->active = false;
+      if (spi->config.done) {
+        counters.callbacks++;
+        spi->config.done(spi->config.user_data, spi->buffer, spi->count);
+      }
+    }
+  }
+  current = selected;
+  return done;
+}
+
+void host_framebuffer_size(uint32_t width, uint32_t height) {
+  framebuffer_width = width;
+  framebuffer_height = height;
+}
+
+uint8_t *host_buffer_data(uint32_t buffer, uint32_t *size) {
+  host_buffer_t *b = buffer_handle(buffer, 0, 0);
+  *size = b->size;
+  return b->data;
+}
+
+// Fast-forward
+
+static int ff_compare(const void *a, const void *b) {
+  // In the order their last skipped callbacks would have re-armed them
+  const host_timer_t *ta = &timers[*(const uint32_t *)a];
+  const host_timer_t *tb = &timers[*(const uint32_t *)b];
+  uint64_t last_a = ta->deadline - ta->period;
+  uint64_t last_b = tb->deadline - tb->period;
+  if (last_a != last_b) {
+    return last_a < last_b ? -1 : 1;
+  }
+  return ta->seq < tb->seq ? -1 : ta->seq > tb->seq;
+}
+
+// Every armed repeating chip timer is quiet: skip their callbacks up to the
+// next host event, one-shot chip timer or limit. Each timer skips a whole
+// number of quiet windows, so a chip whose idle callbacks cycle through some
+// state (like a counter deciding which attribute to read) ends up where a
+// full run would have left it, as long as the cycle divides the window.
+static void fast_forward(uint64_t limit) {
+  uint64_t until = limit;
+  for (uint32_t i = 0; i < timer_count; i++) {
+    if (timers[i].armed && !timers[i].repeat && timers[i].deadline < until) {
+      until = timers[i].deadline;
+    }
+  }
+  ff_until = until;
+
+  uint32_t count = 0;
+  uint64_t skipped = 0;
+  for (uint32_t i = 0; i < timer_count; i++) {
+    host_timer_t *t = &timers[i];
+    if (!t->armed || t->event || t->deadline >= until) {
+      continue;
+    }
+    uint64_t periods = (until - t->deadline + t->period - 1) / t->period;
+    periods -= periods % ff_quiet_callbacks;
+    if (periods == 0) {
+      continue;
+    }
+    if (count == ff_batch_capacity) {
+      ff_batch = grow(ff_batch, &ff_batch_capacity, sizeof(*ff_batch));
+    }
+    ff_batch[count++] = i;
+    skipped += periods;
+  }
+  if (count == 0) {
+    return;
+  }
+  ff_stats.skips++;
+  ff_stats.skipped_callbacks += skipped;
+  ff_stats.skipped_ns += until - now_ns;
+
+  for (uint32_t i = 0; i < count; i++) {
+    host_timer_t *t = &timers[ff_batch[i]];
+    uint64_t periods = (until - t->deadline + t->period - 1) / t->period;
+    periods -= periods % ff_quiet_callbacks;
+    if (ff_strict) {
+      // Run them anyway, note_callback() checks they stay quiet
+      t->skip_until = t->deadline + periods * t->period;
+      continue;
+    }
+    queue_remove(ff_batch[i]);
+    t->deadline += periods * t->period;
+  }
+  if (ff_strict) {
+    return;
+  }
+  qsort(ff_batch, count, sizeof(*ff_batch), ff_compare);
+  for (uint32_t i = 0; i < count; i++) {
+    queue_insert(ff_batch[i]);
+  }
+}
+
+// After a chip timer callback: count it towards the timer being quiet
+static void note_callback(uint32_t index, bool effect) {
+  host_timer_t *t = &timers[index];
+  if (effect) {
+    if (now_ns < t->skip_until) {
+      host_fatal("fast-forward would have skipped a callback with an effect", NULL);
+    }
+    // Whatever changed may change what the other timers' callbacks do
+    stimulus();
+    t->quiet = 0;
+    t->quiet_epoch = stimuli;
+    return;
+  }
+  bool was_quiet = timer_quiet(t);
+  if (t->quiet_epoch != stimuli) {
+    t->quiet = 1;
+  } else if (t->quiet < UINT32_MAX) {
+    t->quiet++;
+  }
+  t->quiet_epoch = stimuli;
+  if (t->armed) {
+    quiet_armed += timer_quiet(t) - was_quiet;
+  }
+}
+
+void host_run_until(uint64_t sim_ns) {
+  uint32_t index;
+  for (;;) {
+    if (quiet_armed && quiet_armed + one_shot_armed == chip_armed && now_ns >= ff_until) {
+      fast_forward(sim_ns);
+    }
+    if ((index = queue_next(sim_ns)) == NO_TIMER) {
+      break;
+    }
+    host_timer_t *timer = &timers[index];
+    now_ns = timer->deadline;
+    queue_remove(index);
+    if (timer->repeat) {
+      timer->deadline += timer->period;
+      queue_insert(index);
+    }
+    current = &instances[timer->instance];
+    if (timer->event) {
+      // Handed back first, the event may schedule the next one
+      if (free_event_count == free_event_capacity) {
+        free_events = grow(free_events, &free_event_capacity, sizeof(*free_events));
+      }
+      free_events[free_event_count++] = index;
+      stimulus();
+      timer->config.callback(timer->config.user_data);
+    } else {
+      counters.callbacks++;
+      uint64_t effects_before = effects;
+      timer->config.callback(timer->config.user_data);
+      note_callback(index, effects != effects_before);
+    }
+  }
+  if (sim_ns > now_ns) {
+    now_ns = sim_ns;
+  }
+}
+
+void host_run_for(uint64_t nanos) {
+  host_run_until(now_ns + nanos);
+}
+
+uint64_t host_now(void) {
+  return now_ns;
+}
+
+const host_counters_t *host_counters(void) {
+  return &counters;
+}
+
+const host_latency_t *host_latency(void) {
+  return &latency;
+}
+
+uint64_t host_import_calls(const host_counters_t *c) {
+  return c->pin_init + c->pin_read + c->pin_write + c->pin_watch + c->pin_mode + c->analog +
+         c->attr_init + c->attr_read + c->string_read + c->timer_init + c->timer_start + c->timer_stop +
+         c->get_sim_nanos + c->bus + c->buffer + c->mcu;
+}
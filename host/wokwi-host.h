@@ -0,0 +1,220 @@
+/*
+ * Native host stand-in for the Wokwi Chips API
+ *
+ * Chips include wokwi-api.h and expect the simulator to provide its imports.
+ * This library provides all of them for the build machine instead, on top of
+ * a deterministic discrete-event scheduler with a simulated nanosecond clock,
+ * so a chip's chip.c links unchanged into a native program and can be driven
+ * from benchmark or test code, and run under perf or the sanitizers.
+ *
+ * Typical use:
+ *   host_reset();
+ *   host_attr_set("magneticField", 0);   // diagram.json "attrs"
+ *   chip_init();
+ *   host_run_for(HOST_MS(10));
+ *   host_attr_set_float("magneticField", 42.5);  // slider moved, mT
+ *   host_run_for(HOST_MS(10));
+ *   value = host_pin_get("OUT");
+ *
+ * Several chips can be simulated side by side: host_instance_new() starts a
+ * new chip with its own attributes and pins, and the following chip_init()
+ * call binds to it. Attribute and pin accessors act on the selected instance.
+ *
+ * The driving program plays the rest of the circuit: it drives chip inputs
+ * (host_pin_set, host_pin_set_voltage), acts as the I2C controller, the far
+ * end of a UART and the SPI controller, reads framebuffers, and can schedule
+ * its own actions at simulated times (host_schedule). The experimental MCU
+ * imports report that there is no MCU.
+ *
+ * Host state is per thread, settings included, so separate threads can run
+ * separate simulations; wokwi-shard.h spreads them over a thread pool.
+ */
+
+#ifndef WOKWI_HOST_H
+#define WOKWI_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_US(x) ((uint64_t)(x) * 1000ull)
+#define HOST_MS(x) ((uint64_t)(x) * 1000000ull)
+#define HOST_SEC(x) ((uint64_t)(x) * 1000000000ull)
+
+// Number of calls the chip made into each import
+typedef struct {
+  uint64_t pin_init;
+  uint64_t pin_read;
+  uint64_t pin_write;
+  uint64_t pin_watch;        // pinWatch + pinWatchStop
+  uint64_t pin_mode;
+  uint64_t analog;           // pinADCRead + pinDACWrite
+  uint64_t attr_init;
+  uint64_t attr_read;
+  uint64_t string_read;      // stringGetLength + stringRead
+  uint64_t timer_init;
+  uint64_t timer_start;
+  uint64_t timer_stop;
+  uint64_t get_sim_nanos;
+  uint64_t bus;              // I2C/UART/SPI init and transfer calls
+  uint64_t buffer;           // framebufferInit + bufferRead/Write
+  uint64_t mcu;              // experimental _mcu* and _symbolResolve
+  uint64_t callbacks;        // timer, pin watch and bus callbacks delivered to the chip
+} host_counters_t;
+
+// Change-to-detection latency: time from host_attr_set() until the chip
+// next reads that attribute
+typedef struct {
+  uint64_t samples;
+  uint64_t total_ns;
+  uint64_t worst_ns;
+} host_latency_t;
+
+// Reset the simulated clock, counters and all attributes, pins and timers,
+// leaving a single empty instance selected
+void host_reset(void);
+
+// Free everything the host allocated on this thread. host_reset() makes it
+// usable again.
+void host_release(void);
+
+// Event queue used from the next host_reset() on. The heap is cheaper with a
+// few hundred armed timers or less; the wheel arms, re-arms and cancels in
+// O(1) and wins beyond that. Both run timers in the same order.
+typedef enum {
+  HOST_SCHEDULER_HEAP,
+  HOST_SCHEDULER_WHEEL,
+} host_scheduler_t;
+void host_set_scheduler(host_scheduler_t queue);
+
+// Add an empty chip instance and select it, returns its index
+uint32_t host_instance_new(void);
+void host_instance_select(uint32_t instance);
+uint32_t host_instance_count(void);
+
+// Host-side bookkeeping per instance, excluding timers
+size_t host_instance_bytes(void);
+
+// user_data a timer was created with, NULL for an unknown timer handle
+void *host_timer_user_data(uint32_t timer);
+
+// Set an attribute as the simulator UI would. Attributes set before
+// chip_init() act as diagram.json "attrs" and override the default.
+void host_attr_set(const char *name, uint32_t value);
+
+// Set a float attribute (attr_init_float), or an integer one to a
+// fractional value as a diagram could
+void host_attr_set_float(const char *name, double value);
+
+// Set a string attribute (attr_string_init). The text must stay valid until
+// the chip has called attr_string_init() for it.
+void host_attr_set_string(const char *name, const char *text);
+
+// Called on every value change the chip drives on any of its pins, with the
+// instance index
+typedef void (*host_pin_listener_t)(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns);
+void host_set_pin_listener(host_pin_listener_t listener);
+
+// Called when the chip switches one of its pins to another mode (pinMode),
+// with the instance index and the pin's value after the switch. An output
+// switched to INPUT is tri-stated.
+typedef void (*host_pin_mode_listener_t)(uint32_t instance, const char *pin, uint32_t mode, uint32_t value,
+                                         uint64_t sim_ns);
+void host_set_pin_mode_listener(host_pin_mode_listener_t listener);
+
+// Called on every change the driving program makes to a numeric attribute
+// (host_attr_set, host_attr_set_float, the first one included) or an input
+// pin (host_pin_set), with the instance index, before the chip sees it
+typedef void (*host_input_listener_t)(uint32_t instance, const char *name, bool pin, double value, uint64_t sim_ns);
+void host_set_input_listener(host_input_listener_t listener);
+
+// Current value of a pin, and its mode (pinInit/pinMode). An output the
+// chip switched to INPUT is tri-stated.
+uint32_t host_pin_get(const char *name);
+uint32_t host_pin_mode(const char *name);
+
+// True for a pin in INPUT mode that host_pin_set() has not driven since the
+// chip created it or last changed its mode: nothing drives it
+bool host_pin_floating(const char *name);
+
+// Pins the chip created with pinInit, in creation order. host_pin_name()
+// returns the name the chip passed, NULL past the last pin.
+uint32_t host_pin_count(void);
+const char *host_pin_name(uint32_t pin);
+
+// Drive a chip input from the circuit, e.g. switch a supply pin. Delivers
+// the chip's pin_watch callback when the edge matches.
+void host_pin_set(const char *name, uint32_t value);
+
+// Number of value changes seen on a pin since the last reset
+uint64_t host_pin_edges(const char *name);
+
+// Analog level on a pin: what pinADCRead returns, and what pinDACWrite set
+void host_pin_set_voltage(const char *name, float voltage);
+float host_pin_voltage(const char *name);
+
+// Run event(arg) at sim_ns (now, if already past), in the currently selected
+// instance. Ties with chip timers resolve in scheduling order.
+typedef void (*host_event_t)(void *arg);
+void host_schedule(uint64_t sim_ns, host_event_t event, void *arg);
+
+// Bus devices. Handles count from 0 per bus type in init order, across all
+// instances; callbacks run in the instance that created the device.
+
+// I2C controller side: address phase (false when the chip does not
+// respond or NACKs), byte reads and writes, stop
+bool host_i2c_connect(uint32_t device, uint32_t address, bool read);
+uint8_t host_i2c_read(uint32_t device);
+bool host_i2c_write(uint32_t device, uint8_t data);
+void host_i2c_disconnect(uint32_t device);
+
+// UART: bytes sent to the chip arrive through rx_data right away. Bytes the
+// chip writes are kept; writeDone follows 10 bit times per byte later.
+void host_uart_send(uint32_t device, const uint8_t *data, uint32_t count);
+const uint8_t *host_uart_output(uint32_t device, uint32_t *length);
+
+// SPI controller side: clock up to count bytes through the transfer started
+// by spiStart, mosi into the chip's buffer and the buffer out to miso (either
+// may be NULL). Returns the number of bytes exchanged.
+uint32_t host_spi_transfer(uint32_t device, const uint8_t *mosi, uint8_t *miso, uint32_t count);
+
+// Size handed out by the next framebufferInit calls (default 128x64), and
+// a buffer's contents
+void host_framebuffer_size(uint32_t width, uint32_t height);
+uint8_t *host_buffer_data(uint32_t buffer, uint32_t *size);
+
+// Advance simulated time, delivering timer callbacks in order
+void host_run_until(uint64_t sim_ns);
+void host_run_for(uint64_t nanos);
+
+// Idle fast-forward for long, sparse runs. Once every armed chip timer is a
+// repeating one whose last quiet_callbacks callbacks (since the last input
+// from the driving program) made no import call with an effect, i.e. only
+// read pins, attributes and the clock, host_run_until() skips their
+// callbacks up to the next host_schedule() event or the end of the run.
+// One-shot chip timers, like a pending output edge, hold it back. With
+// strict set the callbacks run anyway and the host exits with an error if
+// one of them would have been skipped with an effect. 0 turns it off.
+//
+// Each timer skips a whole multiple of quiet_callbacks callbacks and lands
+// on the time a full run would have reached. The result is exact only for a
+// chip whose idle callback keeps no state of its own, e.g. one that does
+// periodic work by the clock rather than by counting its callbacks; the
+// host cannot check this and strict mode does not catch it.
+typedef struct {
+  uint64_t skips;
+  uint64_t skipped_callbacks;
+  uint64_t skipped_ns;
+} host_fast_forward_t;
+void host_set_fast_forward(uint32_t quiet_callbacks, bool strict);
+const host_fast_forward_t *host_fast_forward_stats(void);
+
+uint64_t host_now(void);
+
+const host_counters_t *host_counters(void);
+const host_latency_t *host_latency(void);
+
+// Total import calls recorded in the counters
+uint64_t host_import_calls(const host_counters_t *counters);
+
+#endif /* WOKWI_HOST_H */
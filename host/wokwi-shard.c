@@ -0,0 +1,141 @@
+/*
+ * Sharded runs on a thread pool, see wokwi-shard.h
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-shard.h"
+
+// Shards [next, end) not yet started by a worker
+typedef struct {
+  pthread_mutex_t lock;
+  uint32_t next;
+  uint32_t end;
+  uint64_t steals;
+} shard_block_t;
+
+typedef struct {
+  shard_block_t *blocks;
+  uint32_t threads;
+  host_shard_fn_t run;
+  void *context;
+} shard_pool_t;
+
+typedef struct {
+  shard_pool_t *pool;
+  uint32_t worker;
+} shard_worker_t;
+
+static bool take(shard_block_t *block, uint32_t *shard) {
+  pthread_mutex_lock(&block->lock);
+  bool found = block->next < block->end;
+  if (found) {
+    *shard = block->next++;
+  }
+  pthread_mutex_unlock(&block->lock);
+  return found;
+}
+
+// Move the upper half of another worker's block into ours
+static bool steal(shard_pool_t *pool, uint32_t worker) {
+  shard_block_t *own = &pool->blocks[worker];
+  for (uint32_t i = 1; i < pool->threads; i++) {
+    shard_block_t *victim = &pool->blocks[(worker + i) % pool->threads];
+    pthread_mutex_lock(&victim->lock);
+    uint32_t left = victim->end - victim->next;
+    uint32_t begin = victim->end - (left + 1) / 2;
+    uint32_t end = victim->end;
+    victim->end = begin;
+    pthread_mutex_unlock(&victim->lock);
+    if (begin < end) {
+      pthread_mutex_lock(&own->lock);
+      own->next = begin;
+      own->end = end;
+      own->steals++;
+      pthread_mutex_unlock(&own->lock);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void *worker_main(void *arg) {
+  shard_worker_t *self = arg;
+  shard_pool_t *pool = self->pool;
+  uint32_t shard;
+  for (;;) {
+    if (!take(&pool->blocks[self->worker], &shard)) {
+      if (!steal(pool, self->worker)) {
+        break;
+      }
+      continue;
+    }
+    // Same starting point for every shard, whatever ran on this thread before
+    host_set_scheduler(HOST_SCHEDULER_HEAP);
+    host_set_fast_forward(0, false);
+    host_set_pin_listener(NULL);
+    host_set_pin_mode_listener(NULL);
+    host_set_input_listener(NULL);
+    host_framebuffer_size(128, 64);
+    host_reset();
+    pool->run(shard, pool->context);
+  }
+  host_release();
+  return NULL;
+}
+
+bool host_shard_run(uint32_t count, uint32_t threads, host_shard_fn_t run, void *context,
+                    host_shard_stats_t *stats) {
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (uint32_t)cpus : 1;
+  }
+  shard_pool_t pool = {
+    .blocks = calloc(threads, sizeof(shard_block_t)),
+    .threads = threads,
+    .run = run,
+    .context = context,
+  };
+  shard_worker_t *workers = calloc(threads, sizeof(shard_worker_t));
+  pthread_t *ids = calloc(threads, sizeof(pthread_t));
+  bool ok = pool.blocks && workers && ids;
+
+  for (uint32_t i = 0; ok && i < threads; i++) {
+    pthread_mutex_init(&pool.blocks[i].lock, NULL);
+    pool.blocks[i].next = (uint32_t)((uint64_t)count * i / threads);
+    pool.blocks[i].end = (uint32_t)((uint64_t)count * (i + 1) / threads);
+  }
+  // Blocks of workers that fail to start are stolen by the others
+  uint32_t started = 0;
+  for (uint32_t i = 0; ok && i < threads; i++) {
+    workers[started].pool = &pool;
+    workers[started].worker = i;
+    if (pthread_create(&ids[started], NULL, worker_main, &workers[started]) == 0) {
+      started++;
+    }
+  }
+  for (uint32_t i = 0; i < started; i++) {
+    pthread_join(ids[i], NULL);
+  }
+  ok = ok && started > 0;
+
+  if (stats) {
+    stats->threads = threads;
+    stats->steals = 0;
+    for (uint32_t i = 0; pool.blocks && i < threads; i++) {
+      stats->steals += pool.blocks[i].steals;
+    }
+  }
+  for (uint32_t i = 0; pool.blocks && i < threads; i++) {
+    pthread_mutex_destroy(&pool.blocks[i].lock);
+  }
+  free(pool.blocks);
+  free(workers);
+  free(ids);
+  return ok;
+}
@@ -0,0 +1,42 @@
+/*
+ * Sharded runs on a thread pool
+ *
+ * Runs independent simulations ("shards", e.g. one scenario of a sweep each)
+ * on a pool of worker threads. Every worker has a host of its own (host state
+ * is thread-local) and each shard starts from host_reset() with the default
+ * settings, so a shard's results depend only on its index, never on the
+ * thread count or on which worker ran it.
+ *
+ * Shards are dealt out to the workers in contiguous blocks; a worker that
+ * runs out steals the upper half of the next worker's block that has any
+ * left.
+ *
+ *   static void run(uint32_t shard, void *context) {
+ *     host_attr_set("magneticField", shard);
+ *     chip_init();
+ *     host_run_for(HOST_SEC(1));
+ *     ((uint32_t *)context)[shard] = host_pin_get("OUT");
+ *   }
+ *   host_shard_run(1000, 8, run, results, NULL);
+ */
+
+#ifndef WOKWI_SHARD_H
+#define WOKWI_SHARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*host_shard_fn_t)(uint32_t shard, void *context);
+
+typedef struct {
+  uint32_t threads;
+  uint64_t steals;        // blocks taken from another worker
+} host_shard_stats_t;
+
+// Run shards 0..count-1 on threads workers (0 for one per online CPU) and
+// wait for all of them. Shards never run on the calling thread. stats may
+// be NULL. Returns false if no worker could be started.
+bool host_shard_run(uint32_t count, uint32_t threads, host_shard_fn_t run, void *context,
+                    host_shard_stats_t *stats);
+
+#endif /* WOKWI_SHARD_H */
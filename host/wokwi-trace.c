@@ -0,0 +1,383 @@
+/*
+ * Stimulus traces, see wokwi-trace.h
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-trace.h"
+
+#define TRACE_MAGIC "WKTR"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_BYTES 8
+#define TRACE_MAX_NAMES 256
+#define TRACE_MAX_NAME_BYTES 255
+#define TRACE_BUFFER_BYTES (64 * 1024)
+#define TRACE_RELEASE_BYTES (32u << 20)   // hand pages back every 32 MB read
+
+enum {
+  KIND_NAME,
+  KIND_ATTR,
+  KIND_PIN,
+  KIND_INSTANCE,
+};
+
+enum {
+  VALUE_INTEGER,
+  VALUE_MILLI,
+  VALUE_DOUBLE,
+};
+
+#define TAG(kind, format, name) ((kind) | (format) << 2 | (name) << 4)
+#define TAG_NAME_FOLLOWS 15
+
+// Recording
+
+typedef struct {
+  int fd;
+  bool failed;
+  uint8_t *buffer;
+  size_t used;
+  uint64_t last_ns;
+  uint32_t instance;
+  uint64_t records;
+  uint64_t bytes;
+  char *names[TRACE_MAX_NAMES];
+  uint32_t name_count;
+} trace_recorder_t;
+
+static _Thread_local trace_recorder_t recorder = {.fd = -1};
+
+static size_t put_varint(uint8_t *out, uint64_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static uint64_t zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static void flush(void) {
+  size_t done = 0;
+  while (done < recorder.used && !recorder.failed) {
+    ssize_t n = write(recorder.fd, recorder.buffer + done, recorder.used - done);
+    if (n <= 0) {
+      recorder.failed = true;
+    } else {
+      done += (size_t)n;
+    }
+  }
+  recorder.bytes += done;
+  recorder.used = 0;
+}
+
+// Room for the largest record but a name definition
+static uint8_t *reserve(size_t bytes) {
+  if (recorder.used + bytes > TRACE_BUFFER_BYTES) {
+    flush();
+  }
+  return recorder.buffer + recorder.used;
+}
+
+static size_t put_head(uint8_t *out, uint64_t sim_ns, uint32_t kind, uint32_t format, uint32_t name) {
+  size_t n = put_varint(out, sim_ns - recorder.last_ns);
+  recorder.last_ns = sim_ns;
+  if (name < TAG_NAME_FOLLOWS) {
+    out[n++] = TAG(kind, format, name);
+  } else {
+    out[n++] = TAG(kind, format, TAG_NAME_FOLLOWS);
+    n += put_varint(out + n, name);
+  }
+  recorder.records++;
+  return n;
+}
+
+static uint32_t name_index(const char *name, uint64_t sim_ns) {
+  for (uint32_t i = 0; i < recorder.name_count; i++) {
+    if (strcmp(recorder.names[i], name) == 0) {
+      return i;
+    }
+  }
+  size_t length = strlen(name);
+  char *copy = NULL;
+  if (recorder.name_count == TRACE_MAX_NAMES || length > TRACE_MAX_NAME_BYTES ||
+      !(copy = strdup(name))) {
+    recorder.failed = true;
+    return 0;
+  }
+  uint8_t *out = reserve(32 + length);
+  size_t n = put_head(out, sim_ns, KIND_NAME, 0, 0);
+  n += put_varint(out + n, length);
+  memcpy(out + n, name, length);
+  recorder.used += n + length;
+  recorder.names[recorder.name_count] = copy;
+  return recorder.name_count++;
+}
+
+static void record_input(uint32_t instance, const char *name, bool pin, double value, uint64_t sim_ns) {
+  uint32_t index = name_index(name, sim_ns);
+  if (recorder.failed) {
+    return;
+  }
+  uint8_t *out = reserve(40);
+  size_t n = 0;
+  if (instance != recorder.instance) {
+    n += put_head(out, sim_ns, KIND_INSTANCE, 0, 0);
+    n += put_varint(out + n, instance);
+    recorder.instance = instance;
+  }
+  if (pin) {
+    n += put_head(out + n, sim_ns, KIND_PIN, 0, index);
+    n += put_varint(out + n, (uint32_t)value);
+  } else if (fabs(value) < 0x1p53 && (double)(int64_t)value == value &&
+             !(value == 0 && signbit(value))) {
+    n += put_head(out + n, sim_ns, KIND_ATTR, VALUE_INTEGER, index);
+    n += put_varint(out + n, zigzag((int64_t)value));
+  } else if (fabs(value) < 0x1p43 && (double)llround(value * 1000) / 1000 == value) {
+    // Slider positions like 12.3 mT
+    n += put_head(out + n, sim_ns, KIND_ATTR, VALUE_MILLI, index);
+    n += put_varint(out + n, zigzag(llround(value * 1000)));
+  } else {
+    n += put_head(out + n, sim_ns, KIND_ATTR, VALUE_DOUBLE, index);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+      out[n++] = (uint8_t)(bits >> (8 * i));
+    }
+  }
+  recorder.used += n;
+}
+
+bool host_trace_record(const char *path) {
+  host_trace_stop(NULL, NULL);
+  recorder.buffer = malloc(TRACE_BUFFER_BYTES);
+  recorder.fd = recorder.buffer ? open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+  if (recorder.fd < 0) {
+    free(recorder.buffer);
+    recorder.buffer = NULL;
+    return false;
+  }
+  memcpy(recorder.buffer, TRACE_MAGIC, 4);
+  recorder.buffer[4] = TRACE_VERSION;
+  memset(recorder.buffer + 5, 0, 3);
+  recorder.used = TRACE_HEADER_BYTES;
+  recorder.last_ns = 0;
+  host_set_input_listener(record_input);
+  return true;
+}
+
+bool host_trace_stop(uint64_t *records, uint64_t *bytes) {
+  if (records) {
+    *records = recorder.records;
+  }
+  if (recorder.fd < 0) {
+    if (bytes) {
+      *bytes = 0;
+    }
+    return false;
+  }
+  host_set_input_listener(NULL);
+  flush();
+  bool ok = close(recorder.fd) == 0 && !recorder.failed;
+  if (bytes) {
+    *bytes = recorder.bytes;
+  }
+  for (uint32_t i = 0; i < recorder.name_count; i++) {
+    free(recorder.names[i]);
+  }
+  free(recorder.buffer);
+  recorder = (trace_recorder_t){.fd = -1};
+  return ok;
+}
+
+// Replay
+
+struct host_trace {
+  const uint8_t *data;
+  size_t size;
+  size_t pos;
+  size_t released;         // pages before this were handed back
+  size_t page;
+  uint64_t time_ns;
+  uint32_t instance;
+  uint64_t records;
+  char *names[TRACE_MAX_NAMES];
+  uint32_t name_count;
+};
+
+static bool get_varint(const host_trace_t *trace, size_t *pos, uint64_t *value) {
+  uint64_t result = 0;
+  for (unsigned shift = 0; shift < 64 && *pos < trace->size; shift += 7) {
+    uint8_t byte = trace->data[(*pos)++];
+    result |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// The record after its timestamp
+static bool apply(host_trace_t *trace) {
+  if (trace->pos == trace->size) {
+    return false;
+  }
+  uint8_t tag = trace->data[trace->pos++];
+  uint32_t kind = tag & 3, format = (tag >> 2) & 3;
+  uint64_t name = tag >> 4, value;
+  if (name == TAG_NAME_FOLLOWS && !get_varint(trace, &trace->pos, &name)) {
+    return false;
+  }
+
+  switch (kind) {
+    case KIND_NAME:
+      if (trace->name_count == TRACE_MAX_NAMES || !get_varint(trace, &trace->pos, &value) ||
+          value > TRACE_MAX_NAME_BYTES || value > trace->size - trace->pos) {
+        return false;
+      }
+      char *copy = malloc(value + 1);
+      if (!copy) {
+        return false;
+      }
+      memcpy(copy, trace->data + trace->pos, value);
+      copy[value] = '\0';
+      trace->pos += value;
+      trace->names[trace->name_count++] = copy;
+      return true;
+    case KIND_INSTANCE:
+      if (!get_varint(trace, &trace->pos, &value) || value >= host_instance_count()) {
+        return false;
+      }
+      trace->instance = (uint32_t)value;
+      return true;
+    default:
+      break;
+  }
+
+  if (name >= trace->name_count) {
+    return false;
+  }
+  // Timers of other instances may have run since the last record
+  host_instance_select(trace->instance);
+  if (kind == KIND_PIN) {
+    if (!get_varint(trace, &trace->pos, &value)) {
+      return false;
+    }
+    host_pin_set(trace->names[name], (uint32_t)value);
+  } else if (format == VALUE_DOUBLE) {
+    if (trace->size - trace->pos < 8) {
+      return false;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+      bits |= (uint64_t)trace->data[trace->pos++] << (8 * i);
+    }
+    double number;
+    memcpy(&number, &bits, sizeof(number));
+    host_attr_set_float(trace->names[name], number);
+  } else {
+    if (!get_varint(trace, &trace->pos, &value)) {
+      return false;
+    }
+    double number = (double)unzigzag(value);
+    host_attr_set_float(trace->names[name], format == VALUE_MILLI ? number / 1000 : number);
+  }
+  return true;
+}
+
+host_trace_t *host_trace_open(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  void *data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= TRACE_HEADER_BYTES) {
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+  host_trace_t *trace = calloc(1, sizeof(*trace));
+  if (!trace || memcmp(data, TRACE_MAGIC, 4) != 0 || ((uint8_t *)data)[4] != TRACE_VERSION) {
+    free(trace);
+    munmap(data, (size_t)st.st_size);
+    return NULL;
+  }
+  madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+  trace->data = data;
+  trace->size = (size_t)st.st_size;
+  trace->pos = TRACE_HEADER_BYTES;
+  trace->page = (size_t)sysconf(_SC_PAGESIZE);
+  return trace;
+}
+
+bool host_trace_replay_until(host_trace_t *trace, uint64_t sim_ns) {
+  while (trace->pos < trace->size) {
+    size_t pos = trace->pos;
+    uint64_t delta;
+    if (!get_varint(trace, &pos, &delta)) {
+      return false;
+    }
+    uint64_t at = trace->time_ns + delta;
+    if (at > sim_ns) {
+      break;
+    }
+    trace->pos = pos;
+    trace->time_ns = at;
+    host_run_until(at);
+    if (!apply(trace)) {
+      return false;
+    }
+    trace->records++;
+
+    // Read pages are cheap to fault back in, so drop them rather than let a
+    // multi-GB replay fill memory
+    if (trace->pos - trace->released >= TRACE_RELEASE_BYTES) {
+      size_t end = trace->pos / trace->page * trace->page;
+      madvise((void *)(trace->data + trace->released), end - trace->released, MADV_DONTNEED);
+      trace->released = end;
+    }
+  }
+  host_run_until(sim_ns);
+  return true;
+}
+
+bool host_trace_done(const host_trace_t *trace) {
+  return trace->pos == trace->size;
+}
+
+uint64_t host_trace_records(const host_trace_t *trace) {
+  return trace->records;
+}
+
+void host_trace_close(host_trace_t *trace) {
+  if (!trace) {
+    return;
+  }
+  for (uint32_t i = 0; i < trace->name_count; i++) {
+    free(trace->names[i]);
+  }
+  munmap((void *)trace->data, trace->size);
+  free(trace);
+}
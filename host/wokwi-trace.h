@@ -0,0 +1,58 @@
+/*
+ * Stimulus traces: record what the driving program does, replay it later
+ *
+ * A trace holds timestamped records of the inputs the driving program gave
+ * the chips: numeric attribute changes (the magneticField slider, say) and
+ * input pin changes. Recording hooks host_set_input_listener(), so any run
+ * can be captured; replaying runs the host to each record's time and applies
+ * it through host_attr_set_float() / host_pin_set(), so the chip sees the
+ * same attr_read and pin watch results it saw then.
+ *
+ * File format, all integers LEB128 varints unless noted:
+ *   header   "WKTR", version byte 1, three zero bytes
+ *   record   delta_ns since the previous record, tag byte, payload
+ *   tag      bits 0-1 kind, bits 2-3 value format, bits 4-7 name index
+ *            (15: the index follows as a varint)
+ *   kinds    0 name: defines the next name index, payload length + bytes
+ *            1 attribute: value as format 0 zigzag integer, 1 zigzag
+ *              thousandths, 2 little-endian double (8 bytes)
+ *            2 pin: value as an unsigned varint
+ *            3 instance: payload the instance index the next records use
+ * A slider move costs 5-8 bytes.
+ *
+ * Replay maps the file and streams through it, handing consumed pages back,
+ * so traces far larger than RAM replay without being loaded.
+ */
+
+#ifndef WOKWI_TRACE_H
+#define WOKWI_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Record the inputs of this thread's host to path until host_trace_stop().
+// Returns false if the file cannot be created.
+bool host_trace_record(const char *path);
+
+// Finish the recording. Returns false if any write failed.
+bool host_trace_stop(uint64_t *records, uint64_t *bytes);
+
+typedef struct host_trace host_trace_t;
+
+// Map a trace for replay, NULL if it cannot be read or is not a trace.
+// Attribute names live in the trace, so keep it open while the host uses
+// them (until the next host_reset()).
+host_trace_t *host_trace_open(const char *path);
+
+// Run the host to sim_ns, applying the records due on the way. Returns false
+// on a malformed trace. Replaying to 0 before chip_init() sets the attributes
+// the recorded run set before it, as diagram.json "attrs".
+bool host_trace_replay_until(host_trace_t *trace, uint64_t sim_ns);
+
+// All records applied
+bool host_trace_done(const host_trace_t *trace);
+uint64_t host_trace_records(const host_trace_t *trace);
+
+void host_trace_close(host_trace_t *trace);
+
+#endif /* WOKWI_TRACE_H */
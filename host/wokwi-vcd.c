@@ -0,0 +1,295 @@
+/*
+ * VCD export, see wokwi-vcd.h
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+#include "wokwi-vcd.h"
+
+// For the pin modes; its timer_t clashes with the POSIX one
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#undef timer_t
+
+#define VCD_BUFFER_BYTES (4u << 20)
+#define VCD_RECORD_BYTES 64          // largest timestamp plus value change
+#define VCD_ID_BYTES 4               // 94^4 pins is plenty
+
+typedef struct {
+  const char *name;                  // the chip's pointer, compared first
+  char id[VCD_ID_BYTES];
+  uint8_t id_length;
+  bool floating;                     // in INPUT mode and undriven, dumped as z
+} vcd_var_t;
+
+typedef struct {
+  int fd;
+  bool failed;
+  char *buffer;
+  size_t used;
+  uint64_t last_ns;
+  uint64_t changes;
+  uint64_t bytes;
+  vcd_var_t *vars;
+  uint32_t *first_var;               // per instance, plus one past the last
+  uint32_t instance_count;
+} vcd_writer_t;
+
+static _Thread_local vcd_writer_t vcd = {.fd = -1};
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void flush(void) {
+  size_t done = 0;
+  while (done < vcd.used && !vcd.failed) {
+    ssize_t n = write(vcd.fd, vcd.buffer + done, vcd.used - done);
+    if (n <= 0) {
+      vcd.failed = true;
+    } else {
+      done += (size_t)n;
+    }
+  }
+  vcd.bytes += done;
+  vcd.used = 0;
+}
+
+static char *reserve(size_t bytes) {
+  if (vcd.used + bytes > VCD_BUFFER_BYTES) {
+    flush();
+  }
+  return vcd.buffer + vcd.used;
+}
+
+// Up to eight digits, no leading zeros
+static size_t put_small(char *out, uint32_t value) {
+  size_t n = value < 10 ? 1 : value < 100 ? 2 : value < 1000 ? 3 : value < 10000 ? 4 :
+             value < 100000 ? 5 : value < 1000000 ? 6 : value < 10000000 ? 7 : 8;
+  char *p = out + n;
+  while (value >= 100) {
+    p -= 2;
+    memcpy(p, &digit_pairs[(value % 100) * 2], 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    memcpy(out, &digit_pairs[value * 2], 2);
+  } else {
+    out[0] = (char)('0' + value);
+  }
+  return n;
+}
+
+// Exactly eight digits
+static void put_eight(char *out, uint32_t value) {
+  uint32_t high = value / 10000, low = value % 10000;
+  memcpy(out, &digit_pairs[(high / 100) * 2], 2);
+  memcpy(out + 2, &digit_pairs[(high % 100) * 2], 2);
+  memcpy(out + 4, &digit_pairs[(low / 100) * 2], 2);
+  memcpy(out + 6, &digit_pairs[(low % 100) * 2], 2);
+}
+
+// In 32-bit pieces of eight digits, which the compiler divides by multiplying
+static size_t put_u64(char *out, uint64_t value) {
+  if (value < 100000000) {
+    return put_small(out, (uint32_t)value);
+  }
+  uint64_t top = value / 100000000;
+  size_t n;
+  if (top < 100000000) {
+    n = put_small(out, (uint32_t)top);
+  } else {
+    n = put_small(out, (uint32_t)(top / 100000000));
+    put_eight(out + n, (uint32_t)(top % 100000000));
+    n += 8;
+  }
+  put_eight(out + n, (uint32_t)(value % 100000000));
+  return n + 8;
+}
+
+// Header text, names included; only the header needs it
+static void put_text(const char *text) {
+  size_t length = strlen(text);
+  while (length > 0 && !vcd.failed) {
+    size_t n = length < VCD_BUFFER_BYTES / 2 ? length : VCD_BUFFER_BYTES / 2;
+    memcpy(reserve(n), text, n);
+    vcd.used += n;
+    text += n;
+    length -= n;
+  }
+}
+
+// A value change ('0', '1' or 'z'), preceded by the time when it moved on
+static void put_change(const vcd_var_t *var, char value, uint64_t sim_ns) {
+  char *out = reserve(VCD_RECORD_BYTES);
+  size_t n = 0;
+  if (sim_ns != vcd.last_ns) {
+    out[n++] = '#';
+    n += put_u64(out + n, sim_ns);
+    out[n++] = '\n';
+    vcd.last_ns = sim_ns;
+  }
+  out[n] = value;
+  memcpy(out + n + 1, var->id, VCD_ID_BYTES);
+  n += 1u + var->id_length;
+  out[n++] = '\n';
+  vcd.used += n;
+}
+
+static vcd_var_t *find_var(uint32_t instance, const char *pin) {
+  if (!vcd.buffer || instance >= vcd.instance_count) {
+    return NULL;
+  }
+  vcd_var_t *var = NULL;
+  for (uint32_t i = vcd.first_var[instance]; i < vcd.first_var[instance + 1]; i++) {
+    if (vcd.vars[i].name == pin) {
+      var = &vcd.vars[i];
+      break;
+    }
+  }
+  for (uint32_t i = vcd.first_var[instance]; !var && i < vcd.first_var[instance + 1]; i++) {
+    if (strcmp(vcd.vars[i].name, pin) == 0) {
+      var = &vcd.vars[i];
+    }
+  }
+  return var;
+}
+
+// A pin nothing drives shows as z, whatever the chip writes to it meanwhile
+static char level(bool floating, uint32_t value) {
+  return floating ? 'z' : value ? '1' : '0';
+}
+
+void host_vcd_pin(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  vcd_var_t *var = find_var(instance, pin);
+  if (!var || var->floating) {
+    return;
+  }
+  put_change(var, value ? '1' : '0', sim_ns);
+  vcd.changes++;
+}
+
+void host_vcd_pin_mode(uint32_t instance, const char *pin, uint32_t mode, uint32_t value, uint64_t sim_ns) {
+  vcd_var_t *var = find_var(instance, pin);
+  if (!var || var->floating == (mode == INPUT)) {
+    return;
+  }
+  var->floating = mode == INPUT;
+  put_change(var, level(var->floating, value), sim_ns);
+  vcd.changes++;
+}
+
+void host_vcd_pin_set(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns) {
+  vcd_var_t *var = find_var(instance, pin);
+  if (!var) {
+    return;
+  }
+  var->floating = false;
+  put_change(var, level(false, value), sim_ns);
+  vcd.changes++;
+}
+
+static void release(void) {
+  free(vcd.buffer);
+  free(vcd.vars);
+  free(vcd.first_var);
+  vcd = (vcd_writer_t){.fd = -1};
+}
+
+bool host_vcd_open(const char *path) {
+  host_vcd_close(NULL, NULL);
+  vcd.instance_count = host_instance_count();
+  vcd.first_var = malloc((vcd.instance_count + 1) * sizeof(*vcd.first_var));
+  uint32_t var_count = 0;
+  for (uint32_t i = 0; vcd.first_var && i < vcd.instance_count; i++) {
+    host_instance_select(i);
+    vcd.first_var[i] = var_count;
+    var_count += host_pin_count();
+  }
+  vcd.buffer = malloc(VCD_BUFFER_BYTES);
+  vcd.vars = malloc((var_count ? var_count : 1) * sizeof(*vcd.vars));
+  if (!vcd.first_var || !vcd.buffer || !vcd.vars ||
+      (vcd.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    release();
+    return false;
+  }
+  vcd.first_var[vcd.instance_count] = var_count;
+
+  put_text("$version wokwi-host $end\n$timescale 1ns $end\n");
+  for (uint32_t i = 0, index = 0; i < vcd.instance_count; i++) {
+    host_instance_select(i);
+    char number[24];
+    number[put_u64(number, i)] = '\0';
+    put_text("$scope module chip");
+    put_text(number);
+    put_text(" $end\n");
+    for (uint32_t pin = 0; pin < host_pin_count(); pin++, index++) {
+      vcd_var_t *var = &vcd.vars[index];
+      var->name = host_pin_name(pin);
+      // Identifiers are base-94 numbers in the printable characters
+      var->id_length = 0;
+      uint32_t code = index;
+      do {
+        var->id[var->id_length++] = (char)('!' + code % 94);
+        code /= 94;
+      } while (code && var->id_length < VCD_ID_BYTES);
+      char id[VCD_ID_BYTES + 1] = {0};
+      memcpy(id, var->id, var->id_length);
+      put_text("$var wire 1 ");
+      put_text(id);
+      put_text(" ");
+      put_text(var->name);
+      put_text(" $end\n");
+    }
+    put_text("$upscope $end\n");
+  }
+  put_text("$enddefinitions $end\n");
+
+  char now[24];
+  now[put_u64(now, host_now())] = '\0';
+  put_text("#");
+  put_text(now);
+  put_text("\n$dumpvars\n");
+  vcd.last_ns = host_now();
+  for (uint32_t i = 0; i < vcd.instance_count; i++) {
+    host_instance_select(i);
+    for (uint32_t pin = vcd.first_var[i]; pin < vcd.first_var[i + 1]; pin++) {
+      vcd_var_t *var = &vcd.vars[pin];
+      var->floating = host_pin_floating(var->name);
+      put_change(var, level(var->floating, host_pin_get(var->name)), vcd.last_ns);
+    }
+  }
+  put_text("$end\n");
+  host_instance_select(0);
+  host_set_pin_listener(host_vcd_pin);
+  host_set_pin_mode_listener(host_vcd_pin_mode);
+  return true;
+}
+
+bool host_vcd_close(uint64_t *changes, uint64_t *bytes) {
+  if (changes) {
+    *changes = vcd.changes;
+  }
+  if (vcd.fd < 0) {
+    if (bytes) {
+      *bytes = 0;
+    }
+    return false;
+  }
+  host_set_pin_listener(NULL);
+  host_set_pin_mode_listener(NULL);
+  flush();
+  bool ok = close(vcd.fd) == 0 && !vcd.failed;
+  if (bytes) {
+    *bytes = vcd.bytes;
+  }
+  release();
+  return ok;
+}
@@ -0,0 +1,46 @@
+/*
+ * VCD export of chip pin activity
+ *
+ * Writes every value change on the chips' pins to a Value Change Dump file
+ * for GTKWave and friends, one module per instance (chip0, chip1, ...) with
+ * a 1-bit wire per pin, timescale 1 ns. Inputs are dumped at the level the
+ * program drives with host_pin_set(), VCC and GND included; a pin in INPUT
+ * mode that nothing drives, like an output the chip tri-stated, is z:
+ *
+ *   host_reset();
+ *   chip_init();
+ *   host_vcd_open("build/a3144.vcd");
+ *   host_run_for(HOST_SEC(10));
+ *   host_vcd_close(NULL, NULL);
+ *
+ * Output goes through one preallocated buffer and is formatted by hand, so
+ * an edge costs a few stores and no allocation or printf.
+ */
+
+#ifndef WOKWI_VCD_H
+#define WOKWI_VCD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Start dumping the pins of every instance to path, with their current
+// values at the current time. Call after chip_init(), pins created later are
+// not dumped. Installs host_vcd_pin() and host_vcd_pin_mode() as the pin
+// and pin mode listeners and leaves instance 0 selected. Returns false if
+// the file cannot be created.
+bool host_vcd_open(const char *path);
+
+// The listeners host_vcd_open() installs. A program with listeners of its
+// own calls them from there.
+void host_vcd_pin(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns);
+void host_vcd_pin_mode(uint32_t instance, const char *pin, uint32_t mode, uint32_t value, uint64_t sim_ns);
+
+// Called by host_pin_set() itself when this file is linked in, so program
+// driven inputs reach the file without taking the input listener
+void host_vcd_pin_set(uint32_t instance, const char *pin, uint32_t value, uint64_t sim_ns);
+
+// Flush and close the file. Returns false if any write failed. changes and
+// bytes may be NULL.
+bool host_vcd_close(uint64_t *changes, uint64_t *bytes);
+
+#endif /* WOKWI_VCD_H */
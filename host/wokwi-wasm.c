@@ -0,0 +1,2312 @@
+/*
+ * WebAssembly runtime for shipped chip binaries, see wokwi-wasm.h
+ *
+ * Loading decodes every function body once into a flat array of fixed-size
+ * instructions: structured control flow becomes jumps with resolved
+ * targets, and since operand stack heights are static, a branch carries the
+ * height to unwind to and the number of values it keeps. Values are 64-bit
+ * slots on one stack per instance (i32 zero-extended, floats as their bits),
+ * locals included, so a call is a frame pointer move.
+ *
+ * Covers what clang emits for wasm32 chips: the MVP instruction set plus
+ * sign extension, saturating truncation, bulk memory and multi-value
+ * blocks. SIMD, reference types beyond funcref tables, and threads are
+ * rejected at load time. Assumes a little-endian build machine.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "wokwi-host.h"
+#include "wokwi-wasm.h"
+
+#define timer_t wokwi_timer_t
+#include "wokwi-api.h"
+#undef timer_t
+
+#define WASM_PAGE 65536u
+#define WASM_DEFAULT_MAX_PAGES 4096u      // 256 MB when the module sets no maximum
+#define WASM_STACK_SLOTS (64u * 1024)
+#define WASM_MAX_FRAMES 4096u
+#define WASM_NULL UINT32_MAX
+
+enum {
+  TYPE_I32 = 0x7f,
+  TYPE_I64 = 0x7e,
+  TYPE_F32 = 0x7d,
+  TYPE_F64 = 0x7c,
+  TYPE_FUNCREF = 0x70,
+};
+
+// Internal opcodes: wasm's own where the instruction maps one to one
+enum {
+  OP_UNREACHABLE = 0x00,
+  OP_RETURN = 0x0f,
+  OP_CALL = 0x10,
+  OP_CALL_INDIRECT = 0x11,
+  OP_DROP = 0x1a,
+  OP_SELECT = 0x1b,
+  OP_LOCAL_GET = 0x20,
+  OP_LOCAL_SET = 0x21,
+  OP_LOCAL_TEE = 0x22,
+  OP_GLOBAL_GET = 0x23,
+  OP_GLOBAL_SET = 0x24,
+  OP_MEMORY_SIZE = 0x3f,
+  OP_MEMORY_GROW = 0x40,
+  OP_I32_CONST = 0x41,
+  OP_F64_CONST = 0x44,
+  OP_JUMP = 0x100,           // a: target
+  OP_JUMP_IF,
+  OP_JUMP_UNLESS,
+  OP_BR,                     // a: target, b: height, arity: values kept
+  OP_BR_IF,
+  OP_BR_TABLE,               // a: first entry in branches, b: entries - 1
+  OP_TRUNC_SAT,              // + 0-7, the 0xfc sub-opcode
+  OP_MEMORY_INIT = OP_TRUNC_SAT + 8,
+  OP_DATA_DROP,
+  OP_MEMORY_COPY,
+  OP_MEMORY_FILL,
+};
+
+typedef struct {
+  uint16_t op;
+  uint16_t arity;
+  uint32_t a;
+  uint64_t b;
+} wasm_insn_t;
+
+typedef struct {
+  uint32_t target;
+  uint32_t height;
+  uint32_t arity;
+} wasm_branch_t;
+
+typedef struct {
+  uint32_t params;
+  uint32_t results;
+  char *signature;           // "ii:i": i32 i, i64 I, f32 f, f64 F
+} wasm_type_t;
+
+typedef struct wasm_instance wasm_instance_t;
+typedef void (*wasm_import_t)(wasm_instance_t *instance, uint64_t *args);
+
+typedef struct {
+  uint32_t type;
+  wasm_import_t import;      // NULL for functions defined in the module
+  char *import_name;
+  uint32_t code;             // first instruction
+  uint32_t locals;           // declared locals, params excluded
+  uint32_t frame_slots;      // params, locals and the deepest operand stack
+} wasm_func_t;
+
+typedef struct {
+  uint8_t type;
+  uint64_t value;
+} wasm_global_t;
+
+typedef struct {
+  char *name;
+  uint8_t kind;
+  uint32_t index;
+} wasm_export_t;
+
+typedef struct {
+  bool active;
+  uint32_t offset;
+  uint32_t count;
+  uint32_t *funcs;
+} wasm_elem_t;
+
+typedef struct {
+  bool active;
+  uint32_t offset;
+  const uint8_t *bytes;
+  uint32_t size;
+} wasm_data_t;
+
+typedef struct {
+  const wasm_insn_t *ip;
+  uint64_t *fp;
+} wasm_frame_t;
+
+// Callbacks of one chip config struct, routed back into the module
+typedef struct wasm_bridge {
+  struct wasm_bridge *next;
+  wasm_instance_t *instance;
+  uint32_t user_data;
+  uint32_t callbacks[4];
+} wasm_bridge_t;
+
+struct wasm_instance {
+  host_wasm_module_t *module;
+  uint8_t *memory;
+  uint64_t memory_size;
+  uint64_t memory_reserved;
+  uint64_t *globals;
+  uint32_t *table;
+  uint32_t table_size;
+  bool *data_dropped;
+  uint64_t *stack;
+  uint64_t *stack_end;
+  uint64_t *sp;
+  wasm_frame_t *frames;
+  uint32_t depth;
+  wasm_bridge_t *bridges;
+};
+
+struct host_wasm_module {
+  uint8_t *bytes;            // own copy, data segments point into it
+  wasm_type_t *types;
+  uint32_t type_count;
+  wasm_func_t *funcs;
+  uint32_t func_count;
+  uint32_t import_count;
+  wasm_global_t *globals;
+  uint32_t global_count;
+  wasm_export_t *exports;
+  uint32_t export_count;
+  wasm_elem_t *elems;
+  uint32_t elem_count;
+  wasm_data_t *data;
+  uint32_t data_count;
+  bool has_table;
+  uint32_t table_min;
+  bool has_memory;
+  uint32_t memory_min;
+  uint32_t memory_max;
+  wasm_insn_t *code;
+  uint32_t code_count;
+  uint32_t code_capacity;
+  wasm_branch_t *branches;
+  uint32_t branch_count;
+  uint32_t branch_capacity;
+  wasm_instance_t **instances;
+  uint32_t instance_count;
+  host_wasm_stats_t stats;
+};
+
+static void wasm_trap(const char *what, const char *detail) {
+  fprintf(stderr, "wokwi-wasm: trap: %s%s%s\n", what, detail ? ": " : "", detail ? detail : "");
+  exit(1);
+}
+
+static void *grow_array(void *array, uint32_t *capacity, size_t element_size) {
+  *capacity = *capacity ? *capacity * 2 : 256;
+  array = realloc(array, *capacity * element_size);
+  if (!array) {
+    wasm_trap("out of memory", NULL);
+  }
+  return array;
+}
+
+// Module reader. Reads past the end or of malformed numbers yield zeros and
+// mark the reader failed, so the section parsers check once per item.
+
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+  const char *error;
+} wasm_reader_t;
+
+static void fail(wasm_reader_t *r, const char *error) {
+  if (!r->error) {
+    r->error = error;
+  }
+  r->p = r->end;
+}
+
+static uint8_t read_u8(wasm_reader_t *r) {
+  if (r->p >= r->end) {
+    fail(r, "unexpected end");
+    return 0;
+  }
+  return *r->p++;
+}
+
+static uint64_t read_leb(wasm_reader_t *r, unsigned bits, bool is_signed) {
+  uint64_t result = 0;
+  unsigned shift = 0;
+  uint8_t byte;
+  do {
+    if (shift >= bits + 7) {
+      fail(r, "integer too long");
+      return 0;
+    }
+    byte = read_u8(r);
+    result |= shift < 64 ? (uint64_t)(byte & 0x7f) << shift : 0;
+    shift += 7;
+  } while (byte & 0x80);
+  if (is_signed && shift < 64 && (byte & 0x40)) {
+    result |= ~0ull << shift;
+  }
+  return result;
+}
+
+static uint32_t read_u32(wasm_reader_t *r) {
+  return (uint32_t)read_leb(r, 32, false);
+}
+
+// A count of items of at least min_bytes each, checked against what is left
+static uint32_t read_count(wasm_reader_t *r, size_t min_bytes) {
+  uint32_t count = read_u32(r);
+  if ((size_t)count * min_bytes > (size_t)(r->end - r->p)) {
+    fail(r, "count out of range");
+    return 0;
+  }
+  return count;
+}
+
+static uint64_t read_fixed(wasm_reader_t *r, unsigned bytes) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < bytes; i++) {
+    value |= (uint64_t)read_u8(r) << (8 * i);
+  }
+  return value;
+}
+
+static char *read_name(wasm_reader_t *r) {
+  uint32_t length = read_count(r, 1);
+  char *name = malloc(length + 1);
+  if (!name) {
+    wasm_trap("out of memory", NULL);
+  }
+  memcpy(name, r->p, length);
+  name[length] = '\0';
+  r->p += length;
+  return name;
+}
+
+static bool value_type(uint8_t type) {
+  return type == TYPE_I32 || type == TYPE_I64 || type == TYPE_F32 || type == TYPE_F64;
+}
+
+// Constant expression: one const or global.get, then end
+static uint64_t read_const(wasm_reader_t *r, const host_wasm_module_t *m) {
+  uint64_t value = 0;
+  switch (read_u8(r)) {
+    case 0x41: value = (uint32_t)read_leb(r, 32, true); break;
+    case 0x42: value = read_leb(r, 64, true); break;
+    case 0x43: value = read_fixed(r, 4); break;
+    case 0x44: value = read_fixed(r, 8); break;
+    case 0x23: {
+      uint32_t global = read_u32(r);
+      if (global >= m->global_count) {
+        fail(r, "constant reads an unknown global");
+      } else {
+        value = m->globals[global].value;
+      }
+      break;
+    }
+    default: fail(r, "unsupported constant expression");
+  }
+  if (read_u8(r) != 0x0b) {
+    fail(r, "constant expression too long");
+  }
+  return value;
+}
+
+// Limits of a table or memory
+static void read_limits(wasm_reader_t *r, uint32_t *min, uint32_t *max) {
+  uint8_t flags = read_u8(r);
+  if (flags > 1) {
+    fail(r, "shared or 64-bit memories are not supported");
+  }
+  *min = read_u32(r);
+  *max = flags & 1 ? read_u32(r) : UINT32_MAX;
+}
+
+// Function bodies
+
+enum { LABEL_BLOCK, LABEL_LOOP, LABEL_IF };
+
+typedef struct {
+  uint8_t kind;
+  bool unreachable;
+  bool has_else;
+  uint32_t height;           // operand stack below the block's params
+  uint32_t params;
+  uint32_t results;
+  uint32_t start;            // loop: branch target
+  uint32_t jump_unless;      // if: the jump to patch at else or end
+  uint32_t patch;            // chain of jumps to the end, through their a
+  uint32_t branch_patch;     // chain of br_table entries, through target
+} wasm_label_t;
+
+typedef struct {
+  wasm_reader_t *r;
+  host_wasm_module_t *m;
+  wasm_label_t *labels;
+  uint32_t label_count;
+  uint32_t label_capacity;
+  uint32_t height;
+  uint32_t max_height;
+  uint32_t local_count;      // params and locals
+  uint8_t *local_types;
+  uint32_t skip_depth;       // nested blocks inside unreachable code
+} wasm_compiler_t;
+
+static wasm_insn_t *emit(wasm_compiler_t *c, uint16_t op, uint32_t a, uint64_t b) {
+  host_wasm_module_t *m = c->m;
+  if (m->code_count == m->code_capacity) {
+    m->code = grow_array(m->code, &m->code_capacity, sizeof(*m->code));
+  }
+  wasm_insn_t *insn = &m->code[m->code_count++];
+  *insn = (wasm_insn_t){.op = op, .a = a, .b = b};
+  return insn;
+}
+
+static void pop(wasm_compiler_t *c, uint32_t count) {
+  wasm_label_t *label = &c->labels[c->label_count - 1];
+  if (c->height < label->height + count) {
+    fail(c->r, "operand stack underflow");
+    return;
+  }
+  c->height -= count;
+}
+
+static void push(wasm_compiler_t *c, uint32_t count) {
+  c->height += count;
+  if (c->height > c->max_height) {
+    c->max_height = c->height;
+  }
+}
+
+static void push_label(wasm_compiler_t *c, uint8_t kind, uint32_t params, uint32_t results) {
+  if (c->label_count == c->label_capacity) {
+    c->labels = grow_array(c->labels, &c->label_capacity, sizeof(*c->labels));
+  }
+  if (c->label_count > 0) {
+    pop(c, params);
+  }
+  wasm_label_t *label = &c->labels[c->label_count++];
+  *label = (wasm_label_t){
+    .kind = kind,
+    .height = c->height,
+    .params = params,
+    .results = results,
+    .start = c->m->code_count,
+    .jump_unless = WASM_NULL,
+    .patch = WASM_NULL,
+    .branch_patch = WASM_NULL,
+  };
+  push(c, params);
+}
+
+static void block_type(wasm_compiler_t *c, uint32_t *params, uint32_t *results) {
+  int64_t type = (int64_t)read_leb(c->r, 33, true);
+  *params = 0;
+  *results = 0;
+  if (type == -0x40) {
+    return;
+  }
+  if (type < 0) {
+    if (!value_type((uint8_t)(type & 0x7f))) {
+      fail(c->r, "unsupported block type");
+    }
+    *results = 1;
+  } else if ((uint64_t)type < c->m->type_count) {
+    *params = c->m->types[type].params;
+    *results = c->m->types[type].results;
+  } else {
+    fail(c->r, "unknown block type");
+  }
+}
+
+// A branch to the label depth levels out: a plain jump when nothing needs
+// unwinding, else one that moves the kept values down
+static void branch(wasm_compiler_t *c, uint32_t depth, bool conditional) {
+  if (depth >= c->label_count) {
+    fail(c->r, "branch depth out of range");
+    return;
+  }
+  wasm_label_t *label = &c->labels[c->label_count - 1 - depth];
+  uint32_t arity = label->kind == LABEL_LOOP ? label->params : label->results;
+  if (c->height < label->height + arity) {
+    fail(c->r, "operand stack underflow");
+    return;
+  }
+  bool unwind = c->height - arity != label->height;
+  wasm_insn_t *insn = emit(c, unwind ? (conditional ? OP_BR_IF : OP_BR) : (conditional ? OP_JUMP_IF : OP_JUMP),
+                           0, label->height);
+  insn->arity = (uint16_t)arity;
+  if (label->kind == LABEL_LOOP) {
+    insn->a = label->start;
+  } else {
+    insn->a = label->patch;
+    label->patch = (uint32_t)(insn - c->m->code);
+  }
+}
+
+static void branch_table_entry(wasm_compiler_t *c, wasm_branch_t *entry, uint32_t depth, uint32_t arity) {
+  if (depth >= c->label_count) {
+    fail(c->r, "branch depth out of range");
+    return;
+  }
+  wasm_label_t *label = &c->labels[c->label_count - 1 - depth];
+  if ((label->kind == LABEL_LOOP ? label->params : label->results) != arity ||
+      c->height < label->height + arity) {
+    fail(c->r, "br_table arity mismatch");
+    return;
+  }
+  entry->height = label->height;
+  entry->arity = arity;
+  if (label->kind == LABEL_LOOP) {
+    entry->target = label->start;
+  } else {
+    entry->target = label->branch_patch;
+    label->branch_patch = (uint32_t)(entry - c->m->branches);
+  }
+}
+
+static void end_label(wasm_compiler_t *c) {
+  wasm_label_t *label = &c->labels[c->label_count - 1];
+  if (!label->unreachable && c->height != label->height + label->results) {
+    fail(c->r, "block leaves the wrong number of values");
+    return;
+  }
+  uint32_t here = c->m->code_count;
+  if (label->jump_unless != WASM_NULL) {
+    c->m->code[label->jump_unless].a = here;
+  }
+  for (uint32_t at = label->patch; at != WASM_NULL;) {
+    uint32_t next = c->m->code[at].a;
+    c->m->code[at].a = here;
+    at = next;
+  }
+  for (uint32_t at = label->branch_patch; at != WASM_NULL;) {
+    uint32_t next = c->m->branches[at].target;
+    c->m->branches[at].target = here;
+    at = next;
+  }
+  c->height = label->height + label->results;
+  c->label_count--;
+}
+
+static void set_unreachable(wasm_compiler_t *c) {
+  wasm_label_t *label = &c->labels[c->label_count - 1];
+  label->unreachable = true;
+  c->height = label->height;
+}
+
+// Binary numeric opcodes pop two operands, the rest of 0x45-0xc4 one
+static bool binary_op(uint8_t op) {
+  return (op >= 0x46 && op <= 0x4f) || (op >= 0x51 && op <= 0x66) || (op >= 0x6a && op <= 0x78) ||
+         (op >= 0x7c && op <= 0x8a) || (op >= 0x92 && op <= 0x98) || (op >= 0xa0 && op <= 0xa6);
+}
+
+// Immediates of an instruction in unreachable code, which is not compiled
+static void skip_immediates(wasm_compiler_t *c, uint8_t op) {
+  wasm_reader_t *r = c->r;
+  uint32_t ignored;
+  if (op == 0x02 || op == 0x03 || op == 0x04) {
+    block_type(c, &ignored, &ignored);
+    c->skip_depth++;
+  } else if (op == 0x0c || op == 0x0d || op == 0x10 || (op >= 0x20 && op <= 0x24)) {
+    read_u32(r);
+  } else if (op == 0x0e) {
+    for (uint32_t n = read_count(r, 1) + 1; n > 0 && !r->error; n--) {
+      read_u32(r);
+    }
+  } else if (op == 0x11 || (op >= 0x28 && op <= 0x3e)) {
+    read_u32(r);
+    read_u32(r);
+  } else if (op == 0x3f || op == 0x40) {
+    read_u8(r);
+  } else if (op == 0x41) {
+    read_leb(r, 32, true);
+  } else if (op == 0x42) {
+    read_leb(r, 64, true);
+  } else if (op == 0x43) {
+    read_fixed(r, 4);
+  } else if (op == 0x44) {
+    read_fixed(r, 8);
+  } else if (op == 0x1c) {
+    for (uint32_t n = read_count(r, 1); n > 0 && !r->error; n--) {
+      read_u8(r);
+    }
+  } else if (op == 0xfc) {
+    uint32_t sub = read_u32(r);
+    if (sub == 8 || sub == 10) {
+      read_u32(r);
+      read_u8(r);
+    } else if (sub == 9 || sub == 11) {
+      read_u32(r);
+    }
+  }
+}
+
+static void compile_memory_op(wasm_compiler_t *c, uint8_t op) {
+  read_u32(c->r);  // alignment hint
+  uint32_t offset = read_u32(c->r);
+  if (!c->m->has_memory) {
+    fail(c->r, "memory access without a memory");
+  }
+  if (op <= 0x35) {
+    pop(c, 1);
+    push(c, 1);
+  } else {
+    pop(c, 2);
+  }
+  emit(c, op, offset, 0);
+}
+
+static void compile_call(wasm_compiler_t *c, const wasm_type_t *type) {
+  pop(c, type->params);
+  push(c, type->results);
+}
+
+static void compile_prefixed(wasm_compiler_t *c) {
+  wasm_reader_t *r = c->r;
+  uint32_t sub = read_u32(r);
+  if (sub <= 7) {
+    pop(c, 1);
+    push(c, 1);
+    emit(c, (uint16_t)(OP_TRUNC_SAT + sub), 0, 0);
+  } else if (sub == 8) {
+    uint32_t segment = read_u32(r);
+    if (read_u8(r) != 0 || segment >= c->m->data_count) {
+      fail(r, "memory.init of an unknown segment");
+    }
+    pop(c, 3);
+    emit(c, OP_MEMORY_INIT, segment, 0);
+  } else if (sub == 9) {
+    uint32_t segment = read_u32(r);
+    if (segment >= c->m->data_count) {
+      fail(r, "data.drop of an unknown segment");
+    }
+    emit(c, OP_DATA_DROP, segment, 0);
+  } else if (sub == 10 || sub == 11) {
+    if (read_u8(r) != 0 || (sub == 10 && read_u8(r) != 0) || !c->m->has_memory) {
+      fail(r, "bulk memory operation without a memory");
+    }
+    pop(c, 3);
+    emit(c, sub == 10 ? OP_MEMORY_COPY : OP_MEMORY_FILL, 0, 0);
+  } else {
+    fail(r, "unsupported 0xfc instruction");
+  }
+}
+
+static void compile_body(wasm_compiler_t *c, wasm_func_t *func) {
+  wasm_reader_t *r = c->r;
+  host_wasm_module_t *m = c->m;
+  const wasm_type_t *type = &m->types[func->type];
+  func->code = m->code_count;
+  c->height = c->local_count;
+  c->max_height = c->height;
+  c->label_count = 0;
+  c->skip_depth = 0;
+  push_label(c, LABEL_BLOCK, 0, type->results);
+
+  while (c->label_count > 0 && !r->error) {
+    uint8_t op = read_u8(r);
+    wasm_label_t *label = &c->labels[c->label_count - 1];
+    if (label->unreachable && op != 0x0b && op != 0x05) {
+      skip_immediates(c, op);
+      continue;
+    }
+    if (label->unreachable && c->skip_depth > 0) {
+      if (op == 0x0b) {
+        c->skip_depth--;
+      }
+      continue;
+    }
+
+    uint32_t a, b;
+    switch (op) {
+      case 0x00:
+        emit(c, OP_UNREACHABLE, 0, 0);
+        set_unreachable(c);
+        break;
+      case 0x01:
+        break;
+      case 0x02:
+      case 0x03:
+        block_type(c, &a, &b);
+        push_label(c, op == 0x02 ? LABEL_BLOCK : LABEL_LOOP, a, b);
+        break;
+      case 0x04: {
+        block_type(c, &a, &b);
+        pop(c, 1);
+        uint32_t jump = m->code_count;
+        emit(c, OP_JUMP_UNLESS, 0, 0);
+        push_label(c, LABEL_IF, a, b);
+        c->labels[c->label_count - 1].jump_unless = jump;
+        break;
+      }
+      case 0x05:
+        if (label->kind != LABEL_IF || label->has_else) {
+          fail(r, "else without if");
+          break;
+        }
+        if (!label->unreachable) {
+          if (c->height != label->height + label->results) {
+            fail(r, "if branch leaves the wrong number of values");
+            break;
+          }
+          wasm_insn_t *jump = emit(c, OP_JUMP, label->patch, 0);
+          label->patch = (uint32_t)(jump - m->code);
+        }
+        m->code[label->jump_unless].a = m->code_count;
+        label->jump_unless = WASM_NULL;
+        label->has_else = true;
+        label->unreachable = false;
+        c->height = label->height + label->params;
+        break;
+      case 0x0b:
+        if (label->kind == LABEL_IF && !label->has_else && label->params != label->results) {
+          fail(r, "if without else must keep its values");
+          break;
+        }
+        end_label(c);
+        if (c->label_count == 0) {
+          wasm_insn_t *ret = emit(c, OP_RETURN, 0, 0);
+          ret->arity = (uint16_t)type->results;
+        }
+        break;
+      case 0x0c:
+        branch(c, read_u32(r), false);
+        set_unreachable(c);
+        break;
+      case 0x0d:
+        a = read_u32(r);
+        pop(c, 1);
+        branch(c, a, true);
+        break;
+      case 0x0e: {
+        uint32_t count = read_count(r, 1) + 1;
+        pop(c, 1);
+        uint32_t first = m->branch_count;
+        for (uint32_t i = 0; i < count && !r->error; i++) {
+          if (m->branch_count == m->branch_capacity) {
+            m->branches = grow_array(m->branches, &m->branch_capacity, sizeof(*m->branches));
+          }
+          m->branch_count++;
+        }
+        // Arity from the default target, which comes last
+        uint32_t arity = 0;
+        const uint8_t *targets = r->p;
+        for (uint32_t i = 0; i + 1 < count; i++) {
+          read_u32(r);
+        }
+        b = read_u32(r);
+        if (b < c->label_count) {
+          wasm_label_t *target = &c->labels[c->label_count - 1 - b];
+          arity = target->kind == LABEL_LOOP ? target->params : target->results;
+        }
+        r->p = r->error ? r->p : targets;
+        for (uint32_t i = 0; i < count && !r->error; i++) {
+          branch_table_entry(c, &m->branches[first + (i + 1) % count], read_u32(r), arity);
+        }
+        emit(c, OP_BR_TABLE, first, count - 1);
+        set_unreachable(c);
+        break;
+      }
+      case 0x0f: {
+        if (c->height < c->labels[0].height + type->results) {
+          fail(r, "operand stack underflow");
+          break;
+        }
+        wasm_insn_t *ret = emit(c, OP_RETURN, 0, 0);
+        ret->arity = (uint16_t)type->results;
+        set_unreachable(c);
+        break;
+      }
+      case 0x10:
+        a = read_u32(r);
+        if (a >= m->func_count) {
+          fail(r, "call of an unknown function");
+          break;
+        }
+        compile_call(c, &m->types[m->funcs[a].type]);
+        emit(c, OP_CALL, a, 0);
+        break;
+      case 0x11:
+        a = read_u32(r);
+        if (read_u32(r) != 0 || a >= m->type_count || !m->has_table) {
+          fail(r, "call_indirect needs table 0 and a known type");
+          break;
+        }
+        pop(c, 1);
+        compile_call(c, &m->types[a]);
+        emit(c, OP_CALL_INDIRECT, a, 0);
+        break;
+      case 0x1a:
+        pop(c, 1);
+        emit(c, OP_DROP, 0, 0);
+        break;
+      case 0x1c:
+        if (read_u32(r) != 1 || !value_type(read_u8(r))) {
+          fail(r, "unsupported typed select");
+          break;
+        }
+        // fall through
+      case 0x1b:
+        pop(c, 3);
+        push(c, 1);
+        emit(c, OP_SELECT, 0, 0);
+        break;
+      case 0x20:
+      case 0x21:
+      case 0x22:
+        a = read_u32(r);
+        if (a >= c->local_count) {
+          fail(r, "unknown local");
+          break;
+        }
+        if (op == 0x20) {
+          push(c, 1);
+        } else if (op == 0x21) {
+          pop(c, 1);
+        } else {
+          pop(c, 1);
+          push(c, 1);
+        }
+        emit(c, op, a, 0);
+        break;
+      case 0x23:
+      case 0x24:
+        a = read_u32(r);
+        if (a >= m->global_count) {
+          fail(r, "unknown global");
+          break;
+        }
+        if (op == 0x23) {
+          push(c, 1);
+        } else {
+          pop(c, 1);
+        }
+        emit(c, op, a, 0);
+        break;
+      case 0x3f:
+      case 0x40:
+        if (read_u8(r) != 0 || !m->has_memory) {
+          fail(r, "memory instruction without a memory");
+          break;
+        }
+        if (op == 0x40) {
+          pop(c, 1);
+        }
+        push(c, 1);
+        emit(c, op, 0, 0);
+        break;
+      case 0x41:
+        push(c, 1);
+        emit(c, op, 0, (uint32_t)read_leb(r, 32, true));
+        break;
+      case 0x42:
+        push(c, 1);
+        emit(c, op, 0, read_leb(r, 64, true));
+        break;
+      case 0x43:
+        push(c, 1);
+        emit(c, op, 0, read_fixed(r, 4));
+        break;
+      case 0x44:
+        push(c, 1);
+        emit(c, op, 0, read_fixed(r, 8));
+        break;
+      case 0xfc:
+        compile_prefixed(c);
+        break;
+      default:
+        if (op >= 0x28 && op <= 0x3e) {
+          compile_memory_op(c, op);
+        } else if (op >= 0x45 && op <= 0xc4) {
+          pop(c, binary_op(op) ? 2 : 1);
+          push(c, 1);
+          emit(c, op, 0, 0);
+        } else {
+          fail(r, "unsupported instruction");
+        }
+        break;
+    }
+  }
+  func->frame_slots = c->max_height;
+}
+
+// Sections
+
+static void parse_types(wasm_reader_t *r, host_wasm_module_t *m) {
+  m->type_count = read_count(r, 3);
+  m->types = calloc(m->type_count ? m->type_count : 1, sizeof(*m->types));
+  for (uint32_t i = 0; i < m->type_count && !r->error; i++) {
+    wasm_type_t *type = &m->types[i];
+    if (read_u8(r) != 0x60) {
+      fail(r, "unsupported type form");
+      break;
+    }
+    uint32_t params = read_count(r, 1);
+    const uint8_t *param_types = r->p;
+    r->p += params;
+    uint32_t results = r->error ? 0 : read_count(r, 1);
+    const uint8_t *result_types = r->p;
+    r->p += results;
+    type->params = params;
+    type->results = results;
+    type->signature = malloc(params + results + 2);
+    char *s = type->signature;
+    for (uint32_t j = 0; j < params + results && !r->error; j++) {
+      uint8_t t = j < params ? param_types[j] : result_types[j - params];
+      if (!value_type(t)) {
+        fail(r, "unsupported value type");
+      }
+      if (j == params) {
+        *s++ = ':';
+      }
+      *s++ = t == TYPE_I32 ? 'i' : t == TYPE_I64 ? 'I' : t == TYPE_F32 ? 'f' : 'F';
+    }
+    if (results == 0) {
+      *s++ = ':';
+    }
+    *s = '\0';
+  }
+}
+
+static wasm_import_t find_binding(const char *module, const char *name, const char *signature, bool *mismatch);
+
+static void parse_imports(wasm_reader_t *r, host_wasm_module_t *m) {
+  uint32_t count = read_count(r, 4);
+  m->funcs = calloc(count ? count : 1, sizeof(*m->funcs));
+  for (uint32_t i = 0; i < count && !r->error; i++) {
+    char *module = read_name(r);
+    char *name = read_name(r);
+    uint8_t kind = read_u8(r);
+    if (kind == 0) {
+      uint32_t type = read_u32(r);
+      if (type >= m->type_count) {
+        fail(r, "import of an unknown type");
+      } else {
+        wasm_func_t *func = &m->funcs[m->func_count++];
+        bool mismatch = false;
+        func->type = type;
+        func->import = find_binding(module, name, m->types[type].signature, &mismatch);
+        func->import_name = malloc(strlen(module) + strlen(name) + 2);
+        sprintf(func->import_name, "%s.%s", module, name);
+        if (mismatch) {
+          fail(r, "import with a different signature than wokwi-api.h");
+        }
+      }
+    } else if (kind == 2 && !m->has_memory) {
+      read_limits(r, &m->memory_min, &m->memory_max);
+      m->has_memory = true;
+    } else {
+      fail(r, "only function and memory imports are supported");
+    }
+    free(module);
+    free(name);
+  }
+  m->import_count = m->func_count;
+}
+
+static void parse_functions(wasm_reader_t *r, host_wasm_module_t *m) {
+  uint32_t count = read_count(r, 1);
+  m->funcs = realloc(m->funcs, (m->func_count + count + 1) * sizeof(*m->funcs));
+  for (uint32_t i = 0; i < count && !r->error; i++) {
+    wasm_func_t *func = &m->funcs[m->func_count++];
+    *func = (wasm_func_t){.type = read_u32(r)};
+    if (func->type >= m->type_count) {
+      fail(r, "function of an unknown type");
+    }
+  }
+}
+
+static void parse_table(wasm_reader_t *r, host_wasm_module_t *m) {
+  uint32_t count = read_count(r, 3), max;
+  if (count > 1 || (count == 1 && (read_u8(r) != TYPE_FUNCREF || m->has_table))) {
+    fail(r, "only one funcref table is supported");
+    return;
+  }
+  if (count == 1) {
+    read_limits(r, &m->table_min, &max);
+    m->has_table = true;
+  }
+}
+
+static void parse_memory(wasm_reader_t *r, host_wasm_module_t *m) {
+  uint32_t count = read_count(r, 2);
+  if (count > 1 || (count == 1 && m->has_memory)) {
+    fail(r, "only one memory is supported");
+    return;
+  }
+  if (count == 1) {
+    read_limits(r, &m->memory_min, &m->memory_max);
+    m->has_memory = true;
+  }
+}
+
+static void parse_globals(wasm_reader_t *r, host_wasm_module_t *m) {
+  uint32_t count = read_count(r, 4);
+  m->globals = calloc(count ? count : 1, sizeof(*m->globals));
+  for (uint32_t i = 0; i < count && !r->error; i++) {
+    uint8_t type = read_u8(r);
+    read_u8(r);  // mutability
+    if (!value_type(type)) {
+      fail(r, "unsupported global type");
+    }
+    m->globals[i].type = type;
+    m->globals[i].value = read_const(r, m);
+    m->global_count = i + 1;
+  }
+}
+
+static void parse_exports(wasm_reader_t *r, host_wasm_module_t *m) {
+  m->export_count = read_count(r, 3);
+  m->exports = calloc(m->export_count ? m->export_count : 1, sizeof(*m->exports));
+  for (uint32_t i = 0; i < m->export_count && !r->error; i++) {
+    m->exports[i].name = read_name(r);
+    m->exports[i].kind = read_u8(r);
+    m->exports[i].index = read_u32(r);
+    if (m->exports[i].kind == 0 && m->exports[i].index >= m->func_count) {
+      fail(r, "export of an unknown function");
+    }
+  }
+}
+
+static void parse_elements(wasm_reader_t *r, host_wasm_module_t *m) {
+  m->elem_count = read_count(r, 3);
+  m->elems = calloc(m->elem_count ? m->elem_count : 1, sizeof(*m->elems));
+  for (uint32_t i = 0; i < m->elem_count && !r->error; i++) {
+    wasm_elem_t *elem = &m->elems[i];
+    uint32_t flags = read_u32(r);
+    elem->active = !(flags & 1);
+    if (flags > 7 || (flags == 2 && read_u32(r) != 0) || (flags == 6 && read_u32(r) != 0)) {
+      fail(r, "unsupported element segment");
+      break;
+    }
+    if (elem->active) {
+      elem->offset = (uint32_t)read_const(r, m);
+    }
+    bool expressions = flags & 4;
+    if ((flags & 3) != 0 && read_u8(r) != (expressions ? TYPE_FUNCREF : 0x00)) {
+      fail(r, "unsupported element kind");
+      break;
+    }
+    elem->count = read_count(r, 1);
+    elem->funcs = malloc((elem->count ? elem->count : 1) * sizeof(*elem->funcs));
+    for (uint32_t j = 0; j < elem->count && !r->error; j++) {
+      if (expressions) {
+        uint8_t op = read_u8(r);
+        elem->funcs[j] = op == 0xd2 ? read_u32(r) : op == 0xd0 ? (read_u8(r), WASM_NULL) : 0;
+        if ((op != 0xd2 && op != 0xd0) || read_u8(r) != 0x0b) {
+          fail(r, "unsupported element expression");
+        }
+      } else {
+        elem->funcs[j] = read_u32(r);
+      }
+      if (elem->funcs[j] != WASM_NULL && elem->funcs[j] >= m->func_count) {
+        fail(r, "element of an unknown function");
+      }
+    }
+  }
+}
+
+static void parse_code(wasm_reader_t *r, host_wasm_module_t *m) {
+  uint32_t count = read_count(r, 2);
+  if (count != m->func_count - m->import_count) {
+    fail(r, "function and code counts differ");
+    return;
+  }
+  wasm_compiler_t c = {.r = r, .m = m};
+  for (uint32_t i = 0; i < count && !r->error; i++) {
+    wasm_func_t *func = &m->funcs[m->import_count + i];
+    uint32_t size = read_count(r, 1);
+    const uint8_t *end = r->p + size;
+    wasm_reader_t body = {.p = r->p, .end = end};
+    const wasm_type_t *type = &m->types[func->type];
+    c.r = &body;
+    c.local_count = type->params;
+    for (uint32_t groups = read_count(&body, 2); groups > 0 && !body.error; groups--) {
+      uint32_t n = read_u32(&body);
+      uint8_t t = read_u8(&body);
+      if (!value_type(t) || n > WASM_STACK_SLOTS) {
+        fail(&body, "unsupported locals");
+      }
+      c.local_count += n;
+      func->locals += n;
+    }
+    if (c.local_count > WASM_STACK_SLOTS) {
+      fail(&body, "too many locals");
+    }
+    if (!body.error) {
+      compile_body(&c, func);
+    }
+    if (!body.error && body.p != end) {
+      fail(&body, "function body continues after its end");
+    }
+    if (body.error) {
+      fail(r, body.error);
+    }
+    r->p = end;
+  }
+  free(c.labels);
+}
+
+static void parse_data(wasm_reader_t *r, host_wasm_module_t *m) {
+  m->data_count = read_count(r, 2);
+  m->data = calloc(m->data_count ? m->data_count : 1, sizeof(*m->data));
+  for (uint32_t i = 0; i < m->data_count && !r->error; i++) {
+    wasm_data_t *data = &m->data[i];
+    uint32_t flags = read_u32(r);
+    if (flags > 2 || (flags == 2 && read_u32(r) != 0)) {
+      fail(r, "unsupported data segment");
+      break;
+    }
+    data->active = flags != 1;
+    if (data->active) {
+      data->offset = (uint32_t)read_const(r, m);
+    }
+    data->size = read_count(r, 1);
+    data->bytes = r->p;
+    r->p += data->size;
+  }
+}
+
+host_wasm_module_t *host_wasm_load_bytes(const uint8_t *bytes, size_t size, char *error, size_t error_size) {
+  host_wasm_module_t *m = calloc(1, sizeof(*m));
+  if (!m || !(m->bytes = malloc(size ? size : 1))) {
+    wasm_trap("out of memory", NULL);
+  }
+  memcpy(m->bytes, bytes, size);
+  wasm_reader_t r = {.p = m->bytes, .end = m->bytes + size};
+  if (read_fixed(&r, 4) != 0x6d736100 || read_fixed(&r, 4) != 1) {
+    fail(&r, "not a WebAssembly 1.0 module");
+  }
+
+  // The code section is compiled as it is read and needs the data count
+  // for memory.init, so look for a data count section first
+  uint32_t data_count = 0;
+  for (wasm_reader_t scan = r; scan.p < scan.end && !scan.error;) {
+    uint8_t id = read_u8(&scan);
+    uint32_t length = read_count(&scan, 1);
+    if (id == 12) {
+      wasm_reader_t section = {.p = scan.p, .end = scan.p + length};
+      data_count = read_u32(&section);
+    }
+    scan.p += length;
+  }
+  m->data_count = data_count;
+
+  uint8_t last = 0;
+  while (r.p < r.end && !r.error) {
+    uint8_t id = read_u8(&r);
+    uint32_t length = read_count(&r, 1);
+    wasm_reader_t section = {.p = r.p, .end = r.p + length};
+    if (id != 0 && id != 12 && id <= last) {
+      fail(&r, "sections out of order");
+      break;
+    }
+    last = id == 12 ? 9 : id ? id : last;    // data count sits before code
+    switch (id) {
+      case 0: break;    // custom
+      case 1: parse_types(&section, m); break;
+      case 2: parse_imports(&section, m); break;
+      case 3: parse_functions(&section, m); break;
+      case 4: parse_table(&section, m); break;
+      case 5: parse_memory(&section, m); break;
+      case 6: parse_globals(&section, m); break;
+      case 7: parse_exports(&section, m); break;
+      case 8: fail(&section, "start functions are not supported"); break;
+      case 9: parse_elements(&section, m); break;
+      case 10: parse_code(&section, m); break;
+      case 11: parse_data(&section, m); break;
+      case 12: break;
+      default: fail(&section, "unknown section"); break;
+    }
+    if (!section.error && id != 0 && id != 12 && section.p != section.end) {
+      fail(&section, "section continues after its contents");
+    }
+    if (section.error) {
+      fail(&r, section.error);
+    }
+    r.p = section.end;
+  }
+  if (!r.error && m->func_count != m->import_count && !m->code) {
+    fail(&r, "missing code section");
+  }
+  if (r.error) {
+    if (error_size) {
+      snprintf(error, error_size, "%s", r.error);
+    }
+    host_wasm_free(m);
+    return NULL;
+  }
+  return m;
+}
+
+host_wasm_module_t *host_wasm_load(const char *path, char *error, size_t error_size) {
+  FILE *file = fopen(path, "rb");
+  uint8_t *bytes = NULL;
+  long size = -1;
+  if (file && fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+      (bytes = malloc((size_t)size + 1)) && fread(bytes, 1, (size_t)size, file) != (size_t)size) {
+    size = -1;
+  }
+  if (file) {
+    fclose(file);
+  }
+  host_wasm_module_t *m = NULL;
+  if (size < 0 || !bytes) {
+    snprintf(error, error_size, "cannot read %s", path);
+  } else {
+    m = host_wasm_load_bytes(bytes, (size_t)size, error, error_size);
+  }
+  free(bytes);
+  return m;
+}
+
+// Execution
+
+static inline float as_f32(uint64_t slot) {
+  uint32_t bits = (uint32_t)slot;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline double as_f64(uint64_t slot) {
+  double value;
+  memcpy(&value, &slot, sizeof(value));
+  return value;
+}
+
+static inline uint64_t from_f32(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static inline uint64_t from_f64(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// min/max propagate NaN and order -0 below +0, unlike fmin/fmax
+static float min_f32(float a, float b) {
+  return isnan(a) || isnan(b) ? NAN : a == b ? (signbit(a) ? a : b) : a < b ? a : b;
+}
+
+static float max_f32(float a, float b) {
+  return isnan(a) || isnan(b) ? NAN : a == b ? (signbit(a) ? b : a) : a > b ? a : b;
+}
+
+static double min_f64(double a, double b) {
+  return isnan(a) || isnan(b) ? NAN : a == b ? (signbit(a) ? a : b) : a < b ? a : b;
+}
+
+static double max_f64(double a, double b) {
+  return isnan(a) || isnan(b) ? NAN : a == b ? (signbit(a) ? b : a) : a > b ? a : b;
+}
+
+// Float to integer: the range each target type accepts, exclusive
+static const struct {
+  double low;
+  double high;
+  bool is_signed;
+  bool is_64;
+} truncations[] = {
+  {-2147483649.0, 2147483648.0, true, false},
+  {-1.0, 4294967296.0, false, false},
+  {-9223372036854777856.0, 9223372036854775808.0, true, true},
+  {-1.0, 18446744073709551616.0, false, true},
+};
+
+// kind: 0 i32_s, 1 i32_u, 2 i64_s, 3 i64_u
+static uint64_t truncate(double value, unsigned kind, bool saturate) {
+  if (isnan(value)) {
+    if (!saturate) {
+      wasm_trap("invalid conversion to integer", NULL);
+    }
+    return 0;
+  }
+  if (value <= truncations[kind].low || value >= truncations[kind].high) {
+    if (!saturate) {
+      wasm_trap("integer overflow", NULL);
+    }
+    bool low = value < 0;
+    switch (kind) {
+      case 0: return (uint32_t)(low ? INT32_MIN : INT32_MAX);
+      case 1: return low ? 0 : UINT32_MAX;
+      case 2: return (uint64_t)(low ? INT64_MIN : INT64_MAX);
+      default: return low ? 0 : UINT64_MAX;
+    }
+  }
+  switch (kind) {
+    case 0: return (uint32_t)(int32_t)value;
+    case 1: return (uint32_t)value;
+    case 2: return (uint64_t)(int64_t)value;
+    default: return (uint64_t)value;
+  }
+}
+
+#define I32(x) ((uint32_t)(x))
+#define I64(x) ((uint64_t)(x))
+#define S32(x) ((int32_t)(uint32_t)(x))
+#define S64(x) ((int64_t)(x))
+#define UNARY(expr) { uint64_t x = sp[-1]; (void)x; sp[-1] = (expr); break; }
+#define BINARY(expr) { uint64_t y = sp[-1], x = sp[-2]; sp--; sp[-1] = (expr); break; }
+#define CHECKED(bytes) \
+  uint64_t address = (uint64_t)I32(sp[-1]) + insn->a; \
+  if (address + (bytes) > memory_size) { \
+    wasm_trap("out of bounds memory access", NULL); \
+  }
+#define LOAD(type, bytes, convert) { \
+    CHECKED(bytes); \
+    type value; \
+    memcpy(&value, memory + address, bytes); \
+    sp[-1] = (convert); \
+    break; \
+  }
+#define STORE(type, bytes) { \
+    uint64_t stored = sp[-1]; \
+    sp--; \
+    CHECKED(bytes); \
+    type value = (type)stored; \
+    memcpy(memory + address, &value, bytes); \
+    sp--; \
+    break; \
+  }
+
+// The callee's params sit on top of the stack: they become its frame, and
+// its results are left where the params started
+static void execute(wasm_instance_t *instance, uint32_t func_index) {
+  host_wasm_module_t *m = instance->module;
+  const wasm_func_t *func = &m->funcs[func_index];
+  const wasm_type_t *type = &m->types[func->type];
+  uint64_t *sp = instance->sp;
+
+  if (func->import) {
+    m->stats.host_calls++;
+    instance->sp = sp;
+    func->import(instance, sp - type->params);
+    instance->sp = sp - type->params + type->results;
+    return;
+  }
+
+  uint32_t entry_depth = instance->depth;
+  uint64_t *fp = sp - type->params;
+  uint8_t *memory = instance->memory;
+  uint64_t memory_size = instance->memory_size;
+  uint64_t executed = 0;
+  const wasm_insn_t *ip;
+
+enter:
+  if (fp + func->frame_slots > instance->stack_end) {
+    wasm_trap("call stack exhausted", NULL);
+  }
+  memset(sp, 0, func->locals * sizeof(*sp));
+  sp += func->locals;
+  ip = m->code + func->code;
+
+  for (;;) {
+    const wasm_insn_t *insn = ip++;
+    executed++;
+    switch (insn->op) {
+      case OP_UNREACHABLE:
+        wasm_trap("unreachable executed", NULL);
+        break;
+
+      case OP_JUMP:
+        ip = m->code + insn->a;
+        break;
+      case OP_JUMP_IF:
+        if (I32(*--sp)) {
+          ip = m->code + insn->a;
+        }
+        break;
+      case OP_JUMP_UNLESS:
+        if (!I32(*--sp)) {
+          ip = m->code + insn->a;
+        }
+        break;
+      case OP_BR_IF:
+        if (!I32(*--sp)) {
+          break;
+        }
+        // fall through
+      case OP_BR:
+        memmove(fp + insn->b, sp - insn->arity, insn->arity * sizeof(*sp));
+        sp = fp + insn->b + insn->arity;
+        ip = m->code + insn->a;
+        break;
+      case OP_BR_TABLE: {
+        uint32_t index = I32(*--sp);
+        const wasm_branch_t *entry = &m->branches[insn->a + (index < insn->b ? index + 1 : 0)];
+        memmove(fp + entry->height, sp - entry->arity, entry->arity * sizeof(*sp));
+        sp = fp + entry->height + entry->arity;
+        ip = m->code + entry->target;
+        break;
+      }
+      case OP_RETURN:
+        memmove(fp, sp - insn->arity, insn->arity * sizeof(*sp));
+        sp = fp + insn->arity;
+        if (instance->depth == entry_depth) {
+          instance->sp = sp;
+          m->stats.instructions += executed;
+          return;
+        }
+        instance->depth--;
+        ip = instance->frames[instance->depth].ip;
+        fp = instance->frames[instance->depth].fp;
+        break;
+
+      case OP_CALL_INDIRECT: {
+        uint32_t slot = I32(*--sp);
+        uint32_t callee = slot < instance->table_size ? instance->table[slot] : WASM_NULL;
+        if (callee == WASM_NULL) {
+          wasm_trap("call through an empty table slot", NULL);
+        }
+        if (strcmp(m->types[m->funcs[callee].type].signature, m->types[insn->a].signature) != 0) {
+          wasm_trap("indirect call signature mismatch", NULL);
+        }
+        func = &m->funcs[callee];
+        goto call;
+      }
+      case OP_CALL:
+        func = &m->funcs[insn->a];
+      call:
+        type = &m->types[func->type];
+        if (func->import) {
+          m->stats.host_calls++;
+          instance->sp = sp;
+          func->import(instance, sp - type->params);
+          sp = sp - type->params + type->results;
+          memory_size = instance->memory_size;    // callbacks may have grown it
+          break;
+        }
+        if (instance->depth == WASM_MAX_FRAMES) {
+          wasm_trap("call stack exhausted", NULL);
+        }
+        instance->frames[instance->depth++] = (wasm_frame_t){.ip = ip, .fp = fp};
+        fp = sp - type->params;
+        goto enter;
+
+      case OP_DROP:
+        sp--;
+        break;
+      case OP_SELECT:
+        sp -= 2;
+        if (!I32(sp[1])) {
+          sp[-1] = sp[0];
+        }
+        break;
+      case OP_LOCAL_GET:
+        *sp++ = fp[insn->a];
+        break;
+      case OP_LOCAL_SET:
+        fp[insn->a] = *--sp;
+        break;
+      case OP_LOCAL_TEE:
+        fp[insn->a] = sp[-1];
+        break;
+      case OP_GLOBAL_GET:
+        *sp++ = instance->globals[insn->a];
+        break;
+      case OP_GLOBAL_SET:
+        instance->globals[insn->a] = *--sp;
+        break;
+
+      case 0x28: LOAD(uint32_t, 4, value)
+      case 0x29: LOAD(uint64_t, 8, value)
+      case 0x2a: LOAD(uint32_t, 4, value)
+      case 0x2b: LOAD(uint64_t, 8, value)
+      case 0x2c: LOAD(int8_t, 1, I32((int32_t)value))
+      case 0x2d: LOAD(uint8_t, 1, value)
+      case 0x2e: LOAD(int16_t, 2, I32((int32_t)value))
+      case 0x2f: LOAD(uint16_t, 2, value)
+      case 0x30: LOAD(int8_t, 1, I64((int64_t)value))
+      case 0x31: LOAD(uint8_t, 1, value)
+      case 0x32: LOAD(int16_t, 2, I64((int64_t)value))
+      case 0x33: LOAD(uint16_t, 2, value)
+      case 0x34: LOAD(int32_t, 4, I64((int64_t)value))
+      case 0x35: LOAD(uint32_t, 4, value)
+      case 0x36: STORE(uint32_t, 4)
+      case 0x37: STORE(uint64_t, 8)
+      case 0x38: STORE(uint32_t, 4)
+      case 0x39: STORE(uint64_t, 8)
+      case 0x3a: STORE(uint8_t, 1)
+      case 0x3b: STORE(uint16_t, 2)
+      case 0x3c: STORE(uint8_t, 1)
+      case 0x3d: STORE(uint16_t, 2)
+      case 0x3e: STORE(uint32_t, 4)
+
+      case OP_MEMORY_SIZE:
+        *sp++ = memory_size / WASM_PAGE;
+        break;
+      case OP_MEMORY_GROW: {
+        uint64_t pages = memory_size / WASM_PAGE, more = I32(sp[-1]);
+        if ((pages + more) * WASM_PAGE > instance->memory_reserved) {
+          sp[-1] = I32(-1);
+        } else {
+          sp[-1] = pages;
+          instance->memory_size = memory_size = (pages + more) * WASM_PAGE;
+        }
+        break;
+      }
+
+      case OP_I32_CONST:
+      case 0x42:
+      case 0x43:
+      case OP_F64_CONST:
+        *sp++ = insn->b;
+        break;
+
+      case 0x45: UNARY(I32(x) == 0)
+      case 0x46: BINARY(I32(x) == I32(y))
+      case 0x47: BINARY(I32(x) != I32(y))
+      case 0x48: BINARY(S32(x) < S32(y))
+      case 0x49: BINARY(I32(x) < I32(y))
+      case 0x4a: BINARY(S32(x) > S32(y))
+      case 0x4b: BINARY(I32(x) > I32(y))
+      case 0x4c: BINARY(S32(x) <= S32(y))
+      case 0x4d: BINARY(I32(x) <= I32(y))
+      case 0x4e: BINARY(S32(x) >= S32(y))
+      case 0x4f: BINARY(I32(x) >= I32(y))
+      case 0x50: UNARY(x == 0)
+      case 0x51: BINARY(x == y)
+      case 0x52: BINARY(x != y)
+      case 0x53: BINARY(S64(x) < S64(y))
+      case 0x54: BINARY(x < y)
+      case 0x55: BINARY(S64(x) > S64(y))
+      case 0x56: BINARY(x > y)
+      case 0x57: BINARY(S64(x) <= S64(y))
+      case 0x58: BINARY(x <= y)
+      case 0x59: BINARY(S64(x) >= S64(y))
+      case 0x5a: BINARY(x >= y)
+      case 0x5b: BINARY(as_f32(x) == as_f32(y))
+      case 0x5c: BINARY(as_f32(x) != as_f32(y))
+      case 0x5d: BINARY(as_f32(x) < as_f32(y))
+      case 0x5e: BINARY(as_f32(x) > as_f32(y))
+      case 0x5f: BINARY(as_f32(x) <= as_f32(y))
+      case 0x60: BINARY(as_f32(x) >= as_f32(y))
+      case 0x61: BINARY(as_f64(x) == as_f64(y))
+      case 0x62: BINARY(as_f64(x) != as_f64(y))
+      case 0x63: BINARY(as_f64(x) < as_f64(y))
+      case 0x64: BINARY(as_f64(x) > as_f64(y))
+      case 0x65: BINARY(as_f64(x) <= as_f64(y))
+      case 0x66: BINARY(as_f64(x) >= as_f64(y))
+
+      case 0x67: UNARY(I32(x) ? (uint64_t)__builtin_clz(I32(x)) : 32)
+      case 0x68: UNARY(I32(x) ? (uint64_t)__builtin_ctz(I32(x)) : 32)
+      case 0x69: UNARY((uint64_t)__builtin_popcount(I32(x)))
+      case 0x6a: BINARY(I32(x + y))
+      case 0x6b: BINARY(I32(x - y))
+      case 0x6c: BINARY(I32(I32(x) * I32(y)))
+      case 0x6d:
+      case 0x6f: {
+        int32_t y = S32(sp[-1]), x = S32(sp[-2]);
+        if (y == 0) {
+          wasm_trap("integer divide by zero", NULL);
+        }
+        if (y == -1 && x == INT32_MIN) {
+          if (insn->op == 0x6d) {
+            wasm_trap("integer overflow", NULL);
+          }
+          x = 0;
+          y = 1;
+        }
+        sp--;
+        sp[-1] = I32(insn->op == 0x6d ? x / y : x % y);
+        break;
+      }
+      case 0x6e:
+      case 0x70: {
+        uint32_t y = I32(sp[-1]), x = I32(sp[-2]);
+        if (y == 0) {
+          wasm_trap("integer divide by zero", NULL);
+        }
+        sp--;
+        sp[-1] = insn->op == 0x6e ? x / y : x % y;
+        break;
+      }
+      case 0x71: BINARY(I32(x & y))
+      case 0x72: BINARY(I32(x | y))
+      case 0x73: BINARY(I32(x ^ y))
+      case 0x74: BINARY(I32(I32(x) << (y & 31)))
+      case 0x75: BINARY(I32(S32(x) >> (y & 31)))
+      case 0x76: BINARY(I32(x) >> (y & 31))
+      case 0x77: BINARY(I32((I32(x) << (y & 31)) | (I32(x) >> ((32 - (y & 31)) & 31))))
+      case 0x78: BINARY(I32((I32(x) >> (y & 31)) | (I32(x) << ((32 - (y & 31)) & 31))))
+
+      case 0x79: UNARY(x ? (uint64_t)__builtin_clzll(x) : 64)
+      case 0x7a: UNARY(x ? (uint64_t)__builtin_ctzll(x) : 64)
+      case 0x7b: UNARY((uint64_t)__builtin_popcountll(x))
+      case 0x7c: BINARY(x + y)
+      case 0x7d: BINARY(x - y)
+      case 0x7e: BINARY(x * y)
+      case 0x7f:
+      case 0x81: {
+        int64_t y = S64(sp[-1]), x = S64(sp[-2]);
+        if (y == 0) {
+          wasm_trap("integer divide by zero", NULL);
+        }
+        if (y == -1 && x == INT64_MIN) {
+          if (insn->op == 0x7f) {
+            wasm_trap("integer overflow", NULL);
+          }
+          x = 0;
+          y = 1;
+        }
+        sp--;
+        sp[-1] = I64(insn->op == 0x7f ? x / y : x % y);
+        break;
+      }
+      case 0x80:
+      case 0x82: {
+        uint64_t y = sp[-1], x = sp[-2];
+        if (y == 0) {
+          wasm_trap("integer divide by zero", NULL);
+        }
+        sp--;
+        sp[-1] = insn->op == 0x80 ? x / y : x % y;
+        break;
+      }
+      case 0x83: BINARY(x & y)
+      case 0x84: BINARY(x | y)
+      case 0x85: BINARY(x ^ y)
+      case 0x86: BINARY(x << (y & 63))
+      case 0x87: BINARY(I64(S64(x) >> (y & 63)))
+      case 0x88: BINARY(x >> (y & 63))
+      case 0x89: BINARY((x << (y & 63)) | (x >> ((64 - (y & 63)) & 63)))
+      case 0x8a: BINARY((x >> (y & 63)) | (x << ((64 - (y & 63)) & 63)))
+
+      case 0x8b: UNARY(x & 0x7fffffffu)
+      case 0x8c: UNARY(I32(x ^ 0x80000000u))
+      case 0x8d: UNARY(from_f32(ceilf(as_f32(x))))
+      case 0x8e: UNARY(from_f32(floorf(as_f32(x))))
+      case 0x8f: UNARY(from_f32(truncf(as_f32(x))))
+      case 0x90: UNARY(from_f32(nearbyintf(as_f32(x))))
+      case 0x91: UNARY(from_f32(sqrtf(as_f32(x))))
+      case 0x92: BINARY(from_f32(as_f32(x) + as_f32(y)))
+      case 0x93: BINARY(from_f32(as_f32(x) - as_f32(y)))
+      case 0x94: BINARY(from_f32(as_f32(x) * as_f32(y)))
+      case 0x95: BINARY(from_f32(as_f32(x) / as_f32(y)))
+      case 0x96: BINARY(from_f32(min_f32(as_f32(x), as_f32(y))))
+      case 0x97: BINARY(from_f32(max_f32(as_f32(x), as_f32(y))))
+      case 0x98: BINARY((x & 0x7fffffffu) | (y & 0x80000000u))
+
+      case 0x99: UNARY(x & 0x7fffffffffffffffull)
+      case 0x9a: UNARY(x ^ 0x8000000000000000ull)
+      case 0x9b: UNARY(from_f64(ceil(as_f64(x))))
+      case 0x9c: UNARY(from_f64(floor(as_f64(x))))
+      case 0x9d: UNARY(from_f64(trunc(as_f64(x))))
+      case 0x9e: UNARY(from_f64(nearbyint(as_f64(x))))
+      case 0x9f: UNARY(from_f64(sqrt(as_f64(x))))
+      case 0xa0: BINARY(from_f64(as_f64(x) + as_f64(y)))
+      case 0xa1: BINARY(from_f64(as_f64(x) - as_f64(y)))
+      case 0xa2: BINARY(from_f64(as_f64(x) * as_f64(y)))
+      case 0xa3: BINARY(from_f64(as_f64(x) / as_f64(y)))
+      case 0xa4: BINARY(from_f64(min_f64(as_f64(x), as_f64(y))))
+      case 0xa5: BINARY(from_f64(max_f64(as_f64(x), as_f64(y))))
+      case 0xa6: BINARY((x & 0x7fffffffffffffffull) | (y & 0x8000000000000000ull))
+
+      case 0xa7: UNARY(I32(x))
+      case 0xa8: UNARY(truncate(as_f32(x), 0, false))
+      case 0xa9: UNARY(truncate(as_f32(x), 1, false))
+      case 0xaa: UNARY(truncate(as_f64(x), 0, false))
+      case 0xab: UNARY(truncate(as_f64(x), 1, false))
+      case 0xac: UNARY(I64((int64_t)S32(x)))
+      case 0xad: UNARY(I32(x))
+      case 0xae: UNARY(truncate(as_f32(x), 2, false))
+      case 0xaf: UNARY(truncate(as_f32(x), 3, false))
+      case 0xb0: UNARY(truncate(as_f64(x), 2, false))
+      case 0xb1: UNARY(truncate(as_f64(x), 3, false))
+      case 0xb2: UNARY(from_f32((float)S32(x)))
+      case 0xb3: UNARY(from_f32((float)I32(x)))
+      case 0xb4: UNARY(from_f32((float)S64(x)))
+      case 0xb5: UNARY(from_f32((float)x))
+      case 0xb6: UNARY(from_f32((float)as_f64(x)))
+      case 0xb7: UNARY(from_f64((double)S32(x)))
+      case 0xb8: UNARY(from_f64((double)I32(x)))
+      case 0xb9: UNARY(from_f64((double)S64(x)))
+      case 0xba: UNARY(from_f64((double)x))
+      case 0xbb: UNARY(from_f64((double)as_f32(x)))
+      case 0xbc: UNARY(I32(x))
+      case 0xbd: UNARY(x)
+      case 0xbe: UNARY(I32(x))
+      case 0xbf: UNARY(x)
+      case 0xc0: UNARY(I32((int32_t)(int8_t)x))
+      case 0xc1: UNARY(I32((int32_t)(int16_t)x))
+      case 0xc2: UNARY(I64((int64_t)(int8_t)x))
+      case 0xc3: UNARY(I64((int64_t)(int16_t)x))
+      case 0xc4: UNARY(I64((int64_t)(int32_t)x))
+
+      case OP_TRUNC_SAT + 0: UNARY(truncate(as_f32(x), 0, true))
+      case OP_TRUNC_SAT + 1: UNARY(truncate(as_f32(x), 1, true))
+      case OP_TRUNC_SAT + 2: UNARY(truncate(as_f64(x), 0, true))
+      case OP_TRUNC_SAT + 3: UNARY(truncate(as_f64(x), 1, true))
+      case OP_TRUNC_SAT + 4: UNARY(truncate(as_f32(x), 2, true))
+      case OP_TRUNC_SAT + 5: UNARY(truncate(as_f32(x), 3, true))
+      case OP_TRUNC_SAT + 6: UNARY(truncate(as_f64(x), 2, true))
+      case OP_TRUNC_SAT + 7: UNARY(truncate(as_f64(x), 3, true))
+
+      case OP_MEMORY_INIT:
+      case OP_MEMORY_COPY:
+      case OP_MEMORY_FILL: {
+        uint64_t to = I32(sp[-3]), from = I32(sp[-2]), n = I32(sp[-1]);
+        sp -= 3;
+        if (to + n > memory_size) {
+          wasm_trap("out of bounds memory access", NULL);
+        }
+        if (insn->op == OP_MEMORY_FILL) {
+          memset(memory + to, (uint8_t)from, n);
+        } else if (insn->op == OP_MEMORY_COPY) {
+          if (from + n > memory_size) {
+            wasm_trap("out of bounds memory access", NULL);
+          }
+          memmove(memory + to, memory + from, n);
+        } else {
+          const wasm_data_t *data = &m->data[insn->a];
+          uint64_t size = instance->data_dropped[insn->a] ? 0 : data->size;
+          if (from + n > size) {
+            wasm_trap("out of bounds memory access", NULL);
+          }
+          memcpy(memory + to, data->bytes + from, n);
+        }
+        break;
+      }
+      case OP_DATA_DROP:
+        instance->data_dropped[insn->a] = true;
+        break;
+
+      default:
+        wasm_trap("bad instruction", NULL);
+        break;
+    }
+  }
+}
+
+// Imports
+
+static void *memory_at(wasm_instance_t *instance, uint32_t address, uint64_t size) {
+  if ((uint64_t)address + size > instance->memory_size) {
+    wasm_trap("import argument out of bounds", NULL);
+  }
+  return instance->memory + address;
+}
+
+// A chip pointer that may be NULL, as the simulator accepts for callbacks'
+// buffers
+static void *optional_at(wasm_instance_t *instance, uint32_t address, uint64_t size) {
+  return address ? memory_at(instance, address, size) : NULL;
+}
+
+static const char *string_at(wasm_instance_t *instance, uint32_t address) {
+  if (address >= instance->memory_size ||
+      !memchr(instance->memory + address, 0, instance->memory_size - address)) {
+    wasm_trap("import string out of bounds", NULL);
+  }
+  return (const char *)instance->memory + address;
+}
+
+static uint32_t load_u32(wasm_instance_t *instance, uint32_t address) {
+  uint32_t value;
+  memcpy(&value, memory_at(instance, address, 4), 4);
+  return value;
+}
+
+static void store_u32(wasm_instance_t *instance, uint32_t address, uint32_t value) {
+  memcpy(memory_at(instance, address, 4), &value, 4);
+}
+
+static wasm_bridge_t *bridge(wasm_instance_t *instance, uint32_t user_data) {
+  wasm_bridge_t *b = calloc(1, sizeof(*b));
+  if (!b) {
+    wasm_trap("out of memory", NULL);
+  }
+  b->instance = instance;
+  b->user_data = user_data;
+  b->next = instance->bridges;
+  instance->bridges = b;
+  return b;
+}
+
+// Call the chip function a config struct named, args after user_data
+static uint64_t call_back(const wasm_bridge_t *b, unsigned which, const char *signature,
+                          const uint64_t *args, uint32_t count) {
+  wasm_instance_t *instance = b->instance;
+  host_wasm_module_t *m = instance->module;
+  uint32_t slot = b->callbacks[which];
+  uint32_t func = slot < instance->table_size ? instance->table[slot] : WASM_NULL;
+  if (func == WASM_NULL) {
+    wasm_trap("callback through an empty table slot", NULL);
+  }
+  if (strcmp(m->types[m->funcs[func].type].signature, signature) != 0) {
+    wasm_trap("callback signature mismatch", signature);
+  }
+  uint64_t *sp = instance->sp;
+  if (sp + 1 + count > instance->stack_end) {
+    wasm_trap("call stack exhausted", NULL);
+  }
+  sp[0] = b->user_data;
+  for (uint32_t i = 0; i < count; i++) {
+    sp[1 + i] = args[i];
+  }
+  instance->sp = sp + 1 + count;
+  m->stats.entries++;
+  execute(instance, func);
+  uint64_t result = instance->sp > sp ? sp[0] : 0;
+  instance->sp = sp;
+  return result;
+}
+
+static void timer_callback(void *user_data) {
+  call_back(user_data, 0, "i:", NULL, 0);
+}
+
+static void pin_change_callback(void *user_data, pin_t pin, uint32_t value) {
+  uint64_t args[] = {I32(pin), value};
+  call_back(user_data, 0, "iii:", args, 2);
+}
+
+static bool i2c_connect_callback(void *user_data, uint32_t address, bool read) {
+  uint64_t args[] = {address, read};
+  return I32(call_back(user_data, 0, "iii:i", args, 2)) != 0;
+}
+
+static uint8_t i2c_read_callback(void *user_data) {
+  return (uint8_t)call_back(user_data, 1, "i:i", NULL, 0);
+}
+
+static bool i2c_write_callback(void *user_data, uint8_t data) {
+  uint64_t args[] = {data};
+  return I32(call_back(user_data, 2, "ii:i", args, 1)) != 0;
+}
+
+static void i2c_disconnect_callback(void *user_data) {
+  call_back(user_data, 3, "i:", NULL, 0);
+}
+
+static void uart_rx_callback(void *user_data, uint8_t byte) {
+  uint64_t args[] = {byte};
+  call_back(user_data, 0, "ii:", args, 1);
+}
+
+static void uart_write_done_callback(void *user_data) {
+  call_back(user_data, 1, "i:", NULL, 0);
+}
+
+static void spi_done_callback(void *user_data, uint8_t *buffer, uint32_t count) {
+  const wasm_bridge_t *b = user_data;
+  uint64_t args[] = {buffer ? (uint64_t)(buffer - b->instance->memory) : 0, count};
+  call_back(b, 0, "iii:", args, 2);
+}
+
+static void import_pin_init(wasm_instance_t *in, uint64_t *a) {
+  a[0] = I32(pin_init(string_at(in, I32(a[0])), I32(a[1])));
+}
+
+static void import_pin_read(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = pin_read(S32(a[0]));
+}
+
+static void import_pin_write(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  pin_write(S32(a[0]), I32(a[1]));
+}
+
+static void import_pin_watch(wasm_instance_t *in, uint64_t *a) {
+  uint32_t config = I32(a[1]);
+  wasm_bridge_t *b = bridge(in, load_u32(in, config));
+  b->callbacks[0] = load_u32(in, config + 8);
+  pin_watch_config_t native = {
+    .user_data = b,
+    .edge = load_u32(in, config + 4),
+    .pin_change = b->callbacks[0] ? pin_change_callback : NULL,
+  };
+  a[0] = pin_watch(S32(a[0]), &native);
+}
+
+static void import_pin_watch_stop(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  pin_watch_stop(S32(a[0]));
+}
+
+static void import_pin_mode(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  pin_mode(S32(a[0]), I32(a[1]));
+}
+
+static void import_pin_adc_read(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = from_f32(pin_adc_read(S32(a[0])));
+}
+
+static void import_pin_dac_write(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = from_f32(pin_dac_write(S32(a[0]), as_f32(a[1])));
+}
+
+static void import_string_get_length(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = string_get_length(I32(a[0]));
+}
+
+static void import_string_read(wasm_instance_t *in, uint64_t *a) {
+  a[0] = string_read(I32(a[0]), memory_at(in, I32(a[1]), I32(a[2])), I32(a[2]));
+}
+
+static void import_attr_init(wasm_instance_t *in, uint64_t *a) {
+  a[0] = attr_init(string_at(in, I32(a[0])), I32(a[1]));
+}
+
+static void import_attr_init_float(wasm_instance_t *in, uint64_t *a) {
+  a[0] = attr_init_float(string_at(in, I32(a[0])), as_f32(a[1]));
+}
+
+static void import_attr_read(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = attr_read(I32(a[0]));
+}
+
+static void import_attr_read_float(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = from_f32(attr_read_float(I32(a[0])));
+}
+
+static void import_attr_string_init(wasm_instance_t *in, uint64_t *a) {
+  a[0] = attr_string_init(string_at(in, I32(a[0])));
+}
+
+static void import_i2c_init(wasm_instance_t *in, uint64_t *a) {
+  uint32_t config = I32(a[0]);
+  wasm_bridge_t *b = bridge(in, load_u32(in, config));
+  for (unsigned i = 0; i < 4; i++) {
+    b->callbacks[i] = load_u32(in, config + 16 + 4 * i);
+  }
+  i2c_config_t native = {
+    .user_data = b,
+    .address = load_u32(in, config + 4),
+    .scl = (pin_t)load_u32(in, config + 8),
+    .sda = (pin_t)load_u32(in, config + 12),
+    .connect = i2c_connect_callback,
+    .read = i2c_read_callback,
+    .write = i2c_write_callback,
+    .disconnect = i2c_disconnect_callback,
+  };
+  a[0] = i2c_init(&native);
+}
+
+static void import_uart_init(wasm_instance_t *in, uint64_t *a) {
+  uint32_t config = I32(a[0]);
+  wasm_bridge_t *b = bridge(in, load_u32(in, config));
+  b->callbacks[0] = load_u32(in, config + 16);
+  b->callbacks[1] = load_u32(in, config + 20);
+  uart_config_t native = {
+    .user_data = b,
+    .rx = (pin_t)load_u32(in, config + 4),
+    .tx = (pin_t)load_u32(in, config + 8),
+    .baud_rate = load_u32(in, config + 12),
+    .rx_data = b->callbacks[0] ? uart_rx_callback : NULL,
+    .write_done = b->callbacks[1] ? uart_write_done_callback : NULL,
+  };
+  a[0] = uart_init(&native);
+}
+
+static void import_uart_write(wasm_instance_t *in, uint64_t *a) {
+  a[0] = uart_write(I32(a[0]), memory_at(in, I32(a[1]), I32(a[2])), I32(a[2]));
+}
+
+static void import_spi_init(wasm_instance_t *in, uint64_t *a) {
+  uint32_t config = I32(a[0]);
+  wasm_bridge_t *b = bridge(in, load_u32(in, config));
+  b->callbacks[0] = load_u32(in, config + 20);
+  spi_config_t native = {
+    .user_data = b,
+    .sck = (pin_t)load_u32(in, config + 4),
+    .mosi = (pin_t)load_u32(in, config + 8),
+    .miso = (pin_t)load_u32(in, config + 12),
+    .mode = load_u32(in, config + 16),
+    .done = b->callbacks[0] ? spi_done_callback : NULL,
+  };
+  a[0] = spi_init(&native);
+}
+
+static void import_spi_start(wasm_instance_t *in, uint64_t *a) {
+  spi_start(I32(a[0]), memory_at(in, I32(a[1]), I32(a[2])), I32(a[2]));
+}
+
+static void import_spi_stop(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  spi_stop(I32(a[0]));
+}
+
+static void import_timer_init(wasm_instance_t *in, uint64_t *a) {
+  uint32_t config = I32(a[0]);
+  wasm_bridge_t *b = bridge(in, load_u32(in, config));
+  b->callbacks[0] = load_u32(in, config + 4);
+  timer_config_t native = {.user_data = b, .callback = timer_callback};
+  a[0] = timer_init(&native);
+}
+
+static void import_timer_start(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  timer_start(I32(a[0]), I32(a[1]), I32(a[2]) != 0);
+}
+
+static void import_timer_start_ns(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  timer_start_ns_d(I32(a[0]), as_f64(a[1]), I32(a[2]) != 0);
+}
+
+static void import_timer_stop(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  timer_stop(I32(a[0]));
+}
+
+static void import_get_sim_nanos(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = from_f64(get_sim_nanos_d());
+}
+
+static void import_framebuffer_init(wasm_instance_t *in, uint64_t *a) {
+  uint32_t width, height;
+  memory_at(in, I32(a[0]), 4);
+  memory_at(in, I32(a[1]), 4);
+  buffer_t buffer = framebuffer_init(&width, &height);
+  store_u32(in, I32(a[0]), width);
+  store_u32(in, I32(a[1]), height);
+  a[0] = buffer;
+}
+
+static void import_buffer_read(wasm_instance_t *in, uint64_t *a) {
+  buffer_read(I32(a[0]), I32(a[1]), memory_at(in, I32(a[2]), I32(a[3])), I32(a[3]));
+}
+
+static void import_buffer_write(wasm_instance_t *in, uint64_t *a) {
+  buffer_write(I32(a[0]), I32(a[1]), memory_at(in, I32(a[2]), I32(a[3])), I32(a[3]));
+}
+
+// MCU addresses are the MCU's, not pointers into the chip's memory
+static void import_symbol_resolve(wasm_instance_t *in, uint64_t *a) {
+  a[0] = I32((uintptr_t)_symbol_resolve((char *)string_at(in, I32(a[0]))));
+}
+
+static void import_mcu_read_memory(wasm_instance_t *in, uint64_t *a) {
+  a[0] = _mcu_read_memory((const void *)(uintptr_t)I32(a[0]), memory_at(in, I32(a[1]), I32(a[2])), I32(a[2]));
+}
+
+static void import_mcu_read_uint32(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = _mcu_read_uint32((const void *)(uintptr_t)I32(a[0]));
+}
+
+static void import_mcu_read_pc(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = _mcu_read_pc();
+}
+
+static void import_mcu_read_sp(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = _mcu_read_sp();
+}
+
+// The native host has no MCU whose stack could call back, so the config's
+// callback is not bridged
+static void import_mcu_monitor_sp(wasm_instance_t *in, uint64_t *a) {
+  memory_at(in, I32(a[0]), 12);
+  a[0] = _mcu_monitor_sp(NULL);
+}
+
+// WASI, for libc's printf to stdout and the clock chip-probe.h times with
+static void import_fd_write(wasm_instance_t *in, uint64_t *a) {
+  uint32_t fd = I32(a[0]), iovs = I32(a[1]), count = I32(a[2]), total = 0;
+  FILE *out = fd == 1 ? stdout : fd == 2 ? stderr : NULL;
+  if (!out) {
+    a[0] = 8;  // EBADF
+    return;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t base = load_u32(in, iovs + 8 * i), length = load_u32(in, iovs + 8 * i + 4);
+    total += (uint32_t)fwrite(memory_at(in, base, length), 1, length, out);
+  }
+  store_u32(in, I32(a[3]), total);
+  a[0] = 0;
+}
+
+static void import_fd_fdstat_get(wasm_instance_t *in, uint64_t *a) {
+  if (I32(a[0]) > 2) {
+    a[0] = 8;
+    return;
+  }
+  uint8_t *stat = memory_at(in, I32(a[1]), 24);
+  memset(stat, 0, 24);
+  stat[0] = 2;  // character device, so libc line-buffers stdout
+  memset(stat + 8, 0xff, 16);
+  a[0] = 0;
+}
+
+static void import_clock_time_get(wasm_instance_t *in, uint64_t *a) {
+  struct timespec ts;
+  if (clock_gettime(I32(a[0]) == 0 ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts) != 0) {
+    a[0] = 28;  // EINVAL
+    return;
+  }
+  uint64_t ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+  memcpy(memory_at(in, I32(a[2]), 8), &ns, 8);
+  a[0] = 0;
+}
+
+static void import_fd_seek(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = 70;  // ESPIPE
+}
+
+static void import_fd_close(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  a[0] = 0;
+}
+
+static void import_sizes_get(wasm_instance_t *in, uint64_t *a) {
+  store_u32(in, I32(a[0]), 0);
+  store_u32(in, I32(a[1]), 0);
+  a[0] = 0;
+}
+
+static void import_proc_exit(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  (void)a;
+  wasm_trap("proc_exit called", NULL);
+}
+
+typedef struct {
+  const char *module;
+  const char *name;
+  const char *signature;
+  wasm_import_t import;
+} wasm_binding_t;
+
+static const wasm_binding_t bindings[] = {
+  {"env", "pinInit", "ii:i", import_pin_init},
+  {"env", "pinRead", "i:i", import_pin_read},
+  {"env", "pinWrite", "ii:", import_pin_write},
+  {"env", "pinWatch", "ii:i", import_pin_watch},
+  {"env", "pinWatchStop", "i:", import_pin_watch_stop},
+  {"env", "pinMode", "ii:", import_pin_mode},
+  {"env", "pinADCRead", "i:f", import_pin_adc_read},
+  {"env", "pinDACWrite", "if:f", import_pin_dac_write},
+  {"env", "stringGetLength", "i:i", import_string_get_length},
+  {"env", "stringRead", "iii:i", import_string_read},
+  {"env", "attrInit", "ii:i", import_attr_init},
+  {"env", "attrInitFloat", "if:i", import_attr_init_float},
+  {"env", "attrRead", "i:i", import_attr_read},
+  {"env", "attrReadFloat", "i:f", import_attr_read_float},
+  {"env", "attrStringInit", "i:i", import_attr_string_init},
+  {"env", "i2cInit", "i:i", import_i2c_init},
+  {"env", "uartInit", "i:i", import_uart_init},
+  {"env", "uartWrite", "iii:i", import_uart_write},
+  {"env", "spiInit", "i:i", import_spi_init},
+  {"env", "spiStart", "iii:", import_spi_start},
+  {"env", "spiStop", "i:", import_spi_stop},
+  {"env", "timerInit", "i:i", import_timer_init},
+  {"env", "timerStart", "iii:", import_timer_start},
+  {"env", "timerStartNanos", "iFi:", import_timer_start_ns},
+  {"env", "timerStop", "i:", import_timer_stop},
+  {"env", "getSimNanos", ":F", import_get_sim_nanos},
+  {"env", "framebufferInit", "ii:i", import_framebuffer_init},
+  {"env", "bufferRead", "iiii:", import_buffer_read},
+  {"env", "bufferWrite", "iiii:", import_buffer_write},
+  {"env", "_symbolResolve", "i:i", import_symbol_resolve},
+  {"env", "_mcuReadMemory", "iii:i", import_mcu_read_memory},
+  {"env", "_mcuReadUint32", "i:i", import_mcu_read_uint32},
+  {"env", "_mcuReadPC", ":i", import_mcu_read_pc},
+  {"env", "_mcuReadSP", ":i", import_mcu_read_sp},
+  {"env", "_mcuMonitorSP", "i:i", import_mcu_monitor_sp},
+  {"wasi_snapshot_preview1", "fd_write", "iiii:i", import_fd_write},
+  {"wasi_snapshot_preview1", "fd_fdstat_get", "ii:i", import_fd_fdstat_get},
+  {"wasi_snapshot_preview1", "fd_seek", "iIii:i", import_fd_seek},
+  {"wasi_snapshot_preview1", "clock_time_get", "iIi:i", import_clock_time_get},
+  {"wasi_snapshot_preview1", "fd_close", "i:i", import_fd_close},
+  {"wasi_snapshot_preview1", "environ_sizes_get", "ii:i", import_sizes_get},
+  {"wasi_snapshot_preview1", "args_sizes_get", "ii:i", import_sizes_get},
+  {"wasi_snapshot_preview1", "proc_exit", "i:", import_proc_exit},
+};
+
+static void import_missing(wasm_instance_t *in, uint64_t *a) {
+  (void)in;
+  (void)a;
+  wasm_trap("call of an import the native host does not provide", NULL);
+}
+
+static wasm_import_t find_binding(const char *module, const char *name, const char *signature, bool *mismatch) {
+  for (size_t i = 0; i < sizeof(bindings) / sizeof(bindings[0]); i++) {
+    if (strcmp(bindings[i].module, module) == 0 && strcmp(bindings[i].name, name) == 0) {
+      *mismatch = strcmp(bindings[i].signature, signature) != 0;
+      return bindings[i].import;
+    }
+  }
+  // Linked but never called is fine, as in the simulator
+  return import_missing;
+}
+
+// Instances
+
+static wasm_instance_t *instantiate(host_wasm_module_t *m) {
+  wasm_instance_t *in = calloc(1, sizeof(*in));
+  uint32_t max_pages = m->memory_max != UINT32_MAX ? m->memory_max : WASM_DEFAULT_MAX_PAGES;
+  max_pages = max_pages < m->memory_min ? m->memory_min : max_pages;
+  if (!in) {
+    wasm_trap("out of memory", NULL);
+  }
+  in->module = m;
+  if (m->has_memory) {
+    in->memory_reserved = (uint64_t)max_pages * WASM_PAGE;
+    in->memory_size = (uint64_t)m->memory_min * WASM_PAGE;
+    in->memory = mmap(NULL, in->memory_reserved ? in->memory_reserved : WASM_PAGE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (in->memory == MAP_FAILED) {
+      wasm_trap("cannot map linear memory", NULL);
+    }
+  }
+  in->globals = calloc(m->global_count ? m->global_count : 1, sizeof(*in->globals));
+  in->data_dropped = calloc(m->data_count ? m->data_count : 1, sizeof(*in->data_dropped));
+  in->table_size = m->table_min;
+  in->table = malloc((in->table_size ? in->table_size : 1) * sizeof(*in->table));
+  in->stack = malloc(WASM_STACK_SLOTS * sizeof(*in->stack));
+  in->frames = malloc(WASM_MAX_FRAMES * sizeof(*in->frames));
+  if (!in->globals || !in->data_dropped || !in->table || !in->stack || !in->frames) {
+    wasm_trap("out of memory", NULL);
+  }
+  in->stack_end = in->stack + WASM_STACK_SLOTS;
+  in->sp = in->stack;
+  for (uint32_t i = 0; i < m->global_count; i++) {
+    in->globals[i] = m->globals[i].value;
+  }
+  for (uint32_t i = 0; i < in->table_size; i++) {
+    in->table[i] = WASM_NULL;
+  }
+  for (uint32_t i = 0; i < m->elem_count; i++) {
+    const wasm_elem_t *elem = &m->elems[i];
+    if (!elem->active) {
+      continue;
+    }
+    if ((uint64_t)elem->offset + elem->count > in->table_size) {
+      wasm_trap("element segment out of table bounds", NULL);
+    }
+    memcpy(in->table + elem->offset, elem->funcs, elem->count * sizeof(*elem->funcs));
+  }
+  for (uint32_t i = 0; i < m->data_count; i++) {
+    const wasm_data_t *data = &m->data[i];
+    if (!data->active) {
+      continue;
+    }
+    if ((uint64_t)data->offset + data->size > in->memory_size) {
+      wasm_trap("data segment out of memory bounds", NULL);
+    }
+    memcpy(in->memory + data->offset, data->bytes, data->size);
+    in->data_dropped[i] = true;
+  }
+
+  m->instances = realloc(m->instances, (m->instance_count + 1) * sizeof(*m->instances));
+  if (!m->instances) {
+    wasm_trap("out of memory", NULL);
+  }
+  m->instances[m->instance_count++] = in;
+  return in;
+}
+
+static uint32_t find_export(const host_wasm_module_t *m, const char *name) {
+  for (uint32_t i = 0; i < m->export_count; i++) {
+    if (m->exports[i].kind == 0 && strcmp(m->exports[i].name, name) == 0) {
+      return m->exports[i].index;
+    }
+  }
+  return WASM_NULL;
+}
+
+static uint64_t call_export(wasm_instance_t *in, uint32_t func, const uint64_t *args, uint32_t count) {
+  host_wasm_module_t *m = in->module;
+  const wasm_type_t *type = &m->types[m->funcs[func].type];
+  if (count != type->params) {
+    wasm_trap("wrong number of arguments", m->funcs[func].import_name);
+  }
+  uint64_t *sp = in->sp;
+  for (uint32_t i = 0; i < count; i++) {
+    sp[i] = args[i];
+  }
+  in->sp = sp + count;
+  m->stats.entries++;
+  execute(in, func);
+  uint64_t result = type->results ? sp[0] : 0;
+  in->sp = sp;
+  return result;
+}
+
+void host_wasm_chip_init(host_wasm_module_t *m) {
+  uint32_t init = find_export(m, "chipInit");
+  if (init == WASM_NULL) {
+    wasm_trap("module exports no chipInit", NULL);
+  }
+  wasm_instance_t *in = instantiate(m);
+  uint32_t initialize = find_export(m, "_initialize");
+  if (initialize != WASM_NULL) {
+    call_export(in, initialize, NULL, 0);
+  }
+  call_export(in, init, NULL, 0);
+}
+
+uint64_t host_wasm_call(host_wasm_module_t *m, const char *name, const uint64_t *args, uint32_t count) {
+  uint32_t func = find_export(m, name);
+  if (func == WASM_NULL || m->instance_count == 0) {
+    wasm_trap("no such export in an instance", name);
+  }
+  return call_export(m->instances[m->instance_count - 1], func, args, count);
+}
+
+const host_wasm_stats_t *host_wasm_stats(const host_wasm_module_t *m) {
+  return &m->stats;
+}
+
+void host_wasm_free(host_wasm_module_t *m) {
+  if (!m) {
+    return;
+  }
+  for (uint32_t i = 0; i < m->instance_count; i++) {
+    wasm_instance_t *in = m->instances[i];
+    while (in->bridges) {
+      wasm_bridge_t *next = in->bridges->next;
+      free(in->bridges);
+      in->bridges = next;
+    }
+    if (in->memory) {
+      munmap(in->memory, in->memory_reserved ? in->memory_reserved : WASM_PAGE);
+    }
+    free(in->globals);
+    free(in->data_dropped);
+    free(in->table);
+    free(in->stack);
+    free(in->frames);
+    free(in);
+  }
+  for (uint32_t i = 0; i < m->type_count; i++) {
+    free(m->types[i].signature);
+  }
+  for (uint32_t i = 0; i < m->func_count; i++) {
+    free(m->funcs[i].import_name);
+  }
+  for (uint32_t i = 0; i < m->export_count; i++) {
+    free(m->exports[i].name);
+  }
+  for (uint32_t i = 0; i < m->elem_count; i++) {
+    free(m->elems[i].funcs);
+  }
+  free(m->instances);
+  free(m->types);
+  free(m->funcs);
+  free(m->globals);
+  free(m->exports);
+  free(m->elems);
+  free(m->data);
+  free(m->code);
+  free(m->branches);
+  free(m->bytes);
+  free(m);
+}
@@ -0,0 +1,60 @@
+/*
+ * WebAssembly runtime for shipped chip binaries
+ *
+ * Loads a chip as the simulator gets it, the .chip.wasm the Makefile links
+ * with --import-memory, --export-table and --no-entry, and runs it on the
+ * native host: the module's env imports are bound to the wokwi-api.h
+ * functions of wokwi-host.c (pointers translated into the chip's linear
+ * memory, callbacks routed through the exported function table) and the
+ * few WASI calls libc makes for printf to stdout and the clock. Native and
+ * wasm runs of the same chip can then be compared import call for import
+ * call.
+ *
+ *   host_wasm_module_t *chip = host_wasm_load("dist/a3144.chip.wasm", error, sizeof(error));
+ *   host_reset();
+ *   host_wasm_chip_init(chip);          // instead of chip_init()
+ *   host_run_for(HOST_SEC(1));
+ *   host_reset();
+ *   host_wasm_free(chip);
+ *
+ * Each host_wasm_chip_init() instantiates the module afresh, with its own
+ * memory, globals and table, like every chip in a diagram gets its own
+ * instance. Execution is a plain interpreter over code predecoded at load
+ * time, counting the wasm instructions it runs. Traps are fatal, like the
+ * host's own errors. A module and its instances belong to one thread.
+ */
+
+#ifndef WOKWI_WASM_H
+#define WOKWI_WASM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct host_wasm_module host_wasm_module_t;
+
+typedef struct {
+  uint64_t instructions;   // wasm instructions executed
+  uint64_t host_calls;     // calls to imported functions
+  uint64_t entries;        // calls into the chip: chipInit, callbacks, host_wasm_call
+} host_wasm_stats_t;
+
+// Load and predecode a module, NULL with a message in error if it is not
+// one this runtime can run
+host_wasm_module_t *host_wasm_load(const char *path, char *error, size_t error_size);
+host_wasm_module_t *host_wasm_load_bytes(const uint8_t *bytes, size_t size, char *error, size_t error_size);
+
+// Instantiate the module for the selected host instance and call its
+// chipInit export (and _initialize first, if there is one)
+void host_wasm_chip_init(host_wasm_module_t *module);
+
+// Call an export of the most recent instance with integer arguments,
+// returns its result (0 if none)
+uint64_t host_wasm_call(host_wasm_module_t *module, const char *name, const uint64_t *args, uint32_t count);
+
+const host_wasm_stats_t *host_wasm_stats(const host_wasm_module_t *module);
+
+// Free the module and its instances. The host holds pointers into their
+// memory (pin and attribute names), so host_reset() first.
+void host_wasm_free(host_wasm_module_t *module);
+
+#endif /* WOKWI_WASM_H */
@@ -0,0 +1,101 @@
+/*
+ * A3144 profiling driver
+ *
+ * Runs a sensor bank under load for N simulated seconds, for perf record
+ * on the native-profile build (make native-profile):
+ *   perf record -g build/profile/a3144 60
+ *   perf report --no-children
+ * Each instance polls at the 250 us floor, and every 100 us one of them,
+ * picked at random, sees the field jump somewhere in 0..100 mT, so most
+ * polls run update_output() on a field that just moved. Every 5 s VCC of
+ * one instance drops for 10 ms, which covers power_off()/power_on().
+ *
+ * Usage: a3144 [seconds] [instances]   (default 60 s, 64 instances)
+ * Prints simulated and wall time, callbacks and OUT edges when done.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wokwi-host.h"
+
+void chip_init(void);
+
+#define DEFAULT_SECONDS 60
+#define DEFAULT_INSTANCES 64
+#define MOVE_EVERY_NS HOST_US(100)
+#define VCC_EVERY_NS HOST_SEC(5)
+#define VCC_DROP_NS HOST_MS(10)
+
+static double wall_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint32_t parse_arg(const char *arg, uint32_t max) {
+  char *end;
+  unsigned long value = strtoul(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || value == 0 || value > max) {
+    fprintf(stderr, "usage: a3144 [seconds] [instances], instances up to %u\n", A3144_MAX_INSTANCES);
+    exit(2);
+  }
+  return (uint32_t)value;
+}
+
+int main(int argc, char **argv) {
+  uint32_t seconds = argc > 1 ? parse_arg(argv[1], UINT32_MAX / 1000) : DEFAULT_SECONDS;
+  uint32_t instances = argc > 2 ? parse_arg(argv[2], A3144_MAX_INSTANCES) : DEFAULT_INSTANCES;
+
+  // Chip diagnostics go to stdout; keep them out of the report
+  FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+  if (!report || !freopen("/dev/null", "w", stdout)) {
+    return 1;
+  }
+
+  host_reset();
+  for (uint32_t i = 0; i < instances; i++) {
+    if (i > 0) {
+      host_instance_new();
+    }
+    host_attr_set("pollMaxMicros", 250);
+    chip_init();
+  }
+
+  double begin = wall_seconds();
+  uint32_t lcg = 12345;
+  uint32_t powered_down = 0;
+  for (uint64_t t = MOVE_EVERY_NS; t <= HOST_SEC(seconds); t += MOVE_EVERY_NS) {
+    host_run_until(t);
+    lcg = lcg * 1103515245u + 12345u;
+    host_instance_select((lcg >> 8) % instances);
+    host_attr_set("magneticField", (lcg >> 16) % 101);
+    if (t % VCC_EVERY_NS == 0) {
+      powered_down = (lcg >> 4) % instances;
+      host_instance_select(powered_down);
+      host_pin_set("VCC", 0);
+    } else if (t % VCC_EVERY_NS == VCC_DROP_NS) {
+      host_instance_select(powered_down);
+      host_pin_set("VCC", 1);
+    }
+  }
+  double elapsed = wall_seconds() - begin;
+
+  const host_counters_t *counters = host_counters();
+  uint64_t edges = 0;
+  for (uint32_t i = 0; i < instances; i++) {
+    host_instance_select(i);
+    edges += host_pin_edges("OUT");
+  }
+  fprintf(report, "a3144: %u instances, %u s simulated in %.2f s wall\n", instances, seconds, elapsed);
+  fprintf(report, "  %lu callbacks, %.1f ns each, %lu imports, %lu OUT edges\n",
+          (unsigned long)counters->callbacks, elapsed * 1e9 / (double)counters->callbacks,
+          (unsigned long)host_import_calls(counters), (unsigned long)edges);
+  fclose(report);
+  host_release();
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Size report for chip WASM modules
+ *
+ * Breaks each module down by section and checks it against a byte budget:
+ *   wasm-size dist/a3144.chip.wasm:32768 [more modules...]
+ * Columns, in bytes of the file:
+ *   code     function bodies (code section)
+ *   data     initialized memory (data and data count sections)
+ *   imports  import section, with the number of imports
+ *   exports  export section, with the number of exports
+ *   custom   custom sections: names, producers, debug info
+ *   other    types, functions, table, memory, globals, elements, header
+ * A module over its budget, or one that is not a WASM module, makes the
+ * exit status 1. A budget of 0 reports without checking.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTION_CUSTOM 0
+#define SECTION_IMPORT 2
+#define SECTION_EXPORT 7
+#define SECTION_CODE 10
+#define SECTION_DATA 11
+#define SECTION_DATA_COUNT 12
+
+typedef struct {
+  uint64_t total;
+  uint64_t code;
+  uint64_t data;
+  uint64_t imports;
+  uint64_t exports;
+  uint64_t custom;
+  uint32_t import_count;
+  uint32_t export_count;
+} wasm_size_t;
+
+static bool read_leb(const uint8_t **at, const uint8_t *end, uint32_t *value) {
+  uint32_t result = 0;
+  for (int shift = 0; shift < 35 && *at < end; shift += 7) {
+    uint8_t byte = *(*at)++;
+    result |= (uint32_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint8_t *read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+  uint8_t *bytes = NULL;
+  if (fseek(file, 0, SEEK_END) == 0) {
+    long length = ftell(file);
+    if (length >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+      bytes = malloc(length > 0 ? (size_t)length : 1);
+      if (bytes && fread(bytes, 1, (size_t)length, file) != (size_t)length) {
+        free(bytes);
+        bytes = NULL;
+      }
+      *size = (size_t)length;
+    }
+  }
+  fclose(file);
+  return bytes;
+}
+
+// Whole sections, id and size header included
+static bool measure(const uint8_t *bytes, size_t size, wasm_size_t *out) {
+  static const uint8_t header[8] = {0x00, 'a', 's', 'm', 0x01, 0x00, 0x00, 0x00};
+  memset(out, 0, sizeof(*out));
+  out->total = size;
+  if (size < sizeof(header) || memcmp(bytes, header, sizeof(header)) != 0) {
+    return false;
+  }
+  const uint8_t *at = bytes + sizeof(header);
+  const uint8_t *end = bytes + size;
+  while (at < end) {
+    const uint8_t *start = at;
+    uint8_t id = *at++;
+    uint32_t length;
+    if (!read_leb(&at, end, &length) || length > (size_t)(end - at)) {
+      return false;
+    }
+    const uint8_t *body = at;
+    at += length;
+    uint64_t bytes_used = (uint64_t)(at - start);
+    switch (id) {
+    case SECTION_CUSTOM:
+      out->custom += bytes_used;
+      break;
+    case SECTION_IMPORT:
+      out->imports += bytes_used;
+      if (!read_leb(&body, at, &out->import_count)) {
+        return false;
+      }
+      break;
+    case SECTION_EXPORT:
+      out->exports += bytes_used;
+      if (!read_leb(&body, at, &out->export_count)) {
+        return false;
+      }
+      break;
+    case SECTION_CODE:
+      out->code += bytes_used;
+      break;
+    case SECTION_DATA:
+    case SECTION_DATA_COUNT:
+      out->data += bytes_used;
+      break;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: wasm-size module.wasm[:budget_bytes]...\n");
+    return 2;
+  }
+
+  bool ok = true;
+  printf("%-36s %8s %8s %8s %12s %12s %8s %8s %8s  %s\n",
+         "module", "total", "code", "data", "imports", "exports", "custom", "other", "budget", "result");
+  for (int i = 1; i < argc; i++) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s", argv[i]);
+    uint64_t budget = 0;
+    char *colon = strrchr(path, ':');
+    if (colon) {
+      *colon = '\0';
+      budget = strtoull(colon + 1, NULL, 10);
+    }
+
+    size_t size = 0;
+    uint8_t *bytes = read_file(path, &size);
+    wasm_size_t s;
+    if (!bytes || !measure(bytes, size, &s)) {
+      printf("%-36s %s\n", path, bytes ? "not a WASM module" : "cannot be read");
+      free(bytes);
+      ok = false;
+      continue;
+    }
+    free(bytes);
+
+    char imports[24], exports[24];
+    snprintf(imports, sizeof(imports), "%lu (%u)", (unsigned long)s.imports, s.import_count);
+    snprintf(exports, sizeof(exports), "%lu (%u)", (unsigned long)s.exports, s.export_count);
+    uint64_t other = s.total - s.code - s.data - s.imports - s.exports - s.custom;
+    const char *result = budget == 0 ? "-" : s.total <= budget ? "ok" : "OVER";
+    ok = ok && (budget == 0 || s.total <= budget);
+    printf("%-36s %8lu %8lu %8lu %12s %12s %8lu %8lu %8lu  %s\n", path, (unsigned long)s.total,
+           (unsigned long)s.code, (unsigned long)s.data, imports, exports, (unsigned long)s.custom,
+           (unsigned long)other, (unsigned long)budget, result);
+    if (budget && s.total > budget) {
+      printf("  %lu bytes over the budget\n", (unsigned long)(s.total - budget));
+    }
+  }
+  return ok ? 0 : 1;
+}